@@ -3,110 +3,493 @@
 #include <utility>
 #include <vector>
 #include <queue>
+#include <algorithm>
+#include <iterator>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include "NodeAllocator.h"
+#include "ThreadPool.h"
+#include "FrozenTree.h"
 /*
 AVL Tree
+Nodes come from the Alloc policy (see NodeAllocator.h)
+Every node also counts the keys in its subtree, which gives order statistics in O(log n):
+    select(k)         - the k-th smallest key, from 0
+    rank(key)         - how many keys are smaller than key
+    count_range(a, b) - how many keys lie in [a, b]
+In-order traversal uses bidirectional iterators that follow the parent links,
+so begin()/lower_bound() cost O(log n) and every step O(1) amortized - a
+range scan is O(log n + k) and allocates nothing.
+
+Trees are combined with join-based algorithms (Blelloch, Ferizovic & Sun,
+"Just Join for Parallel Ordered Sets"). join(L, k, R) links two trees whose
+heights differ arbitrarily through a middle key in O(|h(L) - h(R)|), and
+split(T, k) cuts a tree at a key in O(log n); union, intersection and
+difference recurse on (root of A, split of B at that root) and rejoin:
+O(m log(n/m + 1)) work for sizes m <= n, and the two recursive halves run
+in parallel on a ThreadPool above sequentialCutoff keys.
+The operand trees are consumed - their nodes are relinked into the result,
+which adopts their allocators, and duplicates are destroyed afterwards.
 */
 
-template <typename T>
+// Tag for the range constructor: the input is in no particular order and may repeat keys
+struct unsorted_t { explicit unsorted_t() = default; };
+inline constexpr unsorted_t unsorted{};
+
+template <typename T, template <typename> class Alloc = SlabAllocator>
 class AVLTree {
     class Node; // Nested class
     int size_;
+    Alloc<Node> alloc_;
     Node* root_;
 public:
+    class const_iterator;
+    using iterator = const_iterator; // keys are never modified in place - it would break the order
+
     AVLTree();
     AVLTree(const AVLTree& tree); // copy constructor
     AVLTree(AVLTree&& tree) noexcept;
+    // Perfectly balanced tree from a sorted range in O(n) - repeated keys are kept once
+    template <typename ForwardIt>
+    AVLTree(ForwardIt first, ForwardIt last);
+    // Copies, sorts (in parallel when given a pool) and deduplicates the range first
+    template <typename InputIt>
+    AVLTree(InputIt first, InputIt last, unsorted_t, ThreadPool* pool = nullptr);
     ~AVLTree();
 
-    AVLTree& operator=(AVLTree& rhs) noexcept;
+    AVLTree& operator=(AVLTree rhs) noexcept; // copy-and-swap - rhs is a copy or a moved-from tree
 
     void print() const;
 
+    const_iterator begin() const;
+    const_iterator end() const;
+    template <typename K>
+    const_iterator lower_bound(const K& key) const; // first key not less than key
+    template <typename K>
+    const_iterator upper_bound(const K& key) const; // first key greater than key
+    template <typename K>
+    std::pair<const_iterator, const_iterator> equal_range(const K& key) const;
+
+    FrozenTree<T> freeze() const { return FrozenTree<T>(begin(), end()); } // read-only pointer-free copy
+
     bool empty() const;
     int size() const;
     T* min();
     T* max();
 
-    T find(const T& key);
-    const T* find(const T& key) const;
-    
-    void push(T&& key); // support moving
-    void erase(const T& key);
+    const T* select(size_t k) const;
+    size_t rank(const T& key) const;
+    size_t count_range(const T& a, const T& b) const;
+
+    // every key of this tree must be smaller than every key of right
+    void join(AVLTree&& right);
+    // keeps the keys < key, returns the keys >= key - the returned tree shares
+    // this tree's allocator chunks, which live until both trees release them
+    AVLTree split(const T& key);
+
+    // in place; other is left empty. pool == nullptr runs sequentially
+    void unite(AVLTree&& other, ThreadPool* pool = nullptr);
+    void intersect(AVLTree&& other, ThreadPool* pool = nullptr);
+    void subtract(AVLTree&& other, ThreadPool* pool = nullptr);
+
+    // Keys are ordered with operator<, which is transparent: any K that compares
+    // with T both ways (e.g. std::string_view for std::string) is looked up as is
+    template <typename K>
+    T* find(const K& key);
+    template <typename K>
+    const T* find(const K& key) const;
+    template <typename K>
+    bool contains(const K& key) const { return find(key) != nullptr; }
+
+    // push/emplace/erase are iterative: they walk back up the parent links and stop
+    // rebalancing at the first subtree whose height did not change
+    bool push(T&& key); // support moving - false if the key is already present
+    bool push(const T& key);
+    template <typename... Args>
+    std::pair<T*, bool> emplace(Args&&... args); // constructs the key in its node
+    template <typename K>
+    bool erase(const K& key);
     void modifyKey(T&& newVal);
 };
 
-template <typename T>
-AVLTree<T>::AVLTree() :size_(0), root_(nullptr) {}
+template <typename T, template <typename> class Alloc>
+AVLTree<T, Alloc>::AVLTree() :size_(0), root_(nullptr) {}
 
-template <typename T>
-AVLTree<T>::AVLTree(const AVLTree& tree) :size_(tree.size_) {
-    if(tree.root_) {
-        root_ = new Node(*tree.root_);
-    } else {
-        root_ = nullptr;
-    }
+template <typename T, template <typename> class Alloc>
+AVLTree<T, Alloc>::AVLTree(const AVLTree& tree) :size_(tree.size_) {
+    root_ = Node::clone(tree.root_, nullptr, alloc_);
 }
 
-template <typename T>
-AVLTree<T>::AVLTree(AVLTree&& tree) noexcept : size_(tree.size_), root_(std::exchange(tree.root_, nullptr)) { } 
+template <typename T, template <typename> class Alloc>
+AVLTree<T, Alloc>::AVLTree(AVLTree&& tree) noexcept : size_(tree.size_), alloc_(std::move(tree.alloc_)), root_(std::exchange(tree.root_, nullptr)) { } 
 // std::exchange replaces old tree root with nullptr - returns rvalue ref to the root_ ptr
 
-template <typename T>
-AVLTree<T>& AVLTree<T>::operator=(AVLTree<T>& rhs) noexcept {
-    swap(*this, rhs); // dunk out the rhs - which won't be used
+template <typename T, template <typename> class Alloc>
+template <typename ForwardIt>
+AVLTree<T, Alloc>::AVLTree(ForwardIt first, ForwardIt last) : size_(0), root_(nullptr) {
+    // first pass: validate the order and count the distinct keys, so the shape is known up front
+    size_t n = 0;
+    for(ForwardIt prev = first, it = first; it != last; prev = it++) {
+        if(it == first || *prev < *it) {
+            n++;
+        } else if(*it < *prev) {
+            throw std::invalid_argument("EXCEPTION: AVL tree range constructor needs sorted keys!");
+        }
+    }
+    root_ = Node::build(first, last, n, alloc_);
+    size_ = static_cast<int>(n);
+}
+
+template <typename T, template <typename> class Alloc>
+template <typename InputIt>
+AVLTree<T, Alloc>::AVLTree(InputIt first, InputIt last, unsorted_t, ThreadPool* pool) : size_(0), root_(nullptr) {
+    std::vector<T> keys(first, last);
+    if(pool != nullptr) {
+        parallelSort(keys.begin(), keys.end(), *pool);
+    } else {
+        std::sort(keys.begin(), keys.end());
+    }
+    keys.erase(std::unique(keys.begin(), keys.end(), [](const T& a, const T& b) { return !(a < b); }), keys.end());
+    auto it = std::make_move_iterator(keys.begin());
+    root_ = Node::build(it, std::make_move_iterator(keys.end()), keys.size(), alloc_);
+    size_ = static_cast<int>(keys.size());
+}
+
+template <typename T, template <typename> class Alloc>
+AVLTree<T, Alloc>& AVLTree<T, Alloc>::operator=(AVLTree<T, Alloc> rhs) noexcept {
+    // dunk out the rhs - which won't be used
+    std::swap(size_, rhs.size_);
+    std::swap(alloc_, rhs.alloc_);
+    std::swap(root_, rhs.root_);
     return *this;
 }
 
-template <typename T>
-T* AVLTree<T>::min() {
-    return root_ ? root_->min() : nullptr;
+template <typename T, template <typename> class Alloc>
+bool AVLTree<T, Alloc>::empty() const {
+    return root_ == nullptr;
+}
+
+template <typename T, template <typename> class Alloc>
+int AVLTree<T, Alloc>::size() const {
+    return size_;
+}
+
+template <typename T, template <typename> class Alloc>
+T* AVLTree<T, Alloc>::min() {
+    return root_ ? root_->Min() : nullptr;
+}
+
+template <typename T, template <typename> class Alloc>
+T* AVLTree<T, Alloc>::max() {
+    return (root_ ? root_->Max() : nullptr);
 }
 
-template <typename T>
-T* AVLTree<T>::max() {
-    return (root_ ? root_->max() : nullptr);
+template <typename T, template <typename> class Alloc>
+AVLTree<T, Alloc>::~AVLTree() {
+    // iterative - or O(chunks) when nodes are trivially destructible
+    destroyBinaryTree(root_, alloc_, [](Node* x) { return x == nullptr; });
 }
 
-template <typename T>
-AVLTree<T>::~AVLTree() {
-    delete this->root_;
+template <typename T, template <typename> class Alloc>
+bool AVLTree<T, Alloc>::push(T&& key) {
+    return emplace(std::move(key)).second;
 }
 
-template <typename T>
-void AVLTree<T>::push(T&& key) {
-    Node::push(&root_, std::forward<T>(key));
+template <typename T, template <typename> class Alloc>
+bool AVLTree<T, Alloc>::push(const T& key) {
+    return emplace(key).second;
 }
 
-template <typename T>
-void AVLTree<T>::erase(const T& key) {
-    Node::erase(root_, key);
+template <typename T, template <typename> class Alloc>
+template <typename... Args>
+std::pair<T*, bool> AVLTree<T, Alloc>::emplace(Args&&... args) {
+    // the key is built in place first - it is the only T ever constructed
+    Node* x = alloc_.create(std::in_place, std::forward<Args>(args)...);
+    Node* parent = nullptr;
+    Node* curr = root_;
+    while(curr != nullptr) {
+        parent = curr;
+        if(x->key < curr->key) {
+            curr = curr->left;
+        } else if(curr->key < x->key) {
+            curr = curr->right;
+        } else {
+            alloc_.destroy(x); // prohibit identical elements
+            return {&curr->key, false};
+        }
+    }
+    x->parent = parent;
+    if(parent == nullptr) {
+        root_ = x;
+    } else if(x->key < parent->key) {
+        parent->left = x;
+    } else {
+        parent->right = x;
+    }
+    Node::retrace(&root_, parent, 1);
+    size_++;
+    return {&x->key, true};
 }
 
-template <typename T>
-void AVLTree<T>::print() const {
+template <typename T, template <typename> class Alloc>
+template <typename K>
+bool AVLTree<T, Alloc>::erase(const K& key) {
+    Node* z = Node::find(root_, key);
+    if(z == nullptr) {
+        return false;
+    }
+    Node::retrace(&root_, Node::unlink(&root_, z), -1);
+    alloc_.destroy(z);
+    size_--;
+    return true;
+}
+
+template <typename T, template <typename> class Alloc>
+template <typename K>
+T* AVLTree<T, Alloc>::find(const K& key) {
+    Node* x = Node::find(root_, key);
+    return x ? &x->key : nullptr;
+}
+
+template <typename T, template <typename> class Alloc>
+template <typename K>
+const T* AVLTree<T, Alloc>::find(const K& key) const {
+    const Node* x = Node::find(static_cast<const Node*>(root_), key);
+    return x ? &x->key : nullptr;
+}
+
+template <typename T, template <typename> class Alloc>
+void AVLTree<T, Alloc>::print() const {
     if(!this->root_) {
         std::cout << "Tree is empty\n";
     }
     std::cout << Node::print(root_);
 }
 
+template <typename T, template <typename> class Alloc>
+const T* AVLTree<T, Alloc>::select(size_t k) const {
+    return Node::select(root_, k);
+}
+
+template <typename T, template <typename> class Alloc>
+size_t AVLTree<T, Alloc>::rank(const T& key) const {
+    return Node::countBelow(root_, key, false);
+}
+
+template <typename T, template <typename> class Alloc>
+size_t AVLTree<T, Alloc>::count_range(const T& a, const T& b) const {
+    if(b < a) {
+        return 0;
+    }
+    return Node::countBelow(root_, b, true) - Node::countBelow(root_, a, false);
+}
+
+template <typename T, template <typename> class Alloc>
+void AVLTree<T, Alloc>::join(AVLTree&& right) {
+    if(right.root_ == nullptr) {
+        return;
+    }
+    if(root_ != nullptr && !(*max() < *right.min())) {
+        throw std::invalid_argument("EXCEPTION: join needs every key of the left tree below every key of the right tree!");
+    }
+    alloc_.adopt(right.alloc_);
+    root_ = Node::join2(root_, std::exchange(right.root_, nullptr));
+    size_ = static_cast<int>(Node::count(root_));
+    right.size_ = 0;
+}
+
+template <typename T, template <typename> class Alloc>
+AVLTree<T, Alloc> AVLTree<T, Alloc>::split(const T& key) {
+    typename Node::Split parts = Node::split(root_, key);
+    AVLTree right;
+    right.alloc_.share(alloc_);
+    if(parts.found != nullptr) {
+        parts.right = Node::join(nullptr, parts.found, parts.right); // the key itself goes right
+    }
+    root_ = parts.left;
+    right.root_ = parts.right;
+    size_ = static_cast<int>(Node::count(root_));
+    right.size_ = static_cast<int>(Node::count(right.root_));
+    return right;
+}
+
+template <typename T, template <typename> class Alloc>
+void AVLTree<T, Alloc>::unite(AVLTree&& other, ThreadPool* pool) {
+    std::vector<Node*> dropped;
+    alloc_.adopt(other.alloc_);
+    root_ = Node::unite(root_, std::exchange(other.root_, nullptr), dropped, pool);
+    for(Node* x : dropped) {
+        alloc_.destroy(x);
+    }
+    size_ = static_cast<int>(Node::count(root_));
+    other.size_ = 0;
+}
+
+template <typename T, template <typename> class Alloc>
+void AVLTree<T, Alloc>::intersect(AVLTree&& other, ThreadPool* pool) {
+    std::vector<Node*> dropped;
+    alloc_.adopt(other.alloc_);
+    root_ = Node::intersect(root_, std::exchange(other.root_, nullptr), dropped, pool);
+    for(Node* x : dropped) {
+        alloc_.destroy(x);
+    }
+    size_ = static_cast<int>(Node::count(root_));
+    other.size_ = 0;
+}
+
+template <typename T, template <typename> class Alloc>
+void AVLTree<T, Alloc>::subtract(AVLTree&& other, ThreadPool* pool) {
+    std::vector<Node*> dropped;
+    alloc_.adopt(other.alloc_);
+    root_ = Node::subtract(root_, std::exchange(other.root_, nullptr), dropped, pool);
+    for(Node* x : dropped) {
+        alloc_.destroy(x);
+    }
+    size_ = static_cast<int>(Node::count(root_));
+    other.size_ = 0;
+}
+
+// Set operations on whole trees - pass std::move(tree) to consume an operand instead of copying it
+template <typename T, template <typename> class Alloc>
+AVLTree<T, Alloc> set_union(AVLTree<T, Alloc> a, AVLTree<T, Alloc> b, ThreadPool* pool = nullptr) {
+    a.unite(std::move(b), pool);
+    return a;
+}
+
+template <typename T, template <typename> class Alloc>
+AVLTree<T, Alloc> set_intersection(AVLTree<T, Alloc> a, AVLTree<T, Alloc> b, ThreadPool* pool = nullptr) {
+    a.intersect(std::move(b), pool);
+    return a;
+}
+
+template <typename T, template <typename> class Alloc>
+AVLTree<T, Alloc> set_difference(AVLTree<T, Alloc> a, AVLTree<T, Alloc> b, ThreadPool* pool = nullptr) {
+    a.subtract(std::move(b), pool);
+    return a;
+}
+
+/*
+In-order iterator - end() is a null node, and stepping back from it finds the maximum through the tree
+*/
+template <typename T, template <typename> class Alloc>
+class AVLTree<T, Alloc>::const_iterator {
+    friend class AVLTree;
+    const Node* node;
+    const AVLTree* tree;
+    const_iterator(const Node* node, const AVLTree* tree) : node(node), tree(tree) {}
+public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+    const_iterator() : node(nullptr), tree(nullptr) {}
+
+    reference operator*() const { return node->key; }
+    pointer operator->() const { return &node->key; }
+
+    const_iterator& operator++() {
+        node = Node::successor(node);
+        return *this;
+    }
+    const_iterator operator++(int) {
+        const_iterator old = *this;
+        ++*this;
+        return old;
+    }
+    const_iterator& operator--() {
+        node = node ? Node::predecessor(node) : Node::rightmost(tree->root_);
+        return *this;
+    }
+    const_iterator operator--(int) {
+        const_iterator old = *this;
+        --*this;
+        return old;
+    }
+
+    bool operator==(const const_iterator& rhs) const { return node == rhs.node; }
+    bool operator!=(const const_iterator& rhs) const { return node != rhs.node; }
+};
+
+template <typename T, template <typename> class Alloc>
+typename AVLTree<T, Alloc>::const_iterator AVLTree<T, Alloc>::begin() const {
+    return const_iterator(root_ ? Node::leftmost(root_) : nullptr, this);
+}
+
+template <typename T, template <typename> class Alloc>
+typename AVLTree<T, Alloc>::const_iterator AVLTree<T, Alloc>::end() const {
+    return const_iterator(nullptr, this);
+}
+
+template <typename T, template <typename> class Alloc>
+template <typename K>
+typename AVLTree<T, Alloc>::const_iterator AVLTree<T, Alloc>::lower_bound(const K& key) const {
+    const Node* bound = nullptr;
+    const Node* curr = root_;
+    while(curr != nullptr) {
+        if(curr->key < key) {
+            curr = curr->right;
+        } else {
+            bound = curr; // candidate - look for a smaller one on the left
+            curr = curr->left;
+        }
+    }
+    return const_iterator(bound, this);
+}
+
+template <typename T, template <typename> class Alloc>
+template <typename K>
+typename AVLTree<T, Alloc>::const_iterator AVLTree<T, Alloc>::upper_bound(const K& key) const {
+    const Node* bound = nullptr;
+    const Node* curr = root_;
+    while(curr != nullptr) {
+        if(key < curr->key) {
+            bound = curr;
+            curr = curr->left;
+        } else {
+            curr = curr->right;
+        }
+    }
+    return const_iterator(bound, this);
+}
+
+template <typename T, template <typename> class Alloc>
+template <typename K>
+std::pair<typename AVLTree<T, Alloc>::const_iterator, typename AVLTree<T, Alloc>::const_iterator>
+AVLTree<T, Alloc>::equal_range(const K& key) const {
+    // keys are unique - the range is the key's node, if any
+    const_iterator first = lower_bound(key);
+    if(first == end() || key < *first) {
+        return {first, first};
+    }
+    return {first, std::next(first)};
+}
+
 /*
 AVL Tree Node
 */
 
-template <typename T>
-class AVLTree<T>::Node {
+template <typename T, template <typename> class Alloc>
+class AVLTree<T, Alloc>::Node {
+    template <typename N, typename A, typename IsNull>
+    friend void destroyBinaryTree(N* node, A& alloc, IsNull isNull);
+    friend class AVLTree; // push/emplace/find work on the links directly
     T key;
     Node* left;
     Node* right;
     Node* parent;
     short height_;
     short balance_factor;
+    uint32_t count_; // keys in this subtree - sits in what used to be tail padding, see updateParams()
 public:
     Node(const T& key, Node* parent=nullptr); // default value of parent is nullptr (e.g. for root)
-    Node(const T&& key, Node* parent=nullptr); // rvalue ref constructor
-    ~Node();
-    Node(const Node& node); // copy constructor
+    Node(T&& key, Node* parent=nullptr); // rvalue ref constructor
+    template <typename... Args>
+    Node(std::in_place_t, Args&&... args); // the key is constructed from args
+    Node(const Node& node) = delete; // subtrees are copied with clone()
     Node(Node&& node) noexcept; // move constrcutor (optimized with noexcept)
 
     Node& operator=(const Node& node) = delete; // protect against copy assignment
@@ -116,104 +499,244 @@ public:
     T* Max();
     
     static std::string print(Node* curr);
-    static T* Find(Node* curr, const T& key);
-    static const T* Find(const Node* curr, const T& key);
+    template <typename N, typename K>
+    static N* find(N* curr, const K& key); // N is Node or const Node
     int depth();
-    Node& predecessor();
-    Node& successor();
+    static const Node* predecessor(const Node* curr);
+    static const Node* successor(const Node* curr);
+    static const Node* leftmost(const Node* curr);
+    static const Node* rightmost(const Node* curr);
 
     // static methods for push/erase - no overhead for objects
     // Hence, they will run faster!
-    static void push(Node** curr, T&& key, Node* parent=nullptr);
-    static void erase(Node* curr, const T& key);
+    static void transplant(Node** root, Node* u, Node* v);
+    static Node* unlink(Node** root, Node* z); // takes z out of the tree, returns the lowest node whose subtree changed
+    static void retrace(Node** root, Node* curr, int delta); // rebalance from curr up after delta keys were added
     static void balanceSubtree(Node** node);
+    static Node* clone(const Node* curr, Node* parent, Alloc<Node>& alloc); // deep copy
+
+    static size_t count(const Node* curr) { return curr ? curr->count_ : 0; }
+    static const T* select(const Node* curr, size_t k); // k-th smallest key in the subtree, from 0
+    static size_t countBelow(const Node* curr, const T& key, bool inclusive); // keys < key (or <= key)
+
+    // join-based operations - every Node* argument and result is a whole tree (parent == nullptr)
+    struct Split {
+        Node* left; // keys < key
+        Node* found; // the node holding key, detached - or nullptr
+        Node* right; // keys > key
+    };
+    static constexpr size_t sequentialCutoff = 1 << 12;
+    static int height(const Node* curr) { return curr ? curr->height_ : -1; }
+    static Node* join(Node* l, Node* k, Node* r); // every key of l < k->key < every key of r
+    static Node* join2(Node* l, Node* r); // join without a middle key
+    static Split split(Node* curr, const T& key);
+    template <typename It>
+    static Node* build(It& it, It last, size_t n, Alloc<Node>& alloc); // from sorted keys
+    static Node* unite(Node* a, Node* b, std::vector<Node*>& dropped, ThreadPool* pool);
+    static Node* intersect(Node* a, Node* b, std::vector<Node*>& dropped, ThreadPool* pool);
+    static Node* subtract(Node* a, Node* b, std::vector<Node*>& dropped, ThreadPool* pool);
 private:
     void updateParams();
     void RotateLeft(Node* x);
     void RotateRight(Node* x);
+
+    static Node* detach(Node* curr);
+    static Node* link(Node* l, Node* k, Node* r);
+    static Node* rotatedLeft(Node* x);
+    static Node* rotatedRight(Node* x);
+    static Node* joinRight(Node* l, Node* k, Node* r);
+    static Node* joinLeft(Node* l, Node* k, Node* r);
+    static Node* splitLast(Node* curr, Node** last);
+    static void dropAll(Node* curr, std::vector<Node*>& dropped);
+    template <typename F, typename G>
+    static void recurse(ThreadPool* pool, size_t work, std::vector<Node*>& dropped, F&& left, G&& right);
 };
 
-template <typename T>
-AVLTree<T>::Node::Node(const T& key, Node* parent) : 
-    key(key), height_(0), balance_factor(0), left(nullptr), right(nullptr), parent(parent) {}
+template <typename T, template <typename> class Alloc>
+AVLTree<T, Alloc>::Node::Node(const T& key, Node* parent) : 
+    key(key), left(nullptr), right(nullptr), parent(parent), height_(0), balance_factor(0), count_(1) {}
 
-template <typename T>
-AVLTree<T>::Node::Node(const T&& key, Node* parent) : // rvalue reference overloaded constructor
-    key(std::move(key)), height_(0), balance_factor(0), left(nullptr), right(nullptr), parent(parent) {}
+template <typename T, template <typename> class Alloc>
+AVLTree<T, Alloc>::Node::Node(T&& key, Node* parent) : // rvalue reference overloaded constructor
+    key(std::move(key)), left(nullptr), right(nullptr), parent(parent), height_(0), balance_factor(0), count_(1) {}
 
-template <typename T>
-AVLTree<T>::Node::Node(const Node& rhs) {
-    left = rhs.left ? new Node(*rhs.left) : nullptr;
-    right = rhs.right? new Node(*rhs.right) : nullptr;
-    parent = rhs.parent; // will point to same address instead
-    key = rhs.key;
-    height_ = rhs.height_;
-    balance_factor = rhs.balance_factor;
+template <typename T, template <typename> class Alloc>
+template <typename... Args>
+AVLTree<T, Alloc>::Node::Node(std::in_place_t, Args&&... args) :
+    key(std::forward<Args>(args)...), left(nullptr), right(nullptr), parent(nullptr), height_(0), balance_factor(0), count_(1) {}
+
+template <typename T, template <typename> class Alloc>
+typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::Node::clone(const Node* curr, Node* parent, Alloc<Node>& alloc) {
+    if(curr == nullptr) {
+        return nullptr;
+    }
+    Node* copy = alloc.create(curr->key, parent);
+    copy->height_ = curr->height_;
+    copy->balance_factor = curr->balance_factor;
+    copy->count_ = curr->count_;
+    copy->left = clone(curr->left, copy, alloc); // recursion depth is the height - O(log n)
+    copy->right = clone(curr->right, copy, alloc);
+    return copy;
 }
 
-template <typename T>
-AVLTree<T>::Node::Node(Node&& rhs) noexcept : height_(rhs.height_), balance_factor(rhs.balance_factor), left(std::exchange(rhs.left, nullptr)), right(std::exchange(rhs.right, nullptr)), parent(std::exchange(rhs.parent, nullptr)) { } // move constructor
+template <typename T, template <typename> class Alloc>
+AVLTree<T, Alloc>::Node::Node(Node&& rhs) noexcept : left(std::exchange(rhs.left, nullptr)), right(std::exchange(rhs.right, nullptr)), parent(std::exchange(rhs.parent, nullptr)), height_(rhs.height_), balance_factor(rhs.balance_factor), count_(std::exchange(rhs.count_, 1)) { } // move constructor
 
-template <typename T>
-AVLTree<T>::Node::~Node() {
-    delete left;
-    delete right;
+template <typename T, template <typename> class Alloc>
+template <typename N, typename K>
+N* AVLTree<T, Alloc>::Node::find(N* curr, const K& key) {
+    while(curr != nullptr) {
+        if(key < curr->key) {
+            curr = curr->left;
+        } else if(curr->key < key) {
+            curr = curr->right;
+        } else {
+            return curr;
+        }
+    }
+    return nullptr;
 }
 
-template <typename T>
-void AVLTree<T>::Node::push(Node** curr, T&& key, Node* parent) {
-    if(*curr == nullptr) {
-        *curr = new Node(std::forward<T>(key), parent);
-        return;
-    }
-    if(key < (*curr)->key) {
-        push(&(*curr)->left, std::forward<T>(key), *curr);
-    } else if(key > (*curr)->key) {
-        push(&(*curr)->right, std::forward<T>(key), *curr);
+// Puts v where u was, as far as u's parent (or the root) is concerned
+template <typename T, template <typename> class Alloc>
+void AVLTree<T, Alloc>::Node::transplant(Node** root, Node* u, Node* v) {
+    if(u->parent == nullptr) {
+        *root = v;
+    } else if(u == u->parent->left) {
+        u->parent->left = v;
     } else {
-        return; // prohibit identical elements
+        u->parent->right = v;
+    }
+    if(v != nullptr) {
+        v->parent = u->parent;
+    }
+}
+
+// Nodes are relinked rather than keys moved, so pointers to the other keys stay valid
+template <typename T, template <typename> class Alloc>
+typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::Node::unlink(Node** root, Node* z) {
+    if(z->left == nullptr || z->right == nullptr) {
+        transplant(root, z, z->left ? z->left : z->right);
+        return z->parent;
+    }
+    // two children - the successor y (no left child) takes z's place
+    Node* y = z->right;
+    while(y->left != nullptr) {
+        y = y->left;
+    }
+    Node* changed = y;
+    if(y->parent != z) {
+        changed = y->parent;
+        transplant(root, y, y->right);
+        y->right = z->right;
+        y->right->parent = y;
+    }
+    transplant(root, z, y);
+    y->left = z->left;
+    y->left->parent = y;
+    // y inherits z's bookkeeping; the retrace fixes whatever changed below
+    y->height_ = z->height_;
+    y->balance_factor = z->balance_factor;
+    y->count_ = z->count_;
+    return changed;
+}
+
+template <typename T, template <typename> class Alloc>
+void AVLTree<T, Alloc>::Node::retrace(Node** root, Node* curr, int delta) {
+    while(curr != nullptr) {
+        short before = curr->height_;
+        Node* sub = curr;
+        balanceSubtree(&sub);
+        if(sub->parent == nullptr) {
+            *root = sub;
+        }
+        if(sub->height_ == before) {
+            // the subtrees above keep their shape - only their counts move
+            for(Node* a = sub->parent; a != nullptr; a = a->parent) {
+                a->count_ += delta;
+            }
+            return;
+        }
+        curr = sub->parent;
     }
-    // balance is called at multiple levels, lowest to highest (or deepest first)
-    balanceSubtree(curr);
 }
 
-template <typename T>
-void AVLTree<T>::Node::balanceSubtree(Node** node) {
+template <typename T, template <typename> class Alloc>
+void AVLTree<T, Alloc>::Node::balanceSubtree(Node** node) {
     (*node)->updateParams();
     int balance = (*node)->balance_factor;
+    Node* x = *node;
 
     if(balance > 1) { // left-heavy
-        if((*node)->left->balance_factor >= 0) { // left-left balance
-            (*node)->RotateRight(*node);
+        if(x->left->balance_factor >= 0) { // left-left balance
+            x->RotateRight(x);
         } 
         else {
-            (*node)->RotateLeft((*node)->left); // left-right balance
-            (*node)->RotateRight(*node);
+            x->RotateLeft(x->left); // left-right balance
+            x->RotateRight(x);
         }
+        *node = x->parent; // the root slot is not relinked by the rotations
     } 
     else if(balance < -1) { // Right-heavy
-        if ((*node)->right->balance_factor <= 0) {
-            (*node)->RotateLeft(*node);
+        if (x->right->balance_factor <= 0) {
+            x->RotateLeft(x);
         }
         // Right-Left case: Perform a right rotation followed by a left rotation
         else {
-            (*node)->RotateRight((*node)->right);
-            (*node)->RotateLeft(*node);
+            x->RotateRight(x->right);
+            x->RotateLeft(x);
         }
+        *node = x->parent;
     }
 }
 
-template <typename T>
-void AVLTree<T>::Node::updateParams() {
-    // update height_ + balance factor
+template <typename T, template <typename> class Alloc>
+void AVLTree<T, Alloc>::Node::updateParams() {
+    // The count shares the 8 bytes after the pointers with height_ and balance_factor,
+    // so a node is no bigger than it was without it (40 bytes for int keys)
+    struct Unaugmented { T key; Node* left; Node* right; Node* parent; short height_; short balance_factor; };
+    static_assert(sizeof(Node) == sizeof(Unaugmented), "subtree count must not grow the node");
+
+    // update height_ + balance factor + subtree count
     int left_height = (left != nullptr ? this->left->height_ : -1);
     int right_height = (right != nullptr ? this->right->height_ : -1);
     height_ = std::max(left_height, right_height) + 1;
     balance_factor = left_height - right_height;
+    count_ = static_cast<uint32_t>(count(left) + count(right) + 1);
+}
+
+template <typename T, template <typename> class Alloc>
+const T* AVLTree<T, Alloc>::Node::select(const Node* curr, size_t k) {
+    while(curr != nullptr) {
+        size_t left = count(curr->left);
+        if(k < left) {
+            curr = curr->left;
+        } else if(k > left) {
+            k -= left + 1; // skip the left subtree and this node
+            curr = curr->right;
+        } else {
+            return &curr->key;
+        }
+    }
+    return nullptr; // k >= size()
+}
+
+template <typename T, template <typename> class Alloc>
+size_t AVLTree<T, Alloc>::Node::countBelow(const Node* curr, const T& key, bool inclusive) {
+    size_t below = 0;
+    while(curr != nullptr) {
+        if(curr->key < key || (inclusive && !(key < curr->key))) {
+            below += count(curr->left) + 1; // this node and its whole left subtree
+            curr = curr->right;
+        } else {
+            curr = curr->left;
+        }
+    }
+    return below;
 }
 
-template <typename T>
-std::string AVLTree<T>::Node::print(Node* curr) { // can print tree or subtree!
+template <typename T, template <typename> class Alloc>
+std::string AVLTree<T, Alloc>::Node::print(Node* curr) { // can print tree or subtree!
     std::string tree_str = "";
     std::queue<std::pair<Node*, int>> q;
     q.push({curr, 0});
@@ -234,8 +757,8 @@ std::string AVLTree<T>::Node::print(Node* curr) { // can print tree or subtree!
     return tree_str;
 }
 
-template <typename T>
-void AVLTree<T>::Node::RotateRight(Node* x) {
+template <typename T, template <typename> class Alloc>
+void AVLTree<T, Alloc>::Node::RotateRight(Node* x) {
     Node* y = x->left;
     x->left = y->right;
     if (y->right != nullptr) {
@@ -251,12 +774,12 @@ void AVLTree<T>::Node::RotateRight(Node* x) {
     }
     y->right = x;
     x->parent = y;
-    updateParams();
+    x->updateParams();
     y->updateParams();
 }
 
-template <typename T>
-void AVLTree<T>::Node::RotateLeft(Node* x) {
+template <typename T, template <typename> class Alloc>
+void AVLTree<T, Alloc>::Node::RotateLeft(Node* x) {
     Node* y = x->right;
     x->right = y->left;
     if (y->left != nullptr) {
@@ -272,6 +795,290 @@ void AVLTree<T>::Node::RotateLeft(Node* x) {
     }
     y->left = x;
     x->parent = y;
-    updateParams();
+    x->updateParams();
     y->updateParams();
-}
\ No newline at end of file
+}
+
+template <typename T, template <typename> class Alloc>
+T* AVLTree<T, Alloc>::Node::Min() {
+    Node* curr = this;
+    while(curr->left != nullptr) {
+        curr = curr->left;
+    }
+    return &curr->key;
+}
+
+template <typename T, template <typename> class Alloc>
+T* AVLTree<T, Alloc>::Node::Max() {
+    Node* curr = this;
+    while(curr->right != nullptr) {
+        curr = curr->right;
+    }
+    return &curr->key;
+}
+
+template <typename T, template <typename> class Alloc>
+typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::Node::detach(Node* curr) {
+    if(curr != nullptr) {
+        curr->parent = nullptr;
+    }
+    return curr;
+}
+
+// Makes k the root of l and r - the caller guarantees the heights are within one
+template <typename T, template <typename> class Alloc>
+typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::Node::link(Node* l, Node* k, Node* r) {
+    k->left = l;
+    k->right = r;
+    k->parent = nullptr;
+    if(l != nullptr) l->parent = k;
+    if(r != nullptr) r->parent = k;
+    k->updateParams();
+    return k;
+}
+
+template <typename T, template <typename> class Alloc>
+typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::Node::rotatedLeft(Node* x) {
+    Node* y = x->right;
+    return link(link(x->left, x, y->left), y, y->right);
+}
+
+template <typename T, template <typename> class Alloc>
+typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::Node::rotatedRight(Node* x) {
+    Node* y = x->left;
+    return link(y->left, y, link(y->right, x, x->right));
+}
+
+// l is more than one level taller: walk down l's right spine to a subtree
+// of r's height, link there, and rotate on the way back up where needed
+template <typename T, template <typename> class Alloc>
+typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::Node::joinRight(Node* l, Node* k, Node* r) {
+    Node* ll = l->left;
+    Node* c = detach(l->right);
+    if(height(c) <= height(r) + 1) {
+        Node* t = link(c, k, r);
+        if(height(t) <= height(ll) + 1) {
+            return link(ll, l, t);
+        }
+        return rotatedLeft(link(ll, l, rotatedRight(t))); // double rotation
+    }
+    Node* t = joinRight(c, k, r);
+    Node* joined = link(ll, l, t);
+    return height(t) <= height(ll) + 1 ? joined : rotatedLeft(joined);
+}
+
+template <typename T, template <typename> class Alloc>
+typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::Node::joinLeft(Node* l, Node* k, Node* r) {
+    Node* rr = r->right;
+    Node* c = detach(r->left);
+    if(height(c) <= height(l) + 1) {
+        Node* t = link(l, k, c);
+        if(height(t) <= height(rr) + 1) {
+            return link(t, r, rr);
+        }
+        return rotatedRight(link(rotatedLeft(t), r, rr));
+    }
+    Node* t = joinLeft(l, k, c);
+    Node* joined = link(t, r, rr);
+    return height(t) <= height(rr) + 1 ? joined : rotatedRight(joined);
+}
+
+template <typename T, template <typename> class Alloc>
+typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::Node::join(Node* l, Node* k, Node* r) {
+    if(height(l) > height(r) + 1) {
+        return joinRight(l, k, r);
+    }
+    if(height(r) > height(l) + 1) {
+        return joinLeft(l, k, r);
+    }
+    return link(l, k, r);
+}
+
+// Removes the largest node of curr into *last, returns the rest
+template <typename T, template <typename> class Alloc>
+typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::Node::splitLast(Node* curr, Node** last) {
+    if(curr->right == nullptr) {
+        *last = curr;
+        return detach(curr->left);
+    }
+    Node* rest = splitLast(detach(curr->right), last);
+    return join(detach(curr->left), curr, rest);
+}
+
+template <typename T, template <typename> class Alloc>
+typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::Node::join2(Node* l, Node* r) {
+    if(l == nullptr) {
+        return r;
+    }
+    Node* last;
+    Node* rest = splitLast(l, &last);
+    return join(rest, last, r);
+}
+
+template <typename T, template <typename> class Alloc>
+typename AVLTree<T, Alloc>::Node::Split AVLTree<T, Alloc>::Node::split(Node* curr, const T& key) {
+    if(curr == nullptr) {
+        return {nullptr, nullptr, nullptr};
+    }
+    Node* l = detach(curr->left);
+    Node* r = detach(curr->right);
+    if(key < curr->key) {
+        Split parts = split(l, key);
+        parts.right = join(parts.right, curr, r);
+        return parts;
+    }
+    if(curr->key < key) {
+        Split parts = split(r, key);
+        parts.left = join(l, curr, parts.left);
+        return parts;
+    }
+    curr->left = curr->right = nullptr;
+    curr->updateParams();
+    return {l, curr, r};
+}
+
+template <typename T, template <typename> class Alloc>
+void AVLTree<T, Alloc>::Node::dropAll(Node* curr, std::vector<Node*>& dropped) {
+    if(curr == nullptr) {
+        return;
+    }
+    dropAll(curr->left, dropped);
+    dropAll(curr->right, dropped);
+    dropped.push_back(curr);
+}
+
+// Runs the two recursive halves - as a fork on the pool when there is enough work.
+// A forked right half collects its dropped nodes separately, spliced in afterwards.
+template <typename T, template <typename> class Alloc>
+template <typename F, typename G>
+void AVLTree<T, Alloc>::Node::recurse(ThreadPool* pool, size_t work, std::vector<Node*>& dropped, F&& left, G&& right) {
+    if(pool == nullptr || pool->size() == 1 || work < sequentialCutoff) {
+        left(dropped);
+        right(dropped);
+        return;
+    }
+    std::vector<Node*> droppedRight;
+    pool->invoke([&] { left(dropped); }, [&] { right(droppedRight); });
+    dropped.insert(dropped.end(), droppedRight.begin(), droppedRight.end());
+}
+
+template <typename T, template <typename> class Alloc>
+typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::Node::unite(Node* a, Node* b, std::vector<Node*>& dropped, ThreadPool* pool) {
+    if(a == nullptr) return b;
+    if(b == nullptr) return a;
+    size_t work = count(a) + count(b);
+    Node* l1 = detach(a->left);
+    Node* r1 = detach(a->right);
+    Split parts = split(b, a->key);
+    if(parts.found != nullptr) {
+        dropped.push_back(parts.found); // a's copy of the key is kept
+    }
+    Node *l, *r;
+    recurse(pool, work, dropped,
+        [&](std::vector<Node*>& d) { l = unite(l1, parts.left, d, pool); },
+        [&](std::vector<Node*>& d) { r = unite(r1, parts.right, d, pool); });
+    return join(l, a, r);
+}
+
+template <typename T, template <typename> class Alloc>
+typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::Node::intersect(Node* a, Node* b, std::vector<Node*>& dropped, ThreadPool* pool) {
+    if(a == nullptr || b == nullptr) {
+        dropAll(a, dropped);
+        dropAll(b, dropped);
+        return nullptr;
+    }
+    size_t work = count(a) + count(b);
+    Node* l1 = detach(a->left);
+    Node* r1 = detach(a->right);
+    Split parts = split(b, a->key);
+    Node *l, *r;
+    recurse(pool, work, dropped,
+        [&](std::vector<Node*>& d) { l = intersect(l1, parts.left, d, pool); },
+        [&](std::vector<Node*>& d) { r = intersect(r1, parts.right, d, pool); });
+    if(parts.found != nullptr) {
+        dropped.push_back(parts.found);
+        return join(l, a, r);
+    }
+    dropped.push_back(a);
+    return join2(l, r);
+}
+
+template <typename T, template <typename> class Alloc>
+typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::Node::subtract(Node* a, Node* b, std::vector<Node*>& dropped, ThreadPool* pool) {
+    if(a == nullptr || b == nullptr) {
+        dropAll(b, dropped);
+        return a;
+    }
+    size_t work = count(a) + count(b);
+    Node* l2 = detach(b->left);
+    Node* r2 = detach(b->right);
+    Split parts = split(a, b->key);
+    dropped.push_back(b);
+    if(parts.found != nullptr) {
+        dropped.push_back(parts.found);
+    }
+    Node *l, *r;
+    recurse(pool, work, dropped,
+        [&](std::vector<Node*>& d) { l = subtract(parts.left, l2, d, pool); },
+        [&](std::vector<Node*>& d) { r = subtract(parts.right, r2, d, pool); });
+    return join2(l, r);
+}
+
+// Builds the next n distinct keys of a sorted sequence in order: left subtree,
+// then the node, then the right subtree. Halving n at every level makes the
+// tree perfectly balanced, and heights and counts are set as each node closes.
+template <typename T, template <typename> class Alloc>
+template <typename It>
+typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::Node::build(It& it, It last, size_t n, Alloc<Node>& alloc) {
+    if(n == 0) {
+        return nullptr;
+    }
+    size_t leftSize = (n - 1) / 2;
+    Node* l = build(it, last, leftSize, alloc);
+    Node* x = alloc.create(*it);
+    do {
+        ++it; // skip repeats of the key just taken
+    } while(it != last && !(x->key < *it));
+    Node* r = build(it, last, n - leftSize - 1, alloc);
+    return link(l, x, r);
+}
+
+template <typename T, template <typename> class Alloc>
+const typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::Node::leftmost(const Node* curr) {
+    while(curr->left != nullptr) {
+        curr = curr->left;
+    }
+    return curr;
+}
+
+template <typename T, template <typename> class Alloc>
+const typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::Node::rightmost(const Node* curr) {
+    while(curr->right != nullptr) {
+        curr = curr->right;
+    }
+    return curr;
+}
+
+// Next node in order: the leftmost of the right subtree, or else the first
+// ancestor reached from its left side - nullptr past the maximum
+template <typename T, template <typename> class Alloc>
+const typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::Node::successor(const Node* curr) {
+    if(curr->right != nullptr) {
+        return leftmost(curr->right);
+    }
+    while(curr->parent != nullptr && curr == curr->parent->right) {
+        curr = curr->parent;
+    }
+    return curr->parent;
+}
+
+template <typename T, template <typename> class Alloc>
+const typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::Node::predecessor(const Node* curr) {
+    if(curr->left != nullptr) {
+        return rightmost(curr->left);
+    }
+    while(curr->parent != nullptr && curr == curr->parent->left) {
+        curr = curr->parent;
+    }
+    return curr->parent;
+}
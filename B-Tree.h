@@ -1,99 +1,90 @@
+#pragma once
 #include <iostream>
 #include <vector>
 #include <queue>
 #include <utility>
+#include <array>
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include "NodeSearch.h"
+#include "NodeAllocator.h"
+#include "BTreeStats.h"
+#include "FrozenTree.h"
 
 // Forward declare BTree for node access
-template <typename T>
+// Degree == 0 -> degree t chosen at runtime (vector-backed nodes)
+// Degree > 0  -> fixed-capacity nodes with inline key/child arrays
+// Alloc      -> node allocator policy (see NodeAllocator.h)
+// Stats      -> statistics policy, NoStats or CountingStats (see BTreeStats.h)
+template <typename T, size_t Degree = 0, template <typename> class Alloc = SlabAllocator, typename Stats = NoStats>
 class BTree;
 
+// Nodes are reference counted and shared copy-on-write between a tree and
+// its snapshots: a page is only modified in place while its count is 1.
+// Pages are created and freed by the tree's allocator, never by each other.
 template <typename T>
 class BTreeNode {
-    friend class BTree<T>;
+    template <typename, size_t, template <typename> class, typename> friend class BTree;
 public:
-    // Rule of 5 class!
     BTreeNode();
-    ~BTreeNode();
-    BTreeNode(BTreeNode<T>& node);
+    BTreeNode(const BTreeNode<T>& node); // copies one page, sharing its children
     BTreeNode(BTreeNode<T>&& node) noexcept;
-    BTreeNode& operator=(BTreeNode<T>& rhs);
-    BTreeNode& operator=(BTreeNode<T>&& rhs) noexcept;
+    BTreeNode& operator=(const BTreeNode<T>& rhs) = delete;
+    BTreeNode& operator=(BTreeNode<T>&& rhs) = delete;
     const T& operator[](size_t i);
+
+    static BTreeNode* share(BTreeNode* node); // adds a reference
+    static bool unshare(BTreeNode* node); // drops a reference, true if it was the last one
 private:
     size_t n; // # of keys stored in page
     std::vector<T> keys; // the keys themselves
     std::vector<BTreeNode*> children; // pointers to children of size n+1
     bool leaf; // whether it is a leaf page
+    std::atomic<size_t> refs; // trees/pages pointing here
     void printKeys();
 };
 
 template <typename T>
-BTreeNode<T>::BTreeNode() {
+BTreeNode<T>::BTreeNode() : refs(1) {
     n = 0;
     leaf = true;
 }
 
 template <typename T>
-BTreeNode<T>::~BTreeNode() {
-    for(size_t i=0; i<children.size(); i++) {
-        delete children[i]; // will recurse
+BTreeNode<T>::BTreeNode(const BTreeNode<T>& node) : n(node.n), keys(node.keys), children(node.children), leaf(node.leaf), refs(1) {
+    // Path copy - the subtrees stay shared
+    for (auto child : children) {
+        share(child);
     }
 }
 
 template <typename T>
-BTreeNode<T>::BTreeNode(BTreeNode<T>& node) : n(node.n), leaf(node.leaf), keys(node.keys) {
-    // Deep copy the children
-    children.reserve(node.children.size()); // Reserve space
-    for (auto child : node.children) {
-        if (child) {
-            children.push_back(new BTreeNode<T>(*child)); // Recursively copy child nodes
-        } else {
-            children.push_back(nullptr);
-        }
-    }
-}
-
-template <typename T>
-BTreeNode<T>::BTreeNode(BTreeNode<T>&& node) noexcept : n(node.n), leaf(node.leaf), keys(std::move(node.keys)), children(std::move(node.children)) {
+BTreeNode<T>::BTreeNode(BTreeNode<T>&& node) noexcept : n(node.n), keys(std::move(node.keys)), children(std::move(node.children)), leaf(node.leaf), refs(1) {
     // node - vector move defaults to std::vector move constructor     
     node.children.clear();
 }
 
 template <typename T>
-BTreeNode<T>& BTreeNode<T>::operator=(BTreeNode<T>& rhs) { // perform deep copy
-    if(this != &rhs) {
-        n = rhs.n;
-        leaf = rhs.leaf;
-        keys = rhs.keys;
-        children = rhs.children;
-    }
-    return *this;
+const T& BTreeNode<T>::operator[](size_t i) {
+    return keys[i];
 }
 
 template <typename T>
-BTreeNode<T>& BTreeNode<T>::operator=(BTreeNode<T>&& rhs) noexcept {
-    // std::cout << "move assignment called\n";
-    if (this != &rhs) {
-        for (auto child : children) {
-            delete child;
-        }
-        children.clear(); // Prevent accidental reuse
-
-        n = rhs.n;
-        leaf = rhs.leaf;
-        keys = std::move(rhs.keys);
-        children = std::move(rhs.children);
-
-        rhs.children.clear(); // Prevent double delete
-        rhs.n = 0;
-        rhs.leaf = true;
+BTreeNode<T>* BTreeNode<T>::share(BTreeNode<T>* node) {
+    if(node) {
+        node->refs.fetch_add(1, std::memory_order_relaxed);
     }
-    return *this;
+    return node;
 }
 
 template <typename T>
-const T& BTreeNode<T>::operator[](size_t i) {
-    return keys[i];
+bool BTreeNode<T>::unshare(BTreeNode<T>* node) {
+    return node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1;
 }
 
 template <typename T>
@@ -104,70 +95,79 @@ void BTreeNode<T>::printKeys() {
     std::cout << "\t"; // end of page/node
 }
 
-template <typename T>
-class BTree {
+template <typename T, template <typename> class Alloc, typename Stats>
+class BTree<T, 0, Alloc, Stats> {
+    // One node pool per family of snapshots, since they share pages.
+    // Snapshots may be dropped on other threads, so the pool is locked.
+    struct NodePool {
+        std::mutex m;
+        Alloc<BTreeNode<T>> alloc;
+    };
+    std::shared_ptr<NodePool> pool;
     BTreeNode<T>* root;
     size_t t; // page-characteristic degree
+    [[no_unique_address]] Stats counters; // per tree - snapshots start from zero
 public:
-    BTree(size_t t) {
+    BTree(size_t t) : pool(std::make_shared<NodePool>()) {
         this->t = t;
-        root = new BTreeNode<T>();
+        root = newNode();
         root->leaf = true;
         root->n = 0;
     }
     ~BTree() {
-        delete root;
-    }
-    BTree(BTree<T> &tree) : t(tree.t), root(new BTreeNode<T>(*tree.root)) {
-        // must perform a deep copy of root
+        release(root);
     }
-    BTree(BTree<T> &&tree) noexcept : t(tree.t), root(std::exchange(tree.root, nullptr)) {}
-    BTree& operator=(BTree<T>& rhs) {
+    // O(1) - both trees share every page until one of them writes to it
+    BTree(const BTree &tree) : pool(tree.pool), root(BTreeNode<T>::share(tree.root)), t(tree.t) {}
+    BTree(BTree &&tree) noexcept : pool(std::move(tree.pool)), root(std::exchange(tree.root, nullptr)), t(tree.t) {}
+    BTree& operator=(const BTree& rhs) {
         if (this != &rhs) {
-            delete root;
+            BTreeNode<T>::share(rhs.root);
+            release(root);
             t = rhs.t;
-            root = rhs.root ? new BTreeNode<T>(*rhs.root) : nullptr;
+            root = rhs.root;
+            pool = rhs.pool;
         }
         return *this;
     }
-    BTree& operator=(BTree<T>&& rhs) noexcept {
+    BTree& operator=(BTree&& rhs) noexcept {
         if (this != &rhs) {
-            delete root;
+            release(root);
             t = rhs.t;
             root = std::exchange(rhs.root, nullptr); // trash the rhs, make this own its addr
+            pool = std::move(rhs.pool);
         }
         return *this;
     }
+    // Read-only view of the current contents. Later writes to this tree copy
+    // only the pages on their root-to-leaf path, never the snapshot's.
+    // Take snapshots on the writing thread; they can be read and dropped anywhere.
+    BTree snapshot() const {
+        return BTree(*this);
+    }
+
     void insert(T k) { // 2 cases - full or not full
         // calls recursive helper insert_nonfull
-        BTreeNode<T>* r = root;
+        own(root);
         if(root->n == 2*t - 1) { // preemptively split!
-            BTreeNode<T>* s = new BTreeNode<T>();
-            root = s;
-            s->leaf = false;
-            s->n = 0;
-            s->children.push_back(r);
-            splitChild(s, 0);
-            insert_nonfull(s, k);
-        } else {   
-            insert_nonfull(r, k);
+            splitRoot();
         }
+        insert_nonfull(root, k);
     }
 
     std::pair<BTreeNode<T>*, int> search(T k) {
+        counters.lookup();
         return search(root, k);
     }
     
     // Returns pointer to node + index within node that it was found
     std::pair<BTreeNode<T>*, int> search(BTreeNode<T>* x, T k) {
-        int i = 0;
-        // std::cout << "currently at " << x->keys[0] << "\n";
-        while(i < x->n && k > x->keys[i]) {
-            i += 1;
-        } // proceed from left to right of page until appropriate range discovered
+        // find the appropriate range within the page (see NodeSearch.h)
+        counters.visit(x->n);
+        size_t i = nodeLowerBound(x->keys.data(), x->n, k);
         if(i < x->n && k == x->keys[i]) {
             // the node may be the destination...if so, return
-            return std::pair{x, i};
+            return std::pair{x, static_cast<int>(i)};
         } // otherwise, continue at an additional depth
         else if(x->leaf) { // no range of k?
             return std::pair{nullptr, -1}; // garbage pair
@@ -176,6 +176,77 @@ public:
         return search(x->children[i], k); // reads the deeper "disk" + continue
     }
 
+    // Replaces the contents with the sorted keys of [first, last), built bottom-up
+    template <typename InputIt>
+    void bulk_load(InputIt first, InputIt last, double fill_factor = 1.0) {
+        bulk_load([&](auto&& emit) {
+            for(; first != last; ++first) {
+                emit(*first);
+            }
+        }, fill_factor);
+    }
+
+    // Streaming form: producer(emit) calls emit(key) once per key, in sorted order.
+    // Leaves are packed left to right to fill_factor of 2t-1 keys and every
+    // overflowing key becomes a separator on the open node one level up, so no
+    // key ever descends from the root or triggers a split.
+    template <typename Producer>
+    void bulk_load(Producer&& producer, double fill_factor = 1.0) {
+        size_t cap = std::clamp<size_t>(static_cast<size_t>(fill_factor * (2*t - 1) + 0.5), t - 1, 2*t - 1);
+        std::vector<BTreeNode<T>*> spine{newNode()}; // open (rightmost) node per level
+        const T* prev = nullptr;
+        try {
+            producer([&](const T& k) {
+                if(prev && k < *prev) {
+                    throw std::invalid_argument("EXCEPTION: bulk_load keys out of order!");
+                }
+                BTreeNode<T>* leaf = spine[0];
+                if(leaf->n < cap) {
+                    leaf->keys.push_back(k);
+                    leaf->n += 1;
+                    prev = &leaf->keys.back();
+                } else {
+                    BTreeNode<T>* fresh = newNode();
+                    spine[0] = fresh;
+                    prev = &pushSeparator(spine, 1, k, fresh, leaf, cap);
+                }
+            });
+        } catch(...) {
+            release(spine.back()); // every node built so far hangs off the top
+            throw;
+        }
+        release(root);
+        root = spine.back();
+        // The right spine may be underfull - walk down it, merging each last
+        // child into its left sibling or borrowing from it, as in deletion
+        BTreeNode<T>* x = root;
+        while(!x->leaf) {
+            size_t i = x->n;
+            BTreeNode<T>* child = x->children[i];
+            if(child->n < t && i > 0) {
+                BTreeNode<T>* leftSibling = x->children[i - 1];
+                if(leftSibling->n + child->n + 1 <= 2*t - 1) {
+                    mergeNodes(leftSibling, child, x->keys[i - 1]);
+                    x->keys.pop_back();
+                    x->children.pop_back();
+                    x->n -= 1;
+                    freeNode(child);
+                    child = leftSibling;
+                } else {
+                    while(child->n < t) {
+                        borrowFromLeft(x, i);
+                    }
+                }
+            }
+            x = child;
+        }
+        while(root->n == 0 && !root->leaf) {
+            BTreeNode<T>* oldRoot = root;
+            root = root->children[0];
+            freeNode(oldRoot);
+        }
+    }
+
     void printBTree() {
         // going in a pre-order traversal (BFS)
         std::queue<std::pair<BTreeNode<T>*, int>> q;
@@ -196,27 +267,299 @@ public:
         std::cout << "\n";
     }
 
+    // Read-only pointer-free copy of the keys, in order - see FrozenTree.h
+    FrozenTree<T> freeze() const {
+        std::vector<T> keys;
+        if(root) {
+            collect(root, keys);
+        }
+        return FrozenTree<T>(keys.begin(), keys.end());
+    }
+
     // No pseudocode found in CLRS
     void remove(T k) { // remove node with value k
         if(!root) { 
             throw std::runtime_error("EXCEPTION: Empty tree!!!!"); 
         }
         // no need to handle underfull root - it is allowed to be empty
-        deleteKeyHelper(root, k);
-        if(root->n == 0) {
-            // somehow potentially the root was borrowed out...
-            BTreeNode<T>* oldRoot = root;
-            std::cout << root->keys.size() << "\n";
-            // Replace root with either nothing (if tree emptied) or its only child!
-            root = root->children.empty()? nullptr : root->children[0];
-            oldRoot->children.clear(); // clear away blocker
-            delete oldRoot; // address redundant
+        deleteKeyHelper(own(root), k);
+        collapseRoot();
+    }
+
+    // Inserts the sorted keys of [first, last), resuming each key's descent
+    // from the deepest node on the last key's path that covers it and has
+    // room - one descent per run of keys bound for the same leaf, one split
+    // per full node. Throws on out-of-order keys; the keys before it stay inserted.
+    template <typename ForwardIt>
+    void insert_batch(ForwardIt first, ForwardIt last) {
+        std::vector<PathEntry> path;
+        for(ForwardIt prev = last; first != last; prev = first++) {
+            const T& k = *first;
+            if(prev != last && k < *prev) {
+                throw std::invalid_argument("EXCEPTION: insert_batch keys out of order!");
+            }
+            while(!path.empty() && (path.back().node->n == 2*t - 1 || !covers(path.back(), k, true))) {
+                path.pop_back();
+            }
+            if(path.empty()) {
+                own(root);
+                if(root->n == 2*t - 1) {
+                    splitRoot();
+                }
+                path.push_back({root, 0, nullptr, nullptr});
+            }
+            BTreeNode<T>* x = path.back().node;
+            while(!x->leaf) {
+                size_t i = nodeUpperBound(x->keys.data(), x->n, k);
+                if(x->children[i]->n == 2*t - 1) {
+                    splitChild(x, i);
+                    if(k > x->keys[i]) {
+                        i++;
+                    }
+                }
+                own(x->children[i]); // path pages are private, as in insert_nonfull
+                path.push_back(childEntry(path.back(), i));
+                x = x->children[i];
+            }
+            size_t i = nodeUpperBound(x->keys.data(), x->n, k);
+            x->keys.insert(x->keys.begin() + i, k);
+            x->n += 1;
+        }
+    }
+
+    // Removes the sorted keys of [first, last); absent keys are skipped.
+    // Keys are deleted bottom-up along the kept path and a page is only topped
+    // back up from a sibling once the batch has moved past it - one merge or
+    // redistribution per page instead of one per key.
+    // Throws on out-of-order keys after rebalancing what was removed.
+    template <typename ForwardIt>
+    void remove_batch(ForwardIt first, ForwardIt last) {
+        std::vector<PathEntry> path{{own(root), 0, nullptr, nullptr}};
+        auto settle = [&](size_t depth) { // rebalances every page below path[depth-1]
+            while(path.size() > depth) {
+                size_t slot = path.back().slot;
+                path.pop_back();
+                refill(path.back().node, slot);
+            }
+        };
+        for(ForwardIt prev = last; first != last; prev = first++) {
+            const T& k = *first;
+            if(prev != last && k < *prev) {
+                settle(1);
+                collapseRoot();
+                throw std::invalid_argument("EXCEPTION: remove_batch keys out of order!");
+            }
+            size_t depth = path.size();
+            while(depth > 1 && !covers(path[depth - 1], k, false)) {
+                depth--;
+            }
+            settle(depth);
+            BTreeNode<T>* x = path.back().node;
+            while(true) {
+                size_t i = nodeLowerBound(x->keys.data(), x->n, k);
+                bool found = i < x->n && x->keys[i] == k;
+                if(x->leaf) {
+                    if(found) {
+                        x->keys.erase(x->keys.begin() + i);
+                        x->n -= 1;
+                    }
+                    break;
+                }
+                if(found) { // take the predecessor's place - its leaf joins the path
+                    own(x->children[i]);
+                    path.push_back(childEntry(path.back(), i));
+                    BTreeNode<T>* y = x->children[i];
+                    while(!y->leaf) {
+                        own(y->children.back());
+                        path.push_back(childEntry(path.back(), y->n));
+                        y = y->children.back();
+                    }
+                    x->keys[i] = y->keys.back();
+                    y->keys.pop_back();
+                    y->n -= 1;
+                    break;
+                }
+                own(x->children[i]);
+                path.push_back(childEntry(path.back(), i));
+                x = x->children[i];
+            }
+        }
+        settle(1);
+        collapseRoot();
+    }
+
+    // Shape is measured by walking the tree, event counts come from Stats
+    BTreeStats stats() const {
+        BTreeStats s;
+        s.capacity = 2*t - 1;
+        std::vector<std::pair<const BTreeNode<T>*, size_t>> stack;
+        if(root) {
+            stack.push_back({root, 1});
         }
+        while(!stack.empty()) {
+            auto [x, depth] = stack.back();
+            stack.pop_back();
+            s.height = std::max(s.height, depth);
+            s.addNode(x->n, sizeof(BTreeNode<T>) + x->keys.capacity() * sizeof(T) + x->children.capacity() * sizeof(BTreeNode<T>*));
+            for(const BTreeNode<T>* child : x->children) {
+                stack.push_back({child, depth + 1});
+            }
+        }
+        counters.report(s);
+        return s;
+    }
+
+    void resetStats() {
+        counters.reset();
     }
 private:
+    // Appends the keys under x in order - recursion depth is the height
+    static void collect(const BTreeNode<T>* x, std::vector<T>& keys) {
+        for(size_t i=0; i<x->n; i++) {
+            if(!x->leaf) {
+                collect(x->children[i], keys);
+            }
+            keys.push_back(x->keys[i]);
+        }
+        if(!x->leaf) {
+            collect(x->children[x->n], keys);
+        }
+    }
+    template <typename... Args>
+    BTreeNode<T>* newNode(Args&&... args) {
+        std::lock_guard<std::mutex> lock(pool->m);
+        return pool->alloc.create(std::forward<Args>(args)...);
+    }
+
+    // One page on a batch's root-to-leaf path, already made private. lower
+    // and upper point at the separators around it in its parent (nullptr =
+    // unbounded); the parent is only modified after this entry is popped.
+    struct PathEntry {
+        BTreeNode<T>* node;
+        size_t slot; // index among the parent's children
+        const T* lower;
+        const T* upper;
+    };
+
+    static PathEntry childEntry(const PathEntry& parent, size_t i) {
+        const BTreeNode<T>* x = parent.node;
+        return {x->children[i], i, i > 0 ? &x->keys[i - 1] : parent.lower, i < x->n ? &x->keys[i] : parent.upper};
+    }
+
+    // Whether a descent from the root would pass through e.node for k.
+    // insert_nonfull sends a key equal to lower right (upper bound search);
+    // a removal has to restart above, since the key may be that separator.
+    static bool covers(const PathEntry& e, const T& k, bool inserting) {
+        if(e.lower && (inserting ? k < *e.lower : !(*e.lower < k))) {
+            return false;
+        }
+        return !e.upper || k < *e.upper;
+    }
+
+    // Grows the tree a level above the (full, owned) root
+    void splitRoot() {
+        BTreeNode<T>* s = newNode();
+        s->leaf = false;
+        s->children.push_back(root);
+        root = s;
+        splitChild(s, 0);
+    }
+
+    void collapseRoot() {
+        while(root->n == 0 && !root->leaf) {
+            // Replace root with its only child - an emptied leaf root stays as the empty tree
+            BTreeNode<T>* oldRoot = root;
+            root = root->children[0];
+            freeNode(oldRoot);
+        }
+    }
+
+    // Tops x->children[i] back up to t-1 keys after a batch removal, merging
+    // it with a sibling when both fit in one page and redistributing
+    // otherwise. A child left with no keys kept a single child that may be
+    // short as well (there was no key to borrow through), so that one is
+    // repaired next - and since a merge there takes a key back, the child is
+    // checked once more.
+    void refill(BTreeNode<T>* x, size_t i) {
+        if(x->n == 0 || x->children[i]->n >= t - 1) {
+            return; // a keyless x is repaired, with this child, when its own parent is
+        }
+        BTreeNode<T>* c = own(x->children[i]);
+        bool hollow = !c->leaf && c->n == 0;
+        size_t j = 0; // where c's only child ends up
+        if(i > 0 && x->children[i - 1]->n + c->n + 1 <= 2*t - 1) {
+            BTreeNode<T>* leftSibling = own(x->children[i - 1]);
+            j = leftSibling->n + 1;
+            mergeNodes(leftSibling, c, x->keys[i - 1]);
+            x->keys.erase(x->keys.begin() + i - 1);
+            x->children.erase(x->children.begin() + i);
+            x->n -= 1;
+            freeNode(c);
+            i -= 1;
+        } else if(i > 0) {
+            while(c->n < t - 1) {
+                borrowFromLeft(x, i);
+                j++;
+            }
+        } else if(c->n + x->children[1]->n + 1 <= 2*t - 1) {
+            BTreeNode<T>* rightSibling = own(x->children[1]);
+            mergeNodes(c, rightSibling, x->keys[0]);
+            x->keys.erase(x->keys.begin());
+            x->children.erase(x->children.begin() + 1);
+            x->n -= 1;
+            freeNode(rightSibling);
+        } else {
+            while(c->n < t - 1) {
+                borrowFromRight(x, 0);
+            }
+        }
+        if(hollow) {
+            refill(x->children[i], j);
+            refill(x, i);
+        }
+    }
+
+    // Frees one page - its children are left alone
+    void freeNode(BTreeNode<T>* node) {
+        std::lock_guard<std::mutex> lock(pool->m);
+        pool->alloc.destroy(node);
+    }
+
+    // Drops a reference to the subtree at node, freeing every page that
+    // becomes unreferenced. Iterative, so deep or wide trees cannot blow the stack.
+    void release(BTreeNode<T>* node) {
+        if(!node || !BTreeNode<T>::unshare(node)) {
+            return;
+        }
+        std::vector<BTreeNode<T>*> dead{node};
+        std::lock_guard<std::mutex> lock(pool->m);
+        while(!dead.empty()) {
+            BTreeNode<T>* x = dead.back();
+            dead.pop_back();
+            for(BTreeNode<T>* child : x->children) {
+                if(BTreeNode<T>::unshare(child)) {
+                    dead.push_back(child);
+                }
+            }
+            pool->alloc.destroy(x);
+        }
+    }
+
+    // Copy-on-write: before a page is modified, replace the pointer to it in
+    // its (already owned) parent - or the root - with a private copy if shared
+    BTreeNode<T>* own(BTreeNode<T>*& slot) {
+        if(slot->refs.load(std::memory_order_acquire) > 1) {
+            BTreeNode<T>* copy = newNode(*slot);
+            release(slot);
+            slot = copy;
+        }
+        return slot;
+    }
+
     void splitChild(BTreeNode<T>* x, int i) {
-        BTreeNode<T>* z = new BTreeNode<T>(); // New node to the right
-        BTreeNode<T>* y = x->children[i];    // Original node that was oversized
+        counters.split();
+        BTreeNode<T>* z = newNode(); // New node to the right
+        BTreeNode<T>* y = own(x->children[i]);    // Original node that was oversized
         z->leaf = y->leaf;
         z->n = t - 1;
 
@@ -233,7 +576,8 @@ private:
             y->children.erase(y->children.begin() + t, y->children.end());
         }
 
-        // Reduce the number of keys in y
+        // Reduce the number of keys in y - keep the median before erasing it
+        T median = y->keys[t - 1];
         y->keys.erase(y->keys.begin() + t - 1, y->keys.end());
         y->n = t - 1;
 
@@ -241,172 +585,173 @@ private:
         x->children.insert(x->children.begin() + i + 1, z);
 
         // insert middle key into top page
-        x->keys.insert(x->keys.begin() + i, y->keys[t - 1]);
+        x->keys.insert(x->keys.begin() + i, median);
         x->n += 1;
     }
     
-    void insert_nonfull(BTreeNode<T>* x, int k) { // also recursive!
-        int i = x->n - 1;
+    void insert_nonfull(BTreeNode<T>* x, T k) { // also recursive!
+        // i = number of keys not greater than k
+        size_t i = nodeUpperBound(x->keys.data(), x->n, k);
         if(x->leaf) {
-            while(i >= 0 && k < x->keys[i]) {
-                i -= 1;
-            }
-            x->keys.insert(x->keys.begin()+i+1, k);
+            x->keys.insert(x->keys.begin() + i, k);
             x->n = x->n + 1;
         } else { // recurse on insertion
-            while (i >= 0 && k < x->keys[i]) {
-                i--;
-            }
-            i++;
             if (x->children[i]->n == 2 * t - 1) {
                 splitChild(x, i);
                 if (k > x->keys[i]) {
                     i++;
                 }
             }
-            insert_nonfull(x->children[i], k);
+            insert_nonfull(own(x->children[i]), k);
         }
         return;
     }
 
     // Considering moving repetetive parts of cases 2 & 3 into own (inline) methods
     void deleteKeyHelper(BTreeNode<T>* x, T k) {
-        // std::cout << "currently at " << x->keys[0] << " with " << x->n << "\n";
-        // search the tree & find destination!
-        size_t i = x->n - 1;
+        // search the tree & find destination - first key not less than k
+        size_t i = nodeLowerBound(x->keys.data(), x->n, k);
+        bool found = i < x->n && x->keys[i] == k;
         // Case 1: if arrive at leaf - delete key k if existing!
         if(x->leaf) { // IE: the base case
-            while(i >= 0 && k < x->keys[i]) {
-                i -= 1;
-            }
-            if(i == -1) {
-                throw std::runtime_error("Exception 3: out of range!!");
-            }
-            if(x->keys[i] == k) {
+            if(found) {
                 x->keys.erase(x->keys.begin() + i);
                 x->n -= 1;
             }
+            return;
         }
-        else {
-            // For some odd reason we do > 0 - for a non-leaf node search...
-            while(i > 0 && k < x->keys[i]) {
-                i -= 1; // search for node in k's value range
-            }
-            if(i == -1) {
-                throw std::runtime_error("EXCEPTION: 2 out of range!!");
-            }
-            // Case 2: if arrived at an internal node with k
-            if(x->keys[i] == k) {
-                // std::cout << "case 2\n";
-                // 2a: if predecessor k' of good capacity, delete k' recursively & replace value on k
-                BTreeNode<T>* predec = x->children[i];
-                // std::cout << "found child at " << i << " with " <<  x->children[i]->keys[0] << "\n";
-                if(predec->n > t-1) {
-                    T kprime = predec->keys[predec->keys.size()-1];
-                    // std::cout << "kprime predec " << kprime << "\n";
-                    // std::cout << "recursive call 1\n";
-                    x->keys[i] = kprime; // value replacement
-                    deleteKeyHelper(predec, kprime);
+        // Case 2: if arrived at an internal node with k
+        if(found) {
+            // 2a: if predecessor k' of good capacity, delete k' recursively & replace value on k
+            BTreeNode<T>* predec = x->children[i];
+            BTreeNode<T>* succ = x->children[i+1];
+            if(predec->n > t-1) {
+                predec = own(x->children[i]);
+                BTreeNode<T>* y = predec;
+                while(!y->leaf) {
+                    y = y->children.back();
                 }
-                // 2b: predec. underfull, but not succ. - do the same as a but for succ.
-                else {
-                    BTreeNode<T>* succ = x->children[i+1];
-                    T kprime = succ->keys[0];
-                    // std::cout << "kprime succ " << kprime << "\n";
-                    if(succ->n > t-1) {
-                        // std::cout << "recursive call 2\n";
-                        x->keys[i] = kprime;
-                        deleteKeyHelper(succ, kprime);
-                    }
-                    // 2c: both pred. and succ. underfull - merge predec & succ with k, free succ., rm k rec.
-                    else {
-                        // x will have no more k and no more x.c_i+1, x_ci should be full
-                        mergeNodes(predec, succ, k);
-                        x->n -= 1;
-                        // std::cout << "x now has " << x->n << " keys\n";
-                        x->children.erase(x->children.begin() + i + 1);
-                        x->keys.erase(x->keys.begin()+i);
-                        // deletion now depends on x.c_i & its children
-                        // std::cout << "recursive call 3\n";
-                        deleteKeyHelper(predec, k);
-                        delete succ;
-                    }
+                T kprime = y->keys.back();
+                x->keys[i] = kprime; // value replacement
+                deleteKeyHelper(predec, kprime);
+            }
+            // 2b: predec. underfull, but not succ. - do the same as a but for succ.
+            else if(succ->n > t-1) {
+                succ = own(x->children[i+1]);
+                BTreeNode<T>* y = succ;
+                while(!y->leaf) {
+                    y = y->children.front();
                 }
+                T kprime = y->keys.front();
+                x->keys[i] = kprime;
+                deleteKeyHelper(succ, kprime);
             }
-            // Case 3: internal node, en route to search for k
+            // 2c: both pred. and succ. underfull - merge predec & succ with k, free succ., rm k rec.
             else {
-                // std::cout << "Case 3 \n";
-                // 3a: if child of k's range underfull but sibling has capacity, borrow
-                // (with view from the parent)
-                size_t kIdx = x->children.size() - 1; // search through n + 1 children!!!
-                while(kIdx >= 0 && k < x->children[kIdx]->keys[0]) {
-                    // std::cout << "search " << x->children[kIdx]->keys[0] << " ";
-                    kIdx -= 1; // search for node in k's value range
-                }
-                if(kIdx == -1) {
-                    throw std::runtime_error("EXCEPTION: 1 out of range!!");
-                }
-                // std::cout << "child index " << kIdx << "\n";
-                BTreeNode<T>* child = x->children[kIdx];
-                if(child->n == t-1) {
-                    // std::cout << "donations needed\n";
-                    // try left sibling
-                    if(kIdx > 0 && x->children[kIdx-1]->n >= t) {
-                        // std::cout << "merging left\n";
-                        BTreeNode<T>* leftSibling = x->children[kIdx - 1];
-                        child->keys.insert(child->keys.begin(), x->keys[kIdx - 1]);
-                        x->keys[kIdx - 1] = leftSibling->keys.back();
-                        leftSibling->keys.pop_back();
-                        // Move the last child of the left sibling into the child node
-                        if (!leftSibling->children.empty()) {
-                            // if leftSibling a leaf - then no children!
-                            child->children.insert(child->children.begin(), leftSibling->children.back());
-                            leftSibling->children.pop_back();  // Remove the last child from the left sibling
-                        }
-                        child->n += 1;
-                        leftSibling->n -= 1;
-                    }
-                    // try right sibling
-                    else if(kIdx < x->children.size()-1 && x->children[kIdx+1]->n >= t) {
-                        BTreeNode<T>* rightSibling = x->children[kIdx + 1];
-                        child->keys.push_back(x->keys[kIdx]);
-                        x->keys[kIdx] = rightSibling->keys.front();
-                        rightSibling->keys.erase(rightSibling->keys.begin());
-                        // transfer children around
-                        if (!rightSibling->children.empty()) {
-                            child->children.push_back(rightSibling->children.front());
-                            rightSibling->children.erase(rightSibling->children.begin());
-                        }
-                        child->n += 1;
-                        rightSibling->n -= 1;
-                    }
-                    // 3b: if all siblings underfull - merge with first available sibling
-                    else {
-                        // std::cout << "merging siblings\n";
-                        if(kIdx > 0) {
-                            // std::cout << "merging with left\n";
-                            BTreeNode<T>* leftSibling = x->children[kIdx - 1];
-                            mergeNodes(leftSibling, child, x->keys[kIdx - 1]);
-                            x->keys.erase(x->keys.begin() + kIdx - 1);
-                            x->children.erase(x->children.begin() + kIdx);
-                            
-                            x->n -= 1;
-                        }
-                        else {
-                            BTreeNode<T>* rightSibling = x->children[kIdx + 1];
-                            mergeNodes(child, rightSibling, x->keys[kIdx]);
-                            x->keys.erase(x->keys.begin() + kIdx);
-                            x->n -= 1;
-                            // std::cout << "erasing " << x->children[kIdx]->keys[0] << "\n";
-                            x->children.erase(x->children.begin() + kIdx + 1);
-                            delete rightSibling;
-                        }
-                    }
-                }
-                // std::cout << "recursive call 4\n";
-                deleteKeyHelper(x->children[kIdx], k);
+                predec = own(x->children[i]);
+                succ = own(x->children[i+1]);
+                mergeNodes(predec, succ, k);
+                x->n -= 1;
+                x->children.erase(x->children.begin() + i + 1);
+                x->keys.erase(x->keys.begin() + i);
+                freeNode(succ);
+                // deletion now depends on x.c_i & its children
+                deleteKeyHelper(predec, k);
+            }
+            return;
+        }
+        // Case 3: internal node, en route to search for k
+        // 3a: if child of k's range underfull but sibling has capacity, borrow
+        // (with view from the parent)
+        size_t kIdx = i;
+        BTreeNode<T>* child = own(x->children[kIdx]);
+        if(child->n == t-1) {
+            // try left sibling
+            if(kIdx > 0 && x->children[kIdx-1]->n >= t) {
+                borrowFromLeft(x, kIdx);
+            }
+            // try right sibling
+            else if(kIdx < x->n && x->children[kIdx+1]->n >= t) {
+                borrowFromRight(x, kIdx);
             }
-        }   
+            // 3b: if all siblings underfull - merge with first available sibling
+            else if(kIdx > 0) {
+                BTreeNode<T>* leftSibling = own(x->children[kIdx - 1]);
+                mergeNodes(leftSibling, child, x->keys[kIdx - 1]);
+                x->keys.erase(x->keys.begin() + kIdx - 1);
+                x->children.erase(x->children.begin() + kIdx);
+                x->n -= 1;
+                freeNode(child);
+                kIdx -= 1;
+            }
+            else {
+                BTreeNode<T>* rightSibling = own(x->children[kIdx + 1]);
+                mergeNodes(child, rightSibling, x->keys[kIdx]);
+                x->keys.erase(x->keys.begin() + kIdx);
+                x->children.erase(x->children.begin() + kIdx + 1);
+                x->n -= 1;
+                freeNode(rightSibling);
+            }
+        }
+        deleteKeyHelper(x->children[kIdx], k);
+    }
+
+    // Rotates the last key of x->children[i-1] up through x into the front of x->children[i]
+    void borrowFromLeft(BTreeNode<T>* x, size_t i) {
+        counters.borrow();
+        BTreeNode<T>* child = own(x->children[i]);
+        BTreeNode<T>* leftSibling = own(x->children[i - 1]);
+        child->keys.insert(child->keys.begin(), x->keys[i - 1]);
+        x->keys[i - 1] = leftSibling->keys.back();
+        leftSibling->keys.pop_back();
+        // Move the last child of the left sibling into the child node
+        if (!leftSibling->children.empty()) {
+            // if leftSibling a leaf - then no children!
+            child->children.insert(child->children.begin(), leftSibling->children.back());
+            leftSibling->children.pop_back();  // Remove the last child from the left sibling
+        }
+        child->n += 1;
+        leftSibling->n -= 1;
+    }
+
+    // Rotates the first key of x->children[i+1] up through x onto the end of x->children[i]
+    void borrowFromRight(BTreeNode<T>* x, size_t i) {
+        counters.borrow();
+        BTreeNode<T>* child = own(x->children[i]);
+        BTreeNode<T>* rightSibling = own(x->children[i + 1]);
+        child->keys.push_back(x->keys[i]);
+        x->keys[i] = rightSibling->keys.front();
+        rightSibling->keys.erase(rightSibling->keys.begin());
+        // transfer children around
+        if (!rightSibling->children.empty()) {
+            child->children.push_back(rightSibling->children.front());
+            rightSibling->children.erase(rightSibling->children.begin());
+        }
+        child->n += 1;
+        rightSibling->n -= 1;
+    }
+
+    // Appends separator k (with new right child) to the open node at level,
+    // opening a new node and pushing k one level up when that node is full
+    T& pushSeparator(std::vector<BTreeNode<T>*>& spine, size_t level, const T& k, BTreeNode<T>* right, BTreeNode<T>* closed, size_t cap) {
+        if(level == spine.size()) { // tree grows a level
+            BTreeNode<T>* p = newNode();
+            p->leaf = false;
+            p->children.push_back(closed);
+            spine.push_back(p);
+        }
+        BTreeNode<T>* p = spine[level];
+        if(p->n < cap) {
+            p->keys.push_back(k);
+            p->children.push_back(right);
+            p->n += 1;
+            return p->keys.back();
+        }
+        BTreeNode<T>* q = newNode();
+        q->leaf = false;
+        q->children.push_back(right);
+        spine[level] = q;
+        return pushSeparator(spine, level + 1, k, q, p, cap);
     }
 
     // Merging must take place between two nodes AND a key
@@ -414,6 +759,7 @@ private:
     // However, both nodes have combined 2t-2 keys - so need 1 extra key
     // When applied, lexic. order must be lhs << k << rhs 
     void mergeNodes(BTreeNode<T>* lhs, BTreeNode<T>* rhs, T k) {
+        counters.merge();
         // append keys
         lhs->keys.push_back(k);
         lhs->keys.insert(lhs->keys.end(), rhs->keys.begin(), rhs->keys.end());
@@ -424,4 +770,656 @@ private:
         rhs->children.clear(); // remove children & keys to avoid interference with dealloc
         rhs->keys.clear();
     }
-};
\ No newline at end of file
+};
+
+/*
+Fixed-capacity B-Tree: BTree<T, Degree>
+Each node is a single allocation holding 2*Degree-1 keys and 2*Degree child
+pointers inline, aligned to cache lines, so a key scan only touches
+contiguous memory and splits/merges never reallocate.
+Nodes come from the tree's allocator; with the default SlabAllocator and a
+trivially destructible T the whole tree is freed in O(chunks).
+*/
+
+constexpr size_t cacheLineSize = 64;
+
+template <typename T, size_t Degree>
+class alignas(cacheLineSize) InlineBTreeNode {
+    template <typename, size_t, template <typename> class, typename> friend class BTree;
+public:
+    static constexpr size_t maxKeys = 2 * Degree - 1;
+    static constexpr size_t maxChildren = 2 * Degree;
+
+    InlineBTreeNode();
+    InlineBTreeNode(const InlineBTreeNode& node) = delete; // the tree copies page by page
+    InlineBTreeNode(InlineBTreeNode&& node) = delete; // nodes are only moved by pointer
+    InlineBTreeNode& operator=(const InlineBTreeNode& rhs) = delete;
+    InlineBTreeNode& operator=(InlineBTreeNode&& rhs) = delete;
+    const T& operator[](size_t i);
+private:
+    unsigned n; // # of keys stored in page
+    bool leaf; // whether it is a leaf page
+    std::array<T, maxKeys> keys; // keys packed right after the header
+    std::array<InlineBTreeNode*, maxChildren> children; // only [0, n] valid for internal pages
+    void printKeys();
+};
+
+template <typename T, size_t Degree>
+InlineBTreeNode<T, Degree>::InlineBTreeNode() : n(0), leaf(true) {}
+
+template <typename T, size_t Degree>
+const T& InlineBTreeNode<T, Degree>::operator[](size_t i) {
+    return keys[i];
+}
+
+template <typename T, size_t Degree>
+void InlineBTreeNode<T, Degree>::printKeys() {
+    for(size_t i=0; i<n; i++) {
+        std::cout << keys[i] << " ";
+    }
+    std::cout << "\t";
+}
+
+template <typename T, size_t Degree, template <typename> class Alloc, typename Stats>
+class BTree {
+    static_assert(Degree >= 2, "B-Tree degree must be at least 2");
+    using Node = InlineBTreeNode<T, Degree>;
+    static constexpr size_t t = Degree;
+    Alloc<Node> alloc;
+    Node* root; // nullptr only in a moved-from tree, until its next insert
+    [[no_unique_address]] mutable Stats counters; // lookups count too
+public:
+    BTree() : root(alloc.create()) {}
+    ~BTree() {
+        destroyTree();
+    }
+    BTree(const BTree& tree) : root(tree.root ? clone(tree.root) : nullptr) {}
+    BTree(BTree&& tree) noexcept : alloc(std::move(tree.alloc)), root(std::exchange(tree.root, nullptr)) {}
+    BTree& operator=(const BTree& rhs) {
+        if(this != &rhs) {
+            BTree copy(rhs);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+    BTree& operator=(BTree&& rhs) noexcept {
+        if(this != &rhs) {
+            std::swap(alloc, rhs.alloc); // rhs frees our old tree
+            std::swap(root, rhs.root);
+        }
+        return *this;
+    }
+
+    void insert(const T& k) {
+        ensureRoot();
+        if(root->n == Node::maxKeys) { // preemptively split!
+            splitRoot();
+        }
+        insert_nonfull(root, k);
+    }
+
+    // Returns pointer to node + index within node that it was found
+    std::pair<Node*, int> search(const T& k) const {
+        counters.lookup();
+        Node* x = root;
+        if(!x) {
+            return {nullptr, -1};
+        }
+        while(true) {
+            counters.visit(x->n);
+            size_t i = findSlot(x, k);
+            if(i < x->n && !(k < x->keys[i])) {
+                return {x, static_cast<int>(i)};
+            }
+            if(x->leaf) {
+                return {nullptr, -1};
+            }
+            x = x->children[i];
+        }
+    }
+
+    void remove(const T& k) {
+        if(!root) {
+            return;
+        }
+        deleteKeyHelper(root, k);
+        if(root->n == 0 && !root->leaf) {
+            // root was merged away - its only child becomes the new root
+            Node* oldRoot = root;
+            root = root->children[0];
+            alloc.destroy(oldRoot);
+        }
+    }
+
+    // Inserts the sorted keys of [first, last). The root-to-leaf path of the
+    // last key is kept, and each key resumes from the deepest node on it that
+    // still covers the key and has room - so a run of keys bound for one leaf
+    // costs one descent, and each full node on the way is split once.
+    // Throws on out-of-order keys; the keys before it stay inserted.
+    template <typename ForwardIt>
+    void insert_batch(ForwardIt first, ForwardIt last) {
+        ensureRoot();
+        std::vector<PathEntry> path;
+        for(ForwardIt prev = last; first != last; prev = first++) {
+            const T& k = *first;
+            if(prev != last && k < *prev) {
+                throw std::invalid_argument("EXCEPTION: insert_batch keys out of order!");
+            }
+            while(!path.empty() && (path.back().node->n == Node::maxKeys || !covers(path.back(), k, true))) {
+                path.pop_back();
+            }
+            if(path.empty()) {
+                if(root->n == Node::maxKeys) {
+                    splitRoot();
+                }
+                path.push_back({root, 0, nullptr, nullptr});
+            }
+            Node* x = path.back().node;
+            while(!x->leaf) { // same preemptive splits as insert_nonfull
+                size_t i = findSlot(x, k);
+                if(x->children[i]->n == Node::maxKeys) {
+                    splitChild(x, i);
+                    if(x->keys[i] < k) {
+                        i++;
+                    }
+                }
+                path.push_back(childEntry(path.back(), i));
+                x = x->children[i];
+            }
+            size_t i = findSlot(x, k);
+            std::move_backward(x->keys.begin() + i, x->keys.begin() + x->n, x->keys.begin() + x->n + 1);
+            x->keys[i] = k;
+            x->n += 1;
+        }
+    }
+
+    // Removes the sorted keys of [first, last); absent keys are skipped.
+    // Works bottom-up on the kept path: keys are deleted from a leaf until
+    // the next key lies outside it, and only then is the leaf topped back up
+    // from a sibling - one merge or redistribution per node instead of one
+    // per key. Throws on out-of-order keys after rebalancing what was removed.
+    template <typename ForwardIt>
+    void remove_batch(ForwardIt first, ForwardIt last) {
+        ensureRoot(); // keeps the out-of-order check for a moved-from tree
+        std::vector<PathEntry> path{{root, 0, nullptr, nullptr}};
+        auto settle = [&](size_t depth) { // rebalances every node below path[depth-1]
+            while(path.size() > depth) {
+                size_t slot = path.back().slot;
+                path.pop_back();
+                refill(path.back().node, slot);
+            }
+        };
+        for(ForwardIt prev = last; first != last; prev = first++) {
+            const T& k = *first;
+            if(prev != last && k < *prev) {
+                settle(1);
+                collapseRoot();
+                throw std::invalid_argument("EXCEPTION: remove_batch keys out of order!");
+            }
+            size_t depth = path.size();
+            while(depth > 1 && !covers(path[depth - 1], k, false)) {
+                depth--;
+            }
+            settle(depth);
+            Node* x = path.back().node;
+            while(true) {
+                size_t i = findSlot(x, k);
+                bool found = i < x->n && !(k < x->keys[i]);
+                if(x->leaf) {
+                    if(found) {
+                        std::move(x->keys.begin() + i + 1, x->keys.begin() + x->n, x->keys.begin() + i);
+                        x->n -= 1;
+                    }
+                    break;
+                }
+                if(found) { // take the predecessor's place - its leaf joins the path
+                    path.push_back(childEntry(path.back(), i));
+                    Node* y = x->children[i];
+                    while(!y->leaf) {
+                        path.push_back(childEntry(path.back(), y->n));
+                        y = y->children[y->n];
+                    }
+                    x->keys[i] = std::move(y->keys[y->n - 1]);
+                    y->n -= 1;
+                    break;
+                }
+                path.push_back(childEntry(path.back(), i));
+                x = x->children[i];
+            }
+        }
+        settle(1);
+        collapseRoot();
+    }
+
+    // Shape is measured by walking the tree, event counts come from Stats
+    BTreeStats stats() const {
+        BTreeStats s;
+        s.capacity = Node::maxKeys;
+        std::vector<std::pair<const Node*, size_t>> stack;
+        if(root) {
+            stack.push_back({root, 1});
+        }
+        while(!stack.empty()) {
+            auto [x, depth] = stack.back();
+            stack.pop_back();
+            s.height = std::max(s.height, depth);
+            s.addNode(x->n, sizeof(Node));
+            if(!x->leaf) {
+                for(size_t i=0; i<=x->n; i++) {
+                    stack.push_back({x->children[i], depth + 1});
+                }
+            }
+        }
+        counters.report(s);
+        return s;
+    }
+
+    void resetStats() {
+        counters.reset();
+    }
+
+    // Replaces the contents with the sorted keys of [first, last), built bottom-up
+    template <typename InputIt>
+    void bulk_load(InputIt first, InputIt last, double fill_factor = 1.0) {
+        bulk_load([&](auto&& emit) {
+            for(; first != last; ++first) {
+                emit(*first);
+            }
+        }, fill_factor);
+    }
+
+    // Streaming form: producer(emit) calls emit(key) once per key, in sorted order.
+    // Same one-pass build as BTree<T>::bulk_load.
+    template <typename Producer>
+    void bulk_load(Producer&& producer, double fill_factor = 1.0) {
+        size_t cap = std::clamp<size_t>(static_cast<size_t>(fill_factor * Node::maxKeys + 0.5), t - 1, Node::maxKeys);
+        std::vector<Node*> spine{alloc.create()}; // open (rightmost) node per level
+        const T* prev = nullptr;
+        try {
+            producer([&](const T& k) {
+                if(prev && k < *prev) {
+                    throw std::invalid_argument("EXCEPTION: bulk_load keys out of order!");
+                }
+                Node* leaf = spine[0];
+                if(leaf->n < cap) {
+                    leaf->keys[leaf->n] = k;
+                    prev = &leaf->keys[leaf->n++];
+                } else {
+                    Node* fresh = alloc.create();
+                    spine[0] = fresh;
+                    prev = &pushSeparator(spine, 1, k, fresh, leaf, cap);
+                }
+            });
+        } catch(...) {
+            freeSubtree(spine.back()); // every node built so far hangs off the top
+            throw;
+        }
+        if(root) {
+            freeSubtree(root);
+        }
+        root = spine.back();
+        // top up the underfull right spine on the way down
+        Node* x = root;
+        while(!x->leaf) {
+            size_t i = x->n;
+            Node* child = x->children[i];
+            if(child->n < t && i > 0) {
+                Node* left = x->children[i - 1];
+                if(left->n + child->n + 1 <= Node::maxKeys) {
+                    mergeNodes(x, i - 1);
+                    child = left;
+                } else {
+                    while(child->n < t) {
+                        borrowFromLeft(x, i);
+                    }
+                }
+            }
+            x = child;
+        }
+        while(root->n == 0 && !root->leaf) {
+            Node* oldRoot = root;
+            root = root->children[0];
+            alloc.destroy(oldRoot);
+        }
+    }
+
+    // Read-only pointer-free copy of the keys, in order - see FrozenTree.h
+    FrozenTree<T> freeze() const {
+        std::vector<T> keys;
+        if(root) {
+            collect(root, keys);
+        }
+        return FrozenTree<T>(keys.begin(), keys.end());
+    }
+
+    void printBTree() {
+        std::queue<std::pair<Node*, int>> q;
+        int lvl = 0;
+        if(root) {
+            q.push({root, 0});
+        }
+        while(!q.empty()) {
+            std::pair<Node*, int> curr = q.front();
+            if(curr.second > lvl) {
+                std::cout << "\n";
+                lvl = curr.second;
+            }
+            q.pop();
+            curr.first->printKeys();
+            if(!curr.first->leaf) {
+                for(size_t i=0; i<=curr.first->n; i++) {
+                    q.push({curr.first->children[i], curr.second+1});
+                }
+            }
+        }
+        std::cout << "\n";
+    }
+private:
+    // Appends the keys under x in order - recursion depth is the height
+    static void collect(const Node* x, std::vector<T>& keys) {
+        for(size_t i=0; i<x->n; i++) {
+            if(!x->leaf) {
+                collect(x->children[i], keys);
+            }
+            keys.push_back(x->keys[i]);
+        }
+        if(!x->leaf) {
+            collect(x->children[x->n], keys);
+        }
+    }
+    // Deep copy of the subtree at src into this tree's allocator
+    Node* clone(const Node* src) {
+        Node* x = alloc.create();
+        x->n = src->n;
+        x->leaf = src->leaf;
+        x->keys = src->keys;
+        if(!x->leaf) {
+            size_t i = 0;
+            try {
+                for(; i<=x->n; i++) {
+                    x->children[i] = clone(src->children[i]);
+                }
+            } catch(...) {
+                x->leaf = true;
+                for(size_t j=0; j<i; j++) {
+                    freeSubtree(x->children[j]);
+                }
+                alloc.destroy(x);
+                throw;
+            }
+        }
+        return x;
+    }
+
+    // Frees every page under x, iteratively
+    void freeSubtree(Node* x) {
+        std::vector<Node*> dead{x};
+        while(!dead.empty()) {
+            Node* y = dead.back();
+            dead.pop_back();
+            if(!y->leaf) {
+                dead.insert(dead.end(), y->children.begin(), y->children.begin() + y->n + 1);
+            }
+            alloc.destroy(y);
+        }
+    }
+
+    // Frees the whole tree - trivially destructible pages are dropped with
+    // their chunks instead of being visited
+    void destroyTree() {
+        if(!root) {
+            return;
+        }
+        if constexpr (Alloc<Node>::bulkRelease && std::is_trivially_destructible_v<Node>) {
+            alloc.release();
+        } else {
+            freeSubtree(root);
+        }
+        root = nullptr;
+    }
+
+    // index of the first key in x that is not less than k
+    static size_t findSlot(const Node* x, const T& k) {
+        return nodeLowerBound(x->keys.data(), x->n, k);
+    }
+
+    // One node on a batch's root-to-leaf path. lower/upper point at the
+    // separators around it in its parent (nullptr = unbounded); the parent
+    // is only modified after this entry has been popped, so they stay valid.
+    struct PathEntry {
+        Node* node;
+        size_t slot; // index among the parent's children
+        const T* lower;
+        const T* upper;
+    };
+
+    static PathEntry childEntry(const PathEntry& parent, size_t i) {
+        const Node* x = parent.node;
+        return {x->children[i], i, i > 0 ? &x->keys[i - 1] : parent.lower, i < x->n ? &x->keys[i] : parent.upper};
+    }
+
+    // Whether a descent from the root would pass through e.node for k. An
+    // insert of a key equal to upper goes left; a removal has to restart
+    // above, since the key may be that separator.
+    static bool covers(const PathEntry& e, const T& k, bool inserting) {
+        if(e.lower && !(*e.lower < k)) {
+            return false;
+        }
+        return !e.upper || (inserting ? !(*e.upper < k) : k < *e.upper);
+    }
+
+    void ensureRoot() {
+        if(!root) {
+            root = alloc.create();
+        }
+    }
+
+    void splitRoot() {
+        Node* s = alloc.create();
+        s->leaf = false;
+        s->children[0] = root;
+        root = s;
+        splitChild(s, 0);
+    }
+
+    void collapseRoot() {
+        while(root->n == 0 && !root->leaf) {
+            Node* oldRoot = root;
+            root = root->children[0];
+            alloc.destroy(oldRoot);
+        }
+    }
+
+    // Tops x->children[i] back up to t-1 keys after a batch removal, merging
+    // it with a sibling when both fit in one node and redistributing
+    // otherwise. A child left with no keys kept a single child of its own that
+    // may be short as well (there was no key to borrow through), so that one
+    // is repaired next - and since a merge there takes a key back, the child
+    // is checked once more.
+    void refill(Node* x, size_t i) {
+        Node* c = x->children[i];
+        if(x->n == 0 || c->n >= t - 1) {
+            return; // a keyless x is repaired, with this child, when its own parent is
+        }
+        bool hollow = !c->leaf && c->n == 0;
+        size_t j = 0; // where c's only child ends up
+        if(i > 0 && x->children[i - 1]->n + c->n + 1 <= Node::maxKeys) {
+            i -= 1;
+            j = x->children[i]->n + 1;
+            mergeNodes(x, i);
+        } else if(i > 0) {
+            while(c->n < t - 1) {
+                borrowFromLeft(x, i);
+                j++;
+            }
+        } else if(c->n + x->children[1]->n + 1 <= Node::maxKeys) {
+            mergeNodes(x, 0);
+        } else {
+            while(c->n < t - 1) {
+                borrowFromRight(x, 0);
+            }
+        }
+        if(hollow) {
+            refill(x->children[i], j);
+            refill(x, i);
+        }
+    }
+
+    void splitChild(Node* x, size_t i) {
+        counters.split();
+        Node* y = x->children[i]; // full child
+        Node* z = alloc.create(); // receives the upper t-1 keys
+        z->leaf = y->leaf;
+        z->n = t - 1;
+        std::move(y->keys.begin() + t, y->keys.begin() + Node::maxKeys, z->keys.begin());
+        if(!y->leaf) {
+            std::copy(y->children.begin() + t, y->children.begin() + Node::maxChildren, z->children.begin());
+        }
+        y->n = t - 1;
+
+        // open a gap in x for the median key and new child
+        std::move_backward(x->keys.begin() + i, x->keys.begin() + x->n, x->keys.begin() + x->n + 1);
+        std::copy_backward(x->children.begin() + i + 1, x->children.begin() + x->n + 1, x->children.begin() + x->n + 2);
+        x->keys[i] = std::move(y->keys[t - 1]);
+        x->children[i + 1] = z;
+        x->n += 1;
+    }
+
+    void insert_nonfull(Node* x, const T& k) {
+        while(!x->leaf) {
+            size_t i = findSlot(x, k);
+            if(x->children[i]->n == Node::maxKeys) {
+                splitChild(x, i);
+                if(x->keys[i] < k) {
+                    i++;
+                }
+            }
+            x = x->children[i];
+        }
+        size_t i = findSlot(x, k);
+        std::move_backward(x->keys.begin() + i, x->keys.begin() + x->n, x->keys.begin() + x->n + 1);
+        x->keys[i] = k;
+        x->n += 1;
+    }
+
+    // CLRS deletion - every child descended into is first topped up to >= t keys
+    void deleteKeyHelper(Node* x, const T& k) {
+        while(true) {
+            size_t i = findSlot(x, k);
+            bool found = i < x->n && !(k < x->keys[i]);
+            if(x->leaf) {
+                // Case 1: delete straight from the leaf
+                if(found) {
+                    std::move(x->keys.begin() + i + 1, x->keys.begin() + x->n, x->keys.begin() + i);
+                    x->n -= 1;
+                }
+                return;
+            }
+            if(found) {
+                Node* predec = x->children[i];
+                Node* succ = x->children[i + 1];
+                if(predec->n >= t) { // 2a: replace with predecessor
+                    Node* y = predec;
+                    while(!y->leaf) y = y->children[y->n];
+                    x->keys[i] = y->keys[y->n - 1];
+                    deleteKeyHelper(predec, x->keys[i]);
+                } else if(succ->n >= t) { // 2b: replace with successor
+                    Node* y = succ;
+                    while(!y->leaf) y = y->children[0];
+                    x->keys[i] = y->keys[0];
+                    deleteKeyHelper(succ, x->keys[i]);
+                } else { // 2c: merge k and succ into predec, continue there
+                    mergeNodes(x, i);
+                    x = predec;
+                    continue;
+                }
+                return;
+            }
+            // Case 3: make sure the child on k's path can lose a key
+            if(x->children[i]->n == t - 1) {
+                if(i > 0 && x->children[i - 1]->n >= t) {
+                    borrowFromLeft(x, i);
+                } else if(i < x->n && x->children[i + 1]->n >= t) {
+                    borrowFromRight(x, i);
+                } else if(i < x->n) {
+                    mergeNodes(x, i);
+                } else {
+                    mergeNodes(x, i - 1);
+                    i -= 1;
+                }
+            }
+            x = x->children[i];
+        }
+    }
+
+    // Appends separator k (with new right child) to the open node at level,
+    // opening a new node and pushing k one level up when that node is full
+    T& pushSeparator(std::vector<Node*>& spine, size_t level, const T& k, Node* right, Node* closed, size_t cap) {
+        if(level == spine.size()) { // tree grows a level
+            Node* p = alloc.create();
+            p->leaf = false;
+            p->children[0] = closed;
+            spine.push_back(p);
+        }
+        Node* p = spine[level];
+        if(p->n < cap) {
+            p->keys[p->n] = k;
+            p->children[p->n + 1] = right;
+            return p->keys[p->n++];
+        }
+        Node* q = alloc.create();
+        q->leaf = false;
+        q->children[0] = right;
+        spine[level] = q;
+        return pushSeparator(spine, level + 1, k, q, p, cap);
+    }
+
+    void borrowFromLeft(Node* x, size_t i) {
+        counters.borrow();
+        Node* child = x->children[i];
+        Node* left = x->children[i - 1];
+        std::move_backward(child->keys.begin(), child->keys.begin() + child->n, child->keys.begin() + child->n + 1);
+        child->keys[0] = std::move(x->keys[i - 1]);
+        x->keys[i - 1] = std::move(left->keys[left->n - 1]);
+        if(!child->leaf) {
+            std::copy_backward(child->children.begin(), child->children.begin() + child->n + 1, child->children.begin() + child->n + 2);
+            child->children[0] = left->children[left->n];
+        }
+        child->n += 1;
+        left->n -= 1;
+    }
+
+    void borrowFromRight(Node* x, size_t i) {
+        counters.borrow();
+        Node* child = x->children[i];
+        Node* right = x->children[i + 1];
+        child->keys[child->n] = std::move(x->keys[i]);
+        x->keys[i] = std::move(right->keys[0]);
+        std::move(right->keys.begin() + 1, right->keys.begin() + right->n, right->keys.begin());
+        if(!child->leaf) {
+            child->children[child->n + 1] = right->children[0];
+            std::copy(right->children.begin() + 1, right->children.begin() + right->n + 1, right->children.begin());
+        }
+        child->n += 1;
+        right->n -= 1;
+    }
+
+    // Merges x->keys[i] and children[i+1] into children[i] (they fit in one node)
+    void mergeNodes(Node* x, size_t i) {
+        counters.merge();
+        Node* lhs = x->children[i];
+        Node* rhs = x->children[i + 1];
+        lhs->keys[lhs->n] = std::move(x->keys[i]);
+        std::move(rhs->keys.begin(), rhs->keys.begin() + rhs->n, lhs->keys.begin() + lhs->n + 1);
+        if(!lhs->leaf) {
+            std::copy(rhs->children.begin(), rhs->children.begin() + rhs->n + 1, lhs->children.begin() + lhs->n + 1);
+        }
+        lhs->n += rhs->n + 1;
+
+        std::move(x->keys.begin() + i + 1, x->keys.begin() + x->n, x->keys.begin() + i);
+        std::copy(x->children.begin() + i + 2, x->children.begin() + x->n + 1, x->children.begin() + i + 1);
+        x->n -= 1;
+
+        alloc.destroy(rhs); // children now owned by lhs
+    }
+};
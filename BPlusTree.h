@@ -0,0 +1,353 @@
+#pragma once
+#include <iostream>
+#include <queue>
+#include <utility>
+#include <array>
+#include <algorithm>
+#include <iterator>
+#include <cstddef>
+#include "NodeSearch.h"
+#include "FrozenTree.h"
+
+/*
+B+ Tree
+All keys live in the leaves; interior pages only hold separator copies for
+routing. Leaves are doubly linked, so an iterator streams a range leaf by
+leaf without going back up the tree. Keys are unique (set semantics).
+
+Separator invariant: subtree(children[i]) < keys[i] <= subtree(children[i+1])
+*/
+
+template <typename T, size_t Degree = 32>
+class BPlusTree {
+    static_assert(Degree >= 2, "B+ Tree degree must be at least 2");
+    static constexpr size_t t = Degree;
+    static constexpr size_t maxKeys = 2 * Degree - 1;
+    static constexpr size_t maxChildren = 2 * Degree;
+
+    struct alignas(64) Node {
+        unsigned n = 0; // # keys in page
+        bool leaf = true;
+        Node* prev = nullptr; // sibling leaves (leaf pages only)
+        Node* next = nullptr;
+        std::array<T, maxKeys> keys;
+        std::array<Node*, maxChildren> children;
+        ~Node() {
+            if(!leaf) {
+                for(size_t i=0; i<=n; i++) {
+                    delete children[i];
+                }
+            }
+        }
+    };
+
+    Node* root;
+    Node* tail; // last leaf - lets end() be decremented
+    size_t size_;
+public:
+    class const_iterator {
+        friend class BPlusTree;
+        const Node* leaf;
+        size_t idx;
+        const Node* last;
+        const_iterator(const Node* leaf, size_t idx, const Node* last) : leaf(leaf), idx(idx), last(last) {
+            if(leaf && idx == leaf->n) {
+                advanceLeaf(); // lower_bound past the last key of a leaf
+            } else if(leaf) {
+                prefetchNext();
+            }
+        }
+        void prefetchNext() const {
+            if(leaf->next) {
+                __builtin_prefetch(leaf->next);
+                __builtin_prefetch(reinterpret_cast<const char*>(leaf->next) + 64);
+            }
+        }
+        void advanceLeaf() {
+            leaf = leaf->next;
+            idx = 0;
+            if(leaf) {
+                prefetchNext();
+            }
+        }
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator() : leaf(nullptr), idx(0), last(nullptr) {}
+        reference operator*() const { return leaf->keys[idx]; }
+        pointer operator->() const { return &leaf->keys[idx]; }
+        const_iterator& operator++() {
+            if(++idx == leaf->n) {
+                advanceLeaf();
+            }
+            return *this;
+        }
+        const_iterator operator++(int) { const_iterator tmp = *this; ++*this; return tmp; }
+        const_iterator& operator--() {
+            if(!leaf) { // end() - step back onto the last leaf
+                leaf = last;
+                idx = leaf->n;
+            }
+            while(idx == 0) {
+                leaf = leaf->prev;
+                idx = leaf->n;
+            }
+            idx--;
+            return *this;
+        }
+        const_iterator operator--(int) { const_iterator tmp = *this; --*this; return tmp; }
+        bool operator==(const const_iterator& rhs) const { return leaf == rhs.leaf && idx == rhs.idx; }
+        bool operator!=(const const_iterator& rhs) const { return !(*this == rhs); }
+    };
+    using iterator = const_iterator; // keys are immutable once inserted
+
+    BPlusTree() : root(new Node()), size_(0) { tail = root; }
+    ~BPlusTree() { delete root; }
+    BPlusTree(const BPlusTree& tree) = delete; // leaf links make deep copies non-trivial
+    BPlusTree(BPlusTree&& tree) noexcept : root(std::exchange(tree.root, nullptr)), tail(tree.tail), size_(std::exchange(tree.size_, 0)) {
+        tree.root = tree.tail = new Node();
+    }
+    BPlusTree& operator=(const BPlusTree& rhs) = delete;
+    BPlusTree& operator=(BPlusTree&& rhs) noexcept {
+        if(this != &rhs) {
+            std::swap(root, rhs.root);
+            std::swap(tail, rhs.tail);
+            std::swap(size_, rhs.size_);
+        }
+        return *this;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    const_iterator begin() const {
+        const Node* x = root;
+        while(!x->leaf) x = x->children[0];
+        return const_iterator(x, 0, tail);
+    }
+    const_iterator end() const { return const_iterator(nullptr, 0, tail); }
+
+    FrozenTree<T> freeze() const { return FrozenTree<T>(begin(), end()); } // read-only pointer-free copy
+
+    // first key not less than k
+    const_iterator lower_bound(const T& k) const {
+        const Node* x = findLeaf(k);
+        return const_iterator(x, nodeLowerBound(x->keys.data(), x->n, k), tail);
+    }
+    // first key greater than k
+    const_iterator upper_bound(const T& k) const {
+        const Node* x = findLeaf(k);
+        return const_iterator(x, nodeUpperBound(x->keys.data(), x->n, k), tail);
+    }
+    const_iterator find(const T& k) const {
+        const_iterator it = lower_bound(k);
+        return (it != end() && !(k < *it)) ? it : end();
+    }
+    bool contains(const T& k) const { return find(k) != end(); }
+
+    // Streams every key in [lo, hi) to f
+    template <typename F>
+    void scan(const T& lo, const T& hi, F&& f) const {
+        for(const_iterator it = lower_bound(lo); it != end() && *it < hi; ++it) {
+            f(*it);
+        }
+    }
+
+    bool insert(const T& k) {
+        if(root->n == maxKeys) { // preemptively split!
+            Node* s = new Node();
+            s->leaf = false;
+            s->children[0] = root;
+            root = s;
+            splitChild(s, 0);
+        }
+        Node* x = root;
+        while(!x->leaf) {
+            size_t i = nodeUpperBound(x->keys.data(), x->n, k);
+            if(x->children[i]->n == maxKeys) {
+                splitChild(x, i);
+                if(!(k < x->keys[i])) {
+                    i++;
+                }
+            }
+            x = x->children[i];
+        }
+        size_t i = nodeLowerBound(x->keys.data(), x->n, k);
+        if(i < x->n && !(k < x->keys[i])) {
+            return false; // already present
+        }
+        std::move_backward(x->keys.begin() + i, x->keys.begin() + x->n, x->keys.begin() + x->n + 1);
+        x->keys[i] = k;
+        x->n += 1;
+        size_++;
+        return true;
+    }
+
+    // Top-down like BTree::remove - every child descended into is topped up first
+    bool remove(const T& k) {
+        Node* x = root;
+        while(!x->leaf) {
+            size_t i = nodeUpperBound(x->keys.data(), x->n, k);
+            if(x->children[i]->n == t - 1) {
+                if(i > 0 && x->children[i - 1]->n >= t) {
+                    borrowFromLeft(x, i);
+                } else if(i < x->n && x->children[i + 1]->n >= t) {
+                    borrowFromRight(x, i);
+                } else if(i < x->n) {
+                    mergeNodes(x, i);
+                } else {
+                    mergeNodes(x, i - 1);
+                    i -= 1;
+                }
+            }
+            if(x == root && x->n == 0) { // root merged away
+                root = x->children[0];
+                x->leaf = true;
+                delete x;
+                x = root;
+                continue;
+            }
+            x = x->children[i];
+        }
+        size_t i = nodeLowerBound(x->keys.data(), x->n, k);
+        if(i == x->n || k < x->keys[i]) {
+            return false;
+        }
+        std::move(x->keys.begin() + i + 1, x->keys.begin() + x->n, x->keys.begin() + i);
+        x->n -= 1;
+        size_--;
+        return true;
+    }
+
+    void printBPlusTree() const {
+        std::queue<std::pair<const Node*, int>> q;
+        int lvl = 0;
+        q.push({root, 0});
+        while(!q.empty()) {
+            std::pair<const Node*, int> curr = q.front();
+            q.pop();
+            if(curr.second > lvl) {
+                std::cout << "\n";
+                lvl = curr.second;
+            }
+            for(size_t i=0; i<curr.first->n; i++) {
+                std::cout << curr.first->keys[i] << " ";
+            }
+            std::cout << "\t";
+            if(!curr.first->leaf) {
+                for(size_t i=0; i<=curr.first->n; i++) {
+                    q.push({curr.first->children[i], curr.second+1});
+                }
+            }
+        }
+        std::cout << "\n";
+    }
+private:
+    const Node* findLeaf(const T& k) const {
+        const Node* x = root;
+        while(!x->leaf) {
+            x = x->children[nodeUpperBound(x->keys.data(), x->n, k)];
+        }
+        return x;
+    }
+
+    void splitChild(Node* x, size_t i) {
+        Node* y = x->children[i];
+        Node* z = new Node();
+        z->leaf = y->leaf;
+        T separator;
+        if(y->leaf) {
+            // leaf split: z takes the upper t keys, its first key is copied up
+            z->n = t;
+            std::move(y->keys.begin() + t - 1, y->keys.begin() + maxKeys, z->keys.begin());
+            y->n = t - 1;
+            separator = z->keys[0];
+            z->next = y->next;
+            z->prev = y;
+            if(y->next) {
+                y->next->prev = z;
+            } else {
+                tail = z;
+            }
+            y->next = z;
+        } else {
+            // interior split: the median moves up as in BTree::splitChild
+            z->n = t - 1;
+            std::move(y->keys.begin() + t, y->keys.begin() + maxKeys, z->keys.begin());
+            std::copy(y->children.begin() + t, y->children.begin() + maxChildren, z->children.begin());
+            y->n = t - 1;
+            separator = std::move(y->keys[t - 1]);
+        }
+        std::move_backward(x->keys.begin() + i, x->keys.begin() + x->n, x->keys.begin() + x->n + 1);
+        std::copy_backward(x->children.begin() + i + 1, x->children.begin() + x->n + 1, x->children.begin() + x->n + 2);
+        x->keys[i] = std::move(separator);
+        x->children[i + 1] = z;
+        x->n += 1;
+    }
+
+    void borrowFromLeft(Node* x, size_t i) {
+        Node* child = x->children[i];
+        Node* left = x->children[i - 1];
+        std::move_backward(child->keys.begin(), child->keys.begin() + child->n, child->keys.begin() + child->n + 1);
+        if(child->leaf) {
+            child->keys[0] = std::move(left->keys[left->n - 1]);
+            x->keys[i - 1] = child->keys[0];
+        } else {
+            child->keys[0] = std::move(x->keys[i - 1]);
+            x->keys[i - 1] = std::move(left->keys[left->n - 1]);
+            std::copy_backward(child->children.begin(), child->children.begin() + child->n + 1, child->children.begin() + child->n + 2);
+            child->children[0] = left->children[left->n];
+        }
+        child->n += 1;
+        left->n -= 1;
+    }
+
+    void borrowFromRight(Node* x, size_t i) {
+        Node* child = x->children[i];
+        Node* right = x->children[i + 1];
+        if(child->leaf) {
+            child->keys[child->n] = std::move(right->keys[0]);
+            std::move(right->keys.begin() + 1, right->keys.begin() + right->n, right->keys.begin());
+            x->keys[i] = right->keys[0];
+        } else {
+            child->keys[child->n] = std::move(x->keys[i]);
+            x->keys[i] = std::move(right->keys[0]);
+            std::move(right->keys.begin() + 1, right->keys.begin() + right->n, right->keys.begin());
+            child->children[child->n + 1] = right->children[0];
+            std::copy(right->children.begin() + 1, right->children.begin() + right->n + 1, right->children.begin());
+        }
+        child->n += 1;
+        right->n -= 1;
+    }
+
+    // Merges children[i+1] into children[i]; interior merges pull the separator down
+    void mergeNodes(Node* x, size_t i) {
+        Node* lhs = x->children[i];
+        Node* rhs = x->children[i + 1];
+        if(lhs->leaf) {
+            std::move(rhs->keys.begin(), rhs->keys.begin() + rhs->n, lhs->keys.begin() + lhs->n);
+            lhs->n += rhs->n;
+            lhs->next = rhs->next;
+            if(rhs->next) {
+                rhs->next->prev = lhs;
+            } else {
+                tail = lhs;
+            }
+        } else {
+            lhs->keys[lhs->n] = std::move(x->keys[i]);
+            std::move(rhs->keys.begin(), rhs->keys.begin() + rhs->n, lhs->keys.begin() + lhs->n + 1);
+            std::copy(rhs->children.begin(), rhs->children.begin() + rhs->n + 1, lhs->children.begin() + lhs->n + 1);
+            lhs->n += rhs->n + 1;
+        }
+        std::move(x->keys.begin() + i + 1, x->keys.begin() + x->n, x->keys.begin() + i);
+        std::copy(x->children.begin() + i + 2, x->children.begin() + x->n + 1, x->children.begin() + i + 1);
+        x->n -= 1;
+
+        rhs->leaf = true; // children now owned by lhs
+        delete rhs;
+    }
+};
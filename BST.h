@@ -1,6 +1,9 @@
 #ifndef BST_H
 #define BST_H
 #include <iostream>
+#include <vector>
+#include "NodeAllocator.h"
+#include "FrozenTree.h"
 
 template <typename T>
 struct Node {
@@ -10,16 +13,16 @@ struct Node {
     T key;
     Node() : left(nullptr), right(nullptr), key(0) {}
     Node(T key) : left(nullptr), right(nullptr), key(key) {}
-    ~Node() { delete left; delete right; }
 };
 
-template <typename T>
+// Nodes come from the Alloc policy (see NodeAllocator.h)
+template <typename T, template <typename> class Alloc = SlabAllocator>
 class BST {
 public:
     BST() : root(nullptr) {}
-    BST(const BST<T>& tree) = delete; // no copy
-    BST(BST<T>&& tree) = delete; // no moving
-    ~BST() { delete root; }
+    BST(const BST& tree) = delete; // no copy
+    BST(BST&& tree) = delete; // no moving
+    ~BST() { destroyBinaryTree(root, alloc, [](Node<T>* x) { return x == nullptr; }); }
 
     Node<T>* maxNode(); // max but node
     T maxVal();
@@ -34,8 +37,10 @@ public:
     Node<T>* successor(Node<T>* node); // successor node addr
 
     void printInOrder(); // in order traversal
+    FrozenTree<T> freeze(); // read-only copy with no pointers - O(log n) per lookup whatever this tree's shape
     bool validate(); // validation
 private:
+    Alloc<Node<T>> alloc;
     Node<T>* root;
 
     bool validateHelper(Node<T>* u, T low, T high);
@@ -43,8 +48,8 @@ private:
     void deleteHelper(Node<T>* node);
 };
 
-template <typename T>
-Node<T>* BST<T>::predecessor(Node<T>* node) {
+template <typename T, template <typename> class Alloc>
+Node<T>* BST<T, Alloc>::predecessor(Node<T>* node) {
     if (node->left != nullptr) {
         return minNode(node->left); // Predecessor is the max node in the left subtree
     }
@@ -57,8 +62,8 @@ Node<T>* BST<T>::predecessor(Node<T>* node) {
     return parent; // Find lowest ancestor whose left child is also ancestor
 }
 
-template <typename T>
-Node<T>* BST<T>::successor(Node<T>* node) {
+template <typename T, template <typename> class Alloc>
+Node<T>* BST<T, Alloc>::successor(Node<T>* node) {
     if (node->right != nullptr) {
         return minNode(node->right); // Successor is the min node in the right subtree
     }
@@ -71,13 +76,22 @@ Node<T>* BST<T>::successor(Node<T>* node) {
     return parent; // Find lowest ancestor whose right child is also an ancestor
 }
 
-template <typename T>
-bool BST<T>::validate() {
+template <typename T, template <typename> class Alloc>
+FrozenTree<T> BST<T, Alloc>::freeze() {
+    std::vector<T> keys;
+    for(Node<T>* x = minNode(root); x != nullptr; x = successor(x)) {
+        keys.push_back(x->key);
+    }
+    return FrozenTree<T>(keys.begin(), keys.end());
+}
+
+template <typename T, template <typename> class Alloc>
+bool BST<T, Alloc>::validate() {
     return validateHelper(root, minVal(), maxVal());
 }   
 
-template <typename T>
-bool BST<T>::validateHelper(Node<T>* u, T low, T high) {
+template <typename T, template <typename> class Alloc>
+bool BST<T, Alloc>::validateHelper(Node<T>* u, T low, T high) {
     if(!u) {
         return true; // base
     }
@@ -87,126 +101,130 @@ bool BST<T>::validateHelper(Node<T>* u, T low, T high) {
     return validateHelper(u->left, low, u->key) && validateHelper(u->right, u->key, high);
 }
 
-template <typename T>
-void BST<T>::deleteNode(T key) {
+template <typename T, template <typename> class Alloc>
+void BST<T, Alloc>::deleteNode(T key) {
     Node<T>* node = search(key);
+    if(node == nullptr) {
+        return;
+    }
     deleteHelper(node);
+    alloc.destroy(node);
 }
 
-template <typename T>
-void BST<T>::transplant(Node<T>* u, Node<T>* v) { // make v replace u
-    if(u.parent == nullptr) {
+template <typename T, template <typename> class Alloc>
+void BST<T, Alloc>::transplant(Node<T>* u, Node<T>* v) { // make v replace u
+    if(u->parent == nullptr) {
         root = v;
     }
-    else if(u == u.parent.left) {
-        u.parent.left = v;
+    else if(u == u->parent->left) {
+        u->parent->left = v;
     }
     else {
-        u.p.right = v;
+        u->parent->right = v;
     }
     if(v != nullptr) {
-        v.parent = u.parent;
+        v->parent = u->parent;
     }
 }
 
-template <typename T>
-void BST<T>::deleteHelper(Node<T>* z) {
-    if(z.left == nullptr) {
-        transplant(z, z.right); // no left child - call successor
+template <typename T, template <typename> class Alloc>
+void BST<T, Alloc>::deleteHelper(Node<T>* z) {
+    if(z->left == nullptr) {
+        transplant(z, z->right); // no left child - call successor
     }
-    else if(z.right == nullptr) {
-        transplant(z, z.left); // has left but no right - replace by predecessor
+    else if(z->right == nullptr) {
+        transplant(z, z->left); // has left but no right - replace by predecessor
     }
     else { // has two children
-        Node<T>* y = minNode(z.right);
-        if(y.parent != z) {
-            transplant(y, y.right);
-            y.right = z.right;
-            y.right.parent = y;
+        Node<T>* y = minNode(z->right);
+        if(y->parent != z) {
+            transplant(y, y->right);
+            y->right = z->right;
+            y->right->parent = y;
         }
         transplant(z, y);
-        y.left = z.left;
-        y.left.parent = y;
+        y->left = z->left;
+        y->left->parent = y;
     }
 }
 
-template <typename T>
-Node<T>* BST<T>::maxNode() {
+template <typename T, template <typename> class Alloc>
+Node<T>* BST<T, Alloc>::maxNode() {
     Node<T>* x = root;
-    while(x != nullptr && x.right != nullptr) {
-        x = x.right;
+    while(x != nullptr && x->right != nullptr) {
+        x = x->right;
     }
     return x;
 }
 
-template <typename T>
-T BST<T>::maxVal() {
+template <typename T, template <typename> class Alloc>
+T BST<T, Alloc>::maxVal() {
     Node<T>* x = root;
-    while(x != nullptr && x.right != nullptr) {
-        x = x.right;
+    while(x != nullptr && x->right != nullptr) {
+        x = x->right;
     }
     if(x == nullptr) {
         return 0;
     } else {
-        return x.key;
+        return x->key;
     }
 }
 
-template <typename T>
-Node<T>* BST<T>::minNode(Node<T>* node) {
+template <typename T, template <typename> class Alloc>
+Node<T>* BST<T, Alloc>::minNode(Node<T>* node) {
     Node<T>* x = node;
-    while(x != nullptr && x.left != nullptr) {
-        x = x.left;
+    while(x != nullptr && x->left != nullptr) {
+        x = x->left;
     }
     return x;
 }
 
-template <typename T>
-T BST<T>::minVal() {
-    Node<T> x = root;
-    while(x != nullptr && x.left != nullptr) {
-        x = x.left;
+template <typename T, template <typename> class Alloc>
+T BST<T, Alloc>::minVal() {
+    Node<T>* x = root;
+    while(x != nullptr && x->left != nullptr) {
+        x = x->left;
     }
     if(x == nullptr) {
         return 0;
     }
     else {
-        return x.key;
+        return x->key;
     }
 }
 
-template <typename T>
-void BST<T>::insert(T key) { // insertion only happens at the leaf, so no left or right to z
+template <typename T, template <typename> class Alloc>
+void BST<T, Alloc>::insert(T key) { // insertion only happens at the leaf, so no left or right to z
     Node<T>* y = nullptr;
     Node<T>* x = root;
-    Node<T>* z(nullptr, nullptr, key);
+    Node<T>* z = alloc.create(key);
     while(x != nullptr) { // propagates down the tree
         y = x;
-        if(z.key < x.key) {
-            x = x.left;
+        if(z->key < x->key) {
+            x = x->left;
         } else {
-            x = x.right;
+            x = x->right;
         }
     }
-    z.parent = y;
+    z->parent = y;
     if(y == nullptr) {
         root = z;
-    } else if(z.key < y.key) {
-        y.left = z;
+    } else if(z->key < y->key) {
+        y->left = z;
     } else {
-        y.right = z;
+        y->right = z;
     }
 }
 
-template <typename T>
-Node<T>* BST<T>::search(T key) {
+template <typename T, template <typename> class Alloc>
+Node<T>* BST<T, Alloc>::search(T key) {
     // implementing iteratively 
     Node<T>* x = root;
-    while(x != nullptr && key != x.key) {
-        if(key < x.key) {
-            x = x.left;
+    while(x != nullptr && key != x->key) {
+        if(key < x->key) {
+            x = x->left;
         } else {
-            x = x.right;
+            x = x->right;
         }
     }
     return x;
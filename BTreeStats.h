@@ -0,0 +1,108 @@
+#pragma once
+#include <iostream>
+#include <array>
+#include <algorithm>
+#include <cstddef>
+
+/*
+B-Tree statistics
+BTree takes a stats policy as its last template parameter, e.g.
+BTree<int, 16, SlabAllocator, CountingStats>. The tree reports events to it
+from the hot paths (splits, merges, borrows, nodes visited by lookups):
+    NoStats (the default)  - every hook is an empty inline function and the
+                             policy is an empty [[no_unique_address]] member,
+                             so a plain BTree compiles to the same code as before
+    CountingStats          - plain counters, one increment per event
+
+tree.stats() returns a BTreeStats snapshot. The shape (height, nodes, fill
+histogram, bytes) comes from walking the tree at that moment and is always
+filled in; the event counters are only non-zero under CountingStats.
+*/
+
+struct BTreeStats {
+    static constexpr size_t fillBuckets = 10;
+
+    // shape, measured by stats()
+    size_t height = 0; // levels - a lone leaf root is height 1
+    size_t nodes = 0;
+    size_t keys = 0;
+    size_t capacity = 0; // max keys per node, 2t-1
+    size_t bytes = 0; // node memory reachable from the tree, including key/child vectors
+    std::array<size_t, fillBuckets> fill{}; // fill[i]: nodes holding [i/10, (i+1)/10) of capacity, full nodes in the last
+
+    // events since construction or the last resetStats() - CountingStats only
+    size_t splits = 0;
+    size_t merges = 0;
+    size_t borrows = 0; // keys rotated through the parent from a sibling
+    size_t lookups = 0;
+    size_t nodesVisited = 0; // by lookups
+    size_t keysCompared = 0; // by lookups - every key of a node for the SIMD kernels, an upper bound for the scalar scan
+
+    double averageFill() const {
+        return nodes ? static_cast<double>(keys) / (nodes * capacity) : 0.0;
+    }
+    double comparisonsPerLookup() const {
+        return lookups ? static_cast<double>(keysCompared) / lookups : 0.0;
+    }
+
+    // Adds a node holding n keys to the shape counts
+    void addNode(size_t n, size_t nodeBytes) {
+        nodes += 1;
+        keys += n;
+        bytes += nodeBytes;
+        fill[std::min(n * fillBuckets / capacity, fillBuckets - 1)] += 1;
+    }
+
+    void print(std::ostream& out = std::cout) const {
+        out << "height " << height << ", " << nodes << " nodes, " << keys << " keys, "
+            << bytes << " bytes, average fill " << averageFill() << "\n";
+        out << "fill histogram:";
+        for(size_t i=0; i<fillBuckets; i++) {
+            out << " " << fill[i];
+        }
+        out << "\n";
+        out << "splits " << splits << ", merges " << merges << ", borrows " << borrows << "\n";
+        out << "lookups " << lookups << ", nodes/lookup " << (lookups ? static_cast<double>(nodesVisited) / lookups : 0.0)
+            << ", comparisons/lookup " << comparisonsPerLookup() << "\n";
+    }
+};
+
+// Disabled - every hook compiles away
+struct NoStats {
+    static constexpr bool enabled = false;
+    void split() {}
+    void merge() {}
+    void borrow() {}
+    void lookup() {}
+    void visit(size_t) {}
+    void reset() {}
+    void report(BTreeStats&) const {}
+};
+
+struct CountingStats {
+    static constexpr bool enabled = true;
+    size_t splits = 0;
+    size_t merges = 0;
+    size_t borrows = 0;
+    size_t lookups = 0;
+    size_t nodesVisited = 0;
+    size_t keysCompared = 0;
+
+    void split() { splits++; }
+    void merge() { merges++; }
+    void borrow() { borrows++; }
+    void lookup() { lookups++; }
+    void visit(size_t n) {
+        nodesVisited++;
+        keysCompared += n;
+    }
+    void reset() { *this = CountingStats(); }
+    void report(BTreeStats& s) const {
+        s.splits = splits;
+        s.merges = merges;
+        s.borrows = borrows;
+        s.lookups = lookups;
+        s.nodesVisited = nodesVisited;
+        s.keysCompared = keysCompared;
+    }
+};
@@ -0,0 +1,379 @@
+#pragma once
+#include <iostream>
+#include <queue>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <iterator>
+#include <cstddef>
+#include <cstdint>
+#include "NodeSearch.h"
+
+/*
+Write-optimized B-Tree (B-epsilon tree)
+Keys live in the leaves as in a B+ Tree, but every interior node also
+carries a sorted buffer of pending messages (insert or erase a key).
+insert() and remove() only add a message to the root's buffer. Once a
+buffer holds more than BufferCapacity messages, everything bound for the
+child with the most pending messages is moved down in one batch - merged
+into that child's buffer, or applied to it when it is a leaf - so the cost
+of reaching a leaf is shared by the whole batch. Leaves are larger than
+interior nodes, since a batch rewrites a leaf in one sequential pass.
+
+The buffer is sorted, so the messages bound for each child form one run;
+bufStart[i] is where children[i]'s run begins, and a lookup only probes
+that run. A buffer holds at most one message per key, and a message higher
+up is always newer than one below it, so contains() answers from the first
+message it meets on the way down and only reaches the leaf if none.
+
+Separator invariant: subtree(children[i]) < keys[i] <= subtree(children[i+1])
+*/
+
+template <typename T, size_t Degree = 16, size_t BufferCapacity = 64 * Degree, size_t LeafCapacity = 16 * Degree>
+class BufferedBTree {
+    static_assert(Degree >= 2, "B-Tree degree must be at least 2");
+    static_assert(BufferCapacity >= 2 * Degree, "buffer must hold at least one message per child");
+    static_assert(LeafCapacity >= 2, "leaves must hold at least two keys");
+    static constexpr size_t t = Degree;
+    static constexpr size_t maxKeys = 2 * Degree - 1;
+
+    enum class Op : unsigned char { Insert, Erase };
+
+    struct Node {
+        bool leaf = true;
+        std::vector<T> keys; // leaf keys, or separators of an interior node
+        std::vector<Node*> children;
+        std::vector<T> bufKeys; // pending messages, sorted and unique by key
+        std::vector<Op> bufOps;
+        std::vector<uint32_t> bufStart; // children.size()+1 run boundaries into the buffer
+
+        size_t capacity() const { return leaf ? LeafCapacity : maxKeys; }
+        size_t minimum() const { return leaf ? LeafCapacity / 2 : t - 1; }
+        bool overfull() const { return keys.size() > capacity(); }
+        size_t pending(size_t i) const { return bufStart[i + 1] - bufStart[i]; }
+    };
+
+    Node* root;
+    std::vector<T> scratchKeys; // merge targets, swapped with the merged vectors so capacity is reused
+    std::vector<Op> scratchOps;
+public:
+    BufferedBTree() : root(new Node()) {}
+    ~BufferedBTree() { destroy(root); }
+    BufferedBTree(const BufferedBTree& tree) = delete;
+    BufferedBTree& operator=(const BufferedBTree& rhs) = delete;
+
+    void insert(const T& k) { upsert(k, Op::Insert); }
+    void remove(const T& k) { upsert(k, Op::Erase); }
+
+    bool contains(const T& k) const {
+        const Node* x = root;
+        while(!x->leaf) {
+            size_t i = nodeUpperBound(x->keys.data(), x->keys.size(), k);
+            __builtin_prefetch(x->children[i]); // overlap the next node's miss with the buffer probe
+            size_t lo = x->bufStart[i];
+            size_t j = lo + nodeLowerBound(x->bufKeys.data() + lo, x->bufStart[i + 1] - lo, k);
+            if(j < x->bufStart[i + 1] && !(k < x->bufKeys[j])) {
+                return x->bufOps[j] == Op::Insert; // newest word on k
+            }
+            x = x->children[i];
+        }
+        size_t i = nodeLowerBound(x->keys.data(), x->keys.size(), k);
+        return i < x->keys.size() && !(k < x->keys[i]);
+    }
+
+    // Pushes every pending message down to the leaves
+    void flush() {
+        while(!root->leaf) {
+            flushAll(root);
+            if(!growRoot()) {
+                break;
+            }
+        }
+        shrinkRoot();
+    }
+
+    void printBTree() const {
+        std::queue<std::pair<const Node*, int>> q;
+        int lvl = 0;
+        q.push({root, 0});
+        while(!q.empty()) {
+            std::pair<const Node*, int> curr = q.front();
+            q.pop();
+            if(curr.second > lvl) {
+                std::cout << "\n";
+                lvl = curr.second;
+            }
+            for(const T& key : curr.first->keys) {
+                std::cout << key << " ";
+            }
+            if(!curr.first->bufKeys.empty()) {
+                std::cout << "[" << curr.first->bufKeys.size() << " pending] ";
+            }
+            std::cout << "\t";
+            for(const Node* child : curr.first->children) {
+                q.push({child, curr.second + 1});
+            }
+        }
+        std::cout << "\n";
+    }
+private:
+    void upsert(const T& k, Op op) {
+        if(root->leaf) {
+            applyToLeaf(root, &k, &op, 1);
+        } else {
+            size_t i = nodeUpperBound(root->keys.data(), root->keys.size(), k);
+            size_t lo = root->bufStart[i];
+            size_t j = lo + nodeLowerBound(root->bufKeys.data() + lo, root->bufStart[i + 1] - lo, k);
+            if(j < root->bufStart[i + 1] && !(k < root->bufKeys[j])) {
+                root->bufOps[j] = op; // supersedes the pending message
+            } else {
+                root->bufKeys.insert(root->bufKeys.begin() + j, k);
+                root->bufOps.insert(root->bufOps.begin() + j, op);
+                for(size_t q=i+1; q<root->bufStart.size(); q++) {
+                    root->bufStart[q] += 1;
+                }
+            }
+            if(root->bufKeys.size() > BufferCapacity) {
+                flushBusiest(root);
+            }
+        }
+        while(growRoot()) {}
+        shrinkRoot();
+    }
+
+    // Splits an overfull root under a new root; false if nothing to do
+    bool growRoot() {
+        if(!root->overfull()) {
+            return false;
+        }
+        Node* s = new Node();
+        s->leaf = false;
+        s->children.push_back(root);
+        s->bufStart = {0, 0};
+        root = s;
+        fixChild(s, 0);
+        return true;
+    }
+
+    // An interior root left with a single child hands over its buffer and steps aside
+    void shrinkRoot() {
+        while(!root->leaf && root->keys.empty()) {
+            Node* child = root->children[0];
+            pushDown(root, 0);
+            if(child->overfull()) {
+                fixChild(root, 0); // the messages split the child - keep this root
+                return;
+            }
+            delete root;
+            root = child;
+        }
+    }
+
+    // Moves one batch at a time - the longest run - out of x's buffer
+    void flushBusiest(Node* x) {
+        while(x->bufKeys.size() > BufferCapacity) {
+            size_t best = 0;
+            for(size_t i=1; i<x->children.size(); i++) {
+                if(x->pending(i) > x->pending(best)) {
+                    best = i;
+                }
+            }
+            pushDown(x, best);
+            fixChild(x, best);
+        }
+    }
+
+    // Empties every buffer in the subtree at x
+    void flushAll(Node* x) {
+        for(size_t i=0; i<x->children.size(); i++) {
+            pushDown(x, i);
+            if(!x->children[i]->leaf) {
+                flushAll(x->children[i]);
+            }
+        }
+        // children may have split or drained - settle them once the buffer is empty
+        for(size_t i=0; i<x->children.size(); i++) {
+            size_t before = x->children.size();
+            fixChild(x, i);
+            if(x->children.size() > before) {
+                i += x->children.size() - before;
+            }
+        }
+    }
+
+    // Moves children[i]'s run out of x's buffer into the child, flushing the child in turn if it overflows
+    void pushDown(Node* x, size_t i) {
+        size_t lo = x->bufStart[i], hi = x->bufStart[i + 1];
+        if(lo == hi) {
+            return;
+        }
+        Node* child = x->children[i];
+        if(child->leaf) {
+            applyToLeaf(child, x->bufKeys.data() + lo, x->bufOps.data() + lo, hi - lo);
+        } else {
+            mergeIntoBuffer(child, x->bufKeys.data() + lo, x->bufOps.data() + lo, hi - lo);
+        }
+        x->bufKeys.erase(x->bufKeys.begin() + lo, x->bufKeys.begin() + hi);
+        x->bufOps.erase(x->bufOps.begin() + lo, x->bufOps.begin() + hi);
+        for(size_t q=i+1; q<x->bufStart.size(); q++) {
+            x->bufStart[q] -= hi - lo;
+        }
+        if(!child->leaf && child->bufKeys.size() > BufferCapacity) {
+            flushBusiest(child);
+        }
+    }
+
+    // One merge pass of a sorted batch into a leaf
+    void applyToLeaf(Node* leaf, const T* keys, const Op* ops, size_t m) {
+        scratchKeys.clear();
+        size_t i = 0, j = 0;
+        while(i < leaf->keys.size() || j < m) {
+            if(j == m || (i < leaf->keys.size() && leaf->keys[i] < keys[j])) {
+                scratchKeys.push_back(std::move(leaf->keys[i++]));
+            } else {
+                if(i < leaf->keys.size() && !(keys[j] < leaf->keys[i])) {
+                    i++; // same key - the message decides
+                }
+                if(ops[j] == Op::Insert) {
+                    scratchKeys.push_back(keys[j]);
+                }
+                j++;
+            }
+        }
+        leaf->keys.swap(scratchKeys);
+    }
+
+    // One merge pass of a sorted batch into x's buffer; the batch is newer on equal keys
+    void mergeIntoBuffer(Node* x, const T* keys, const Op* ops, size_t m) {
+        scratchKeys.clear();
+        scratchOps.clear();
+        size_t i = 0, j = 0;
+        while(i < x->bufKeys.size() || j < m) {
+            if(j == m || (i < x->bufKeys.size() && x->bufKeys[i] < keys[j])) {
+                scratchKeys.push_back(std::move(x->bufKeys[i]));
+                scratchOps.push_back(x->bufOps[i++]);
+            } else {
+                if(i < x->bufKeys.size() && !(keys[j] < x->bufKeys[i])) {
+                    i++; // older message on the same key is dropped
+                }
+                scratchKeys.push_back(keys[j]);
+                scratchOps.push_back(ops[j++]);
+            }
+        }
+        x->bufKeys.swap(scratchKeys);
+        x->bufOps.swap(scratchOps);
+        rebuildStarts(x);
+    }
+
+    void rebuildStarts(Node* x) {
+        x->bufStart.resize(x->children.size() + 1);
+        x->bufStart[0] = 0;
+        for(size_t i=0; i<x->keys.size(); i++) {
+            size_t lo = x->bufStart[i];
+            x->bufStart[i + 1] = lo + nodeLowerBound(x->bufKeys.data() + lo, x->bufKeys.size() - lo, x->keys[i]);
+        }
+        x->bufStart.back() = x->bufKeys.size();
+    }
+
+    // Brings children[i] back within bounds after a batch: an overfull child
+    // is halved until every piece fits, an underfull one is merged into a
+    // sibling - and when the two do not fit in one node, the merged node is
+    // halved again, which shares their keys evenly
+    void fixChild(Node* x, size_t i) {
+        if(x->children[i]->overfull()) {
+            size_t end = i + 1;
+            for(size_t j=i; j<end;) {
+                if(x->children[j]->overfull()) {
+                    splitChild(x, j);
+                    end++;
+                } else {
+                    j++;
+                }
+            }
+            return;
+        }
+        if(x->children[i]->keys.size() >= x->children[i]->minimum() || x->keys.empty()) {
+            return;
+        }
+        size_t l = i < x->keys.size() ? i : i - 1; // merge children[l+1] into children[l]
+        Node* lhs = x->children[l];
+        Node* rhs = x->children[l + 1];
+        if(lhs->leaf) {
+            lhs->keys.insert(lhs->keys.end(), std::make_move_iterator(rhs->keys.begin()), std::make_move_iterator(rhs->keys.end()));
+        } else {
+            // rhs messages are all greater, so the two buffers simply concatenate
+            uint32_t shift = lhs->bufKeys.size();
+            lhs->keys.push_back(x->keys[l]);
+            lhs->keys.insert(lhs->keys.end(), std::make_move_iterator(rhs->keys.begin()), std::make_move_iterator(rhs->keys.end()));
+            lhs->children.insert(lhs->children.end(), rhs->children.begin(), rhs->children.end());
+            lhs->bufKeys.insert(lhs->bufKeys.end(), std::make_move_iterator(rhs->bufKeys.begin()), std::make_move_iterator(rhs->bufKeys.end()));
+            lhs->bufOps.insert(lhs->bufOps.end(), rhs->bufOps.begin(), rhs->bufOps.end());
+            for(size_t q=1; q<rhs->bufStart.size(); q++) {
+                lhs->bufStart.push_back(rhs->bufStart[q] + shift);
+            }
+        }
+        size_t seam = lhs->children.size() - rhs->children.size(); // rhs's first child in lhs
+        x->keys.erase(x->keys.begin() + l);
+        x->children.erase(x->children.begin() + l + 1);
+        x->bufStart.erase(x->bufStart.begin() + l + 1); // the two runs join
+        delete rhs;
+        if(!lhs->leaf) {
+            // a keyless node could not settle its only child, so two underfull children may now meet
+            fixChild(lhs, seam - 1);
+            if(seam < lhs->children.size()) {
+                fixChild(lhs, seam);
+            }
+        }
+        if(lhs->bufKeys.size() > BufferCapacity) {
+            flushBusiest(lhs); // the joined buffers hold more than one node's worth
+        }
+        fixChild(x, l); // halve it if it overflowed, merge on if it is still underfull
+    }
+
+    // Halves children[i]; the upper half becomes children[i+1], taking its
+    // share of the child's buffer and of x's
+    void splitChild(Node* x, size_t i) {
+        Node* y = x->children[i];
+        Node* z = new Node();
+        z->leaf = y->leaf;
+        size_t mid = y->keys.size() / 2;
+        T separator;
+        if(y->leaf) {
+            // leaf split: z's first key is copied up
+            z->keys.assign(std::make_move_iterator(y->keys.begin() + mid), std::make_move_iterator(y->keys.end()));
+            y->keys.resize(mid);
+            separator = z->keys[0];
+        } else {
+            // interior split: the median moves up, runs of children[mid+1..] move with them
+            separator = std::move(y->keys[mid]);
+            size_t cut = y->bufStart[mid + 1];
+            z->keys.assign(std::make_move_iterator(y->keys.begin() + mid + 1), std::make_move_iterator(y->keys.end()));
+            z->children.assign(y->children.begin() + mid + 1, y->children.end());
+            z->bufKeys.assign(std::make_move_iterator(y->bufKeys.begin() + cut), std::make_move_iterator(y->bufKeys.end()));
+            z->bufOps.assign(y->bufOps.begin() + cut, y->bufOps.end());
+            for(size_t q=mid+1; q<y->bufStart.size(); q++) {
+                z->bufStart.push_back(y->bufStart[q] - cut);
+            }
+            y->keys.resize(mid);
+            y->children.resize(mid + 1);
+            y->bufKeys.resize(cut);
+            y->bufOps.resize(cut);
+            y->bufStart.resize(mid + 2);
+        }
+        size_t lo = x->bufStart[i];
+        uint32_t cut = lo + nodeLowerBound(x->bufKeys.data() + lo, x->bufStart[i + 1] - lo, separator);
+        x->keys.insert(x->keys.begin() + i, std::move(separator));
+        x->children.insert(x->children.begin() + i + 1, z);
+        x->bufStart.insert(x->bufStart.begin() + i + 1, cut);
+    }
+
+    static void destroy(Node* x) { // iterative - no recursion on deep trees
+        std::vector<Node*> dead{x};
+        while(!dead.empty()) {
+            Node* y = dead.back();
+            dead.pop_back();
+            dead.insert(dead.end(), y->children.begin(), y->children.end());
+            delete y;
+        }
+    }
+};
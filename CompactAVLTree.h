@@ -0,0 +1,304 @@
+#pragma once
+#include <iostream>
+#include <queue>
+#include <vector>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <cstddef>
+#include <cstdint>
+
+/*
+Compact AVL Tree
+The same balancing as AVLTree, but every node lives in one std::vector and
+links are 32-bit slot indices instead of pointers. There is no parent link:
+push and erase remember the path from the root (at most maxHeight slots) and
+rebalance back up it, stopping as soon as a subtree keeps its old height.
+The height is the only balance information stored - one byte per node, the
+balance factor is the difference of the children's heights.
+
+For int keys a node is 16 bytes (key, left, right, height) against 40 for
+AVLTree's pointer node, and the nodes sit next to each other in insertion
+order. Erased slots are chained through their left link into a free list and
+reused by the next push, so the vector never holds more than the peak size.
+At most 2^32 - 1 nodes.
+*/
+
+template <typename T>
+class CompactAVLTree {
+    using Index = uint32_t;
+    static constexpr Index nil = UINT32_MAX;
+    static constexpr size_t maxHeight = 48; // AVL height < 1.45 log2(n + 2), and n < 2^32
+
+    struct Node {
+        T key;
+        Index left;
+        Index right;
+        uint8_t height; // leaves are 1, nil is 0
+    };
+
+    std::vector<Node> nodes;
+    Index root;
+    Index freeList; // erased slots, chained through left
+    size_t count;
+public:
+    CompactAVLTree() : root(nil), freeList(nil), count(0) {}
+
+    bool push(const T& key); // false if the key is already present
+    bool erase(const T& key); // false if the key is absent
+    const T* find(const T& key) const;
+    bool contains(const T& key) const { return find(key) != nullptr; }
+
+    const T* min() const;
+    const T* max() const;
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t height() const { return h(root); }
+
+    void reserve(size_t n) { nodes.reserve(n); } // avoids the vector's doubling when the final size is known
+    void clear();
+    size_t memoryUsage() const { return sizeof(*this) + nodes.capacity() * sizeof(Node); }
+    void print() const;
+private:
+    size_t h(Index x) const { return x == nil ? 0 : nodes[x].height; }
+    void update(Index x) { nodes[x].height = static_cast<uint8_t>(std::max(h(nodes[x].left), h(nodes[x].right)) + 1); }
+    int balanceFactor(Index x) const { return static_cast<int>(h(nodes[x].left)) - static_cast<int>(h(nodes[x].right)); }
+
+    Index allocate(const T& key);
+    void release(Index x);
+    Index rotateLeft(Index x);
+    Index rotateRight(Index x);
+    Index balance(Index x);
+    void relink(const Index* path, const bool* wentRight, size_t depth, Index child);
+    void rebalance(const Index* path, const bool* wentRight, size_t depth);
+};
+
+template <typename T>
+typename CompactAVLTree<T>::Index CompactAVLTree<T>::allocate(const T& key) {
+    Index x;
+    if(freeList != nil) {
+        x = freeList;
+        freeList = nodes[x].left;
+        nodes[x].key = key;
+    } else {
+        if(nodes.size() == nil) {
+            throw std::length_error("EXCEPTION: compact AVL tree is limited to 2^32 - 1 nodes!");
+        }
+        x = static_cast<Index>(nodes.size());
+        nodes.push_back(Node{key, nil, nil, 1});
+    }
+    nodes[x].left = nil;
+    nodes[x].right = nil;
+    nodes[x].height = 1;
+    return x;
+}
+
+template <typename T>
+void CompactAVLTree<T>::release(Index x) {
+    nodes[x].key = T(); // drop whatever the key owns
+    nodes[x].left = freeList;
+    nodes[x].height = 0;
+    freeList = x;
+}
+
+template <typename T>
+typename CompactAVLTree<T>::Index CompactAVLTree<T>::rotateLeft(Index x) {
+    Index y = nodes[x].right;
+    nodes[x].right = nodes[y].left;
+    nodes[y].left = x;
+    update(x);
+    update(y);
+    return y;
+}
+
+template <typename T>
+typename CompactAVLTree<T>::Index CompactAVLTree<T>::rotateRight(Index x) {
+    Index y = nodes[x].left;
+    nodes[x].left = nodes[y].right;
+    nodes[y].right = x;
+    update(x);
+    update(y);
+    return y;
+}
+
+// Restores the AVL property at x - returns the subtree's new root
+template <typename T>
+typename CompactAVLTree<T>::Index CompactAVLTree<T>::balance(Index x) {
+    update(x);
+    int bf = balanceFactor(x);
+    if(bf > 1) { // left-heavy
+        if(balanceFactor(nodes[x].left) < 0) { // left-right
+            nodes[x].left = rotateLeft(nodes[x].left);
+        }
+        return rotateRight(x);
+    }
+    if(bf < -1) { // right-heavy
+        if(balanceFactor(nodes[x].right) > 0) { // right-left
+            nodes[x].right = rotateRight(nodes[x].right);
+        }
+        return rotateLeft(x);
+    }
+    return x;
+}
+
+// Points the link that led to path[depth] (or the root) at child
+template <typename T>
+void CompactAVLTree<T>::relink(const Index* path, const bool* wentRight, size_t depth, Index child) {
+    if(depth == 0) {
+        root = child;
+    } else if(wentRight[depth - 1]) {
+        nodes[path[depth - 1]].right = child;
+    } else {
+        nodes[path[depth - 1]].left = child;
+    }
+}
+
+// Rebalances path[depth-1] .. path[0] - a subtree that keeps its height leaves everything above it unchanged
+template <typename T>
+void CompactAVLTree<T>::rebalance(const Index* path, const bool* wentRight, size_t depth) {
+    while(depth > 0) {
+        depth--;
+        Index x = path[depth];
+        size_t before = nodes[x].height;
+        Index y = balance(x);
+        if(y != x) {
+            relink(path, wentRight, depth, y);
+        }
+        if(nodes[y].height == before) {
+            return;
+        }
+    }
+}
+
+template <typename T>
+bool CompactAVLTree<T>::push(const T& key) {
+    Index path[maxHeight];
+    bool wentRight[maxHeight];
+    size_t depth = 0;
+    Index curr = root;
+    while(curr != nil) {
+        const Node& node = nodes[curr];
+        if(key < node.key) {
+            wentRight[depth] = false;
+        } else if(node.key < key) {
+            wentRight[depth] = true;
+        } else {
+            return false; // prohibit identical elements
+        }
+        path[depth++] = curr;
+        curr = wentRight[depth - 1] ? node.right : node.left;
+    }
+    Index x = allocate(key); // may grow the vector - only indices are held across it
+    relink(path, wentRight, depth, x);
+    count++;
+    rebalance(path, wentRight, depth);
+    return true;
+}
+
+template <typename T>
+bool CompactAVLTree<T>::erase(const T& key) {
+    Index path[maxHeight];
+    bool wentRight[maxHeight];
+    size_t depth = 0;
+    Index curr = root;
+    while(curr != nil && (key < nodes[curr].key || nodes[curr].key < key)) {
+        wentRight[depth] = nodes[curr].key < key;
+        path[depth++] = curr;
+        curr = wentRight[depth - 1] ? nodes[curr].right : nodes[curr].left;
+    }
+    if(curr == nil) {
+        return false;
+    }
+    if(nodes[curr].left != nil && nodes[curr].right != nil) {
+        // two children - take the successor's key and unlink the successor instead
+        Index target = curr;
+        wentRight[depth] = true;
+        path[depth++] = curr;
+        curr = nodes[curr].right;
+        while(nodes[curr].left != nil) {
+            wentRight[depth] = false;
+            path[depth++] = curr;
+            curr = nodes[curr].left;
+        }
+        nodes[target].key = std::move(nodes[curr].key);
+    }
+    // curr has at most one child, which takes its place
+    relink(path, wentRight, depth, nodes[curr].left != nil ? nodes[curr].left : nodes[curr].right);
+    release(curr);
+    count--;
+    rebalance(path, wentRight, depth);
+    return true;
+}
+
+template <typename T>
+const T* CompactAVLTree<T>::find(const T& key) const {
+    Index curr = root;
+    while(curr != nil) {
+        const Node& node = nodes[curr];
+        if(key < node.key) {
+            curr = node.left;
+        } else if(node.key < key) {
+            curr = node.right;
+        } else {
+            return &node.key;
+        }
+    }
+    return nullptr;
+}
+
+template <typename T>
+const T* CompactAVLTree<T>::min() const {
+    if(root == nil) {
+        return nullptr;
+    }
+    Index curr = root;
+    while(nodes[curr].left != nil) {
+        curr = nodes[curr].left;
+    }
+    return &nodes[curr].key;
+}
+
+template <typename T>
+const T* CompactAVLTree<T>::max() const {
+    if(root == nil) {
+        return nullptr;
+    }
+    Index curr = root;
+    while(nodes[curr].right != nil) {
+        curr = nodes[curr].right;
+    }
+    return &nodes[curr].key;
+}
+
+template <typename T>
+void CompactAVLTree<T>::clear() {
+    nodes.clear();
+    root = nil;
+    freeList = nil;
+    count = 0;
+}
+
+template <typename T>
+void CompactAVLTree<T>::print() const {
+    if(root == nil) {
+        std::cout << "Tree is empty\n";
+        return;
+    }
+    std::queue<std::pair<Index, size_t>> q;
+    q.push({root, 0});
+    size_t lvl = 0;
+    std::cout << "\n";
+    while(!q.empty()) {
+        auto [x, depth] = q.front();
+        q.pop();
+        if(depth > lvl) {
+            std::cout << "\n";
+            lvl = depth;
+        }
+        std::cout << nodes[x].key << " ";
+        if(nodes[x].left != nil) q.push({nodes[x].left, depth + 1});
+        if(nodes[x].right != nil) q.push({nodes[x].right, depth + 1});
+    }
+    std::cout << "\n";
+}
@@ -0,0 +1,286 @@
+#pragma once
+#include <atomic>
+#include <array>
+#include <algorithm>
+#include <thread>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "NodeSearch.h"
+
+/*
+Concurrent B+ Tree with optimistic lock coupling (OLC)
+Every node carries a version lock: bit 0 = obsolete, bit 1 = locked, the
+rest a counter bumped by each writer. Lookups never write shared memory -
+they record a node's version, read it, and re-validate the version after
+reading the next node down, restarting from the root if anything changed.
+Writers upgrade only the nodes they modify (the leaf, or a full node and
+its parent when splitting) with a CAS on the version they validated.
+
+Full nodes are split eagerly on the way down, so a split never has to
+propagate upwards. remove() deletes from the leaf without merging, so
+nodes are never freed while the tree is shared and no memory reclamation
+scheme is needed; underfull leaves are reused by later inserts.
+
+As in the OLC paper, readers may observe a node mid-update; those reads are
+discarded by the version check, and every index derived from them is
+clamped to the node's capacity first. That makes it safe only for trivially
+copyable keys: a torn int is harmless until validation throws it away, but a
+torn std::string is a pointer a reader would follow before the restart.
+*/
+
+class OptLock {
+    std::atomic<uint64_t> version{0b100};
+    static bool isLocked(uint64_t v) { return (v & 0b10) == 0b10; }
+    static bool isObsolete(uint64_t v) { return (v & 1) == 1; }
+public:
+    uint64_t readLockOrRestart(bool& needRestart) const {
+        uint64_t v = version.load(std::memory_order_acquire);
+        if(isLocked(v) || isObsolete(v)) {
+            std::this_thread::yield();
+            needRestart = true;
+        }
+        return v;
+    }
+    void readUnlockOrRestart(uint64_t v, bool& needRestart) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(v != version.load(std::memory_order_relaxed)) {
+            needRestart = true;
+        }
+    }
+    void checkOrRestart(uint64_t v, bool& needRestart) const {
+        readUnlockOrRestart(v, needRestart);
+    }
+    void upgradeToWriteLockOrRestart(uint64_t& v, bool& needRestart) {
+        if(version.compare_exchange_strong(v, v + 0b10, std::memory_order_acquire)) {
+            v = v + 0b10;
+        } else {
+            std::this_thread::yield();
+            needRestart = true;
+        }
+    }
+    void writeUnlock() {
+        version.fetch_add(0b10, std::memory_order_release); // clears lock bit, bumps counter
+    }
+};
+
+template <typename T, size_t Degree = 16>
+class ConcurrentBTree {
+    static_assert(Degree >= 2, "B+ Tree degree must be at least 2");
+    static_assert(std::is_trivially_copyable_v<T>, "optimistic readers need trivially copyable keys");
+    static constexpr size_t t = Degree;
+    static constexpr size_t maxKeys = 2 * Degree - 1;
+
+    struct alignas(64) Node {
+        OptLock lock;
+        unsigned n = 0;
+        bool leaf = true;
+        std::array<T, maxKeys> keys;
+        std::array<Node*, maxKeys + 1> children;
+        ~Node() {
+            if(!leaf) {
+                for(size_t i=0; i<=n; i++) {
+                    delete children[i];
+                }
+            }
+        }
+        size_t count() const { return std::min<size_t>(n, maxKeys); } // n may be torn for optimistic readers
+        bool full() const { return n == maxKeys; }
+        size_t childIndex(const T& k) const { return nodeUpperBound(keys.data(), count(), k); }
+    };
+
+    std::atomic<Node*> root;
+public:
+    ConcurrentBTree() : root(new Node()) {}
+    ~ConcurrentBTree() { delete root.load(); }
+    ConcurrentBTree(const ConcurrentBTree& tree) = delete;
+    ConcurrentBTree& operator=(const ConcurrentBTree& rhs) = delete;
+
+    bool contains(const T& k) const;
+    bool insert(const T& k); // false if already present
+    bool remove(const T& k); // false if absent
+private:
+    // Splits the write-locked full node; its parent (or the root pointer) must be locked too
+    void split(Node* parent, Node* node);
+};
+
+template <typename T, size_t Degree>
+bool ConcurrentBTree<T, Degree>::contains(const T& k) const {
+    while(true) {
+        bool restart = false;
+        Node* node = root.load(std::memory_order_acquire);
+        uint64_t v = node->lock.readLockOrRestart(restart);
+        if(restart || node != root.load(std::memory_order_acquire)) continue;
+
+        while(!node->leaf) {
+            Node* parent = node;
+            uint64_t pv = v;
+            node = node->children[node->childIndex(k)];
+            parent->lock.checkOrRestart(pv, restart); // child pointer was valid?
+            if(restart) break;
+            v = node->lock.readLockOrRestart(restart);
+            if(restart) break;
+        }
+        if(restart) continue;
+
+        size_t n = node->count();
+        size_t i = nodeLowerBound(node->keys.data(), n, k);
+        bool found = i < n && !(k < node->keys[i]);
+        node->lock.readUnlockOrRestart(v, restart);
+        if(restart) continue;
+        return found;
+    }
+}
+
+template <typename T, size_t Degree>
+bool ConcurrentBTree<T, Degree>::insert(const T& k) {
+    while(true) {
+        bool restart = false;
+        Node* node = root.load(std::memory_order_acquire);
+        uint64_t v = node->lock.readLockOrRestart(restart);
+        if(restart || node != root.load(std::memory_order_acquire)) continue;
+
+        Node* parent = nullptr;
+        uint64_t pv = 0;
+        while(true) {
+            if(node->full()) { // eager split - lock parent then node, split, start over
+                if(parent) {
+                    parent->lock.upgradeToWriteLockOrRestart(pv, restart);
+                    if(restart) break;
+                }
+                node->lock.upgradeToWriteLockOrRestart(v, restart);
+                if(restart) {
+                    if(parent) parent->lock.writeUnlock();
+                    break;
+                }
+                if(!parent && node != root.load(std::memory_order_acquire)) { // root split under us
+                    node->lock.writeUnlock();
+                    restart = true;
+                    break;
+                }
+                split(parent, node);
+                node->lock.writeUnlock();
+                if(parent) parent->lock.writeUnlock();
+                restart = true;
+                break;
+            }
+            if(node->leaf) {
+                break;
+            }
+            if(parent) {
+                parent->lock.readUnlockOrRestart(pv, restart);
+                if(restart) break;
+            }
+            parent = node;
+            pv = v;
+            node = node->children[node->childIndex(k)];
+            parent->lock.checkOrRestart(pv, restart);
+            if(restart) break;
+            v = node->lock.readLockOrRestart(restart);
+            if(restart) break;
+        }
+        if(restart) continue;
+
+        // non-full leaf: only the leaf is locked
+        node->lock.upgradeToWriteLockOrRestart(v, restart);
+        if(restart) continue;
+        if(parent) {
+            parent->lock.readUnlockOrRestart(pv, restart);
+            if(restart) {
+                node->lock.writeUnlock();
+                continue;
+            }
+        }
+        size_t i = nodeLowerBound(node->keys.data(), node->n, k);
+        bool inserted = i == node->n || k < node->keys[i];
+        if(inserted) {
+            std::move_backward(node->keys.begin() + i, node->keys.begin() + node->n, node->keys.begin() + node->n + 1);
+            node->keys[i] = k;
+            node->n += 1;
+        }
+        node->lock.writeUnlock();
+        return inserted;
+    }
+}
+
+template <typename T, size_t Degree>
+bool ConcurrentBTree<T, Degree>::remove(const T& k) {
+    while(true) {
+        bool restart = false;
+        Node* node = root.load(std::memory_order_acquire);
+        uint64_t v = node->lock.readLockOrRestart(restart);
+        if(restart || node != root.load(std::memory_order_acquire)) continue;
+
+        Node* parent = nullptr;
+        uint64_t pv = 0;
+        while(!node->leaf) {
+            if(parent) {
+                parent->lock.readUnlockOrRestart(pv, restart);
+                if(restart) break;
+            }
+            parent = node;
+            pv = v;
+            node = node->children[node->childIndex(k)];
+            parent->lock.checkOrRestart(pv, restart);
+            if(restart) break;
+            v = node->lock.readLockOrRestart(restart);
+            if(restart) break;
+        }
+        if(restart) continue;
+
+        node->lock.upgradeToWriteLockOrRestart(v, restart);
+        if(restart) continue;
+        if(parent) {
+            parent->lock.readUnlockOrRestart(pv, restart);
+            if(restart) {
+                node->lock.writeUnlock();
+                continue;
+            }
+        }
+        size_t i = nodeLowerBound(node->keys.data(), node->n, k);
+        bool removed = i < node->n && !(k < node->keys[i]);
+        if(removed) {
+            std::move(node->keys.begin() + i + 1, node->keys.begin() + node->n, node->keys.begin() + i);
+            node->n -= 1;
+        }
+        node->lock.writeUnlock();
+        return removed;
+    }
+}
+
+template <typename T, size_t Degree>
+void ConcurrentBTree<T, Degree>::split(Node* parent, Node* node) {
+    Node* z = new Node();
+    z->leaf = node->leaf;
+    T separator;
+    if(node->leaf) {
+        // z takes the upper t-1 keys, its first key is copied up
+        z->n = t - 1;
+        std::copy(node->keys.begin() + t, node->keys.end(), z->keys.begin());
+        node->n = t;
+        separator = z->keys[0];
+    } else {
+        // the median moves up
+        z->n = t - 1;
+        std::copy(node->keys.begin() + t, node->keys.end(), z->keys.begin());
+        std::copy(node->children.begin() + t, node->children.end(), z->children.begin());
+        node->n = t - 1;
+        separator = node->keys[t - 1];
+    }
+    if(!parent) { // grow a new root above node
+        Node* r = new Node();
+        r->leaf = false;
+        r->n = 1;
+        r->keys[0] = separator;
+        r->children[0] = node;
+        r->children[1] = z;
+        root.store(r, std::memory_order_release);
+        return;
+    }
+    size_t i = nodeUpperBound(parent->keys.data(), parent->n, separator);
+    std::move_backward(parent->keys.begin() + i, parent->keys.begin() + parent->n, parent->keys.begin() + parent->n + 1);
+    std::copy_backward(parent->children.begin() + i + 1, parent->children.begin() + parent->n + 1, parent->children.begin() + parent->n + 2);
+    parent->keys[i] = separator;
+    parent->children[i + 1] = z;
+    parent->n += 1;
+}
@@ -0,0 +1,248 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <iterator>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+Frozen search tree (Eytzinger layout)
+An immutable sorted array laid out in breadth-first order: slot 1 is the
+root and slot k has children 2k and 2k+1, so there are no pointers at all.
+A search is a branch-free walk down the implicit tree, and the first levels
+of every search share the same few cache lines.
+Each step prefetches the cache line that holds node k's descendants several
+levels down (16 of them for 4-byte keys - the array is cache-line aligned),
+so the misses of consecutive levels overlap instead of queueing.
+
+Built in O(n) from any sorted range - BST, AVLTree, RBTree, BPlusTree and
+both BTree variants export one with freeze(). save(path) writes the array
+to a file and FrozenTree::map(path) serves lookups straight out of a
+read-only mmap of it, without parsing or copying; the file form needs
+trivially copyable keys.
+Duplicate keys are kept, and lower_bound() finds the first copy.
+*/
+
+template <typename T>
+class FrozenTree {
+    static constexpr size_t lineBytes = 64;
+    static constexpr uint64_t fileMagic = 0x454552544e5a5246; // "FRZNTREE"
+
+    struct FileHeader { // padded to a cache line, so the keys that follow stay aligned
+        uint64_t magic;
+        uint32_t keySize;
+        uint32_t reserved;
+        uint64_t count;
+        char pad[lineBytes - 24];
+    };
+
+    // descendants of k at depth d sit at k * 2^d ... - prefetch as deep as one line of them reaches
+    static constexpr size_t prefetchStride() {
+        size_t stride = 1;
+        while(stride * 2 * sizeof(T) <= lineBytes) {
+            stride *= 2;
+        }
+        return stride;
+    }
+
+    template <typename U>
+    struct LineAllocator {
+        using value_type = U;
+        LineAllocator() = default;
+        template <typename V>
+        LineAllocator(const LineAllocator<V>&) {}
+        U* allocate(size_t n) { return static_cast<U*>(::operator new(n * sizeof(U), std::align_val_t(lineBytes))); }
+        void deallocate(U* p, size_t) { ::operator delete(p, std::align_val_t(lineBytes)); }
+        bool operator==(const LineAllocator&) const { return true; }
+        bool operator!=(const LineAllocator&) const { return false; }
+    };
+
+    std::vector<T, LineAllocator<T>> owned; // empty when mapped
+    const T* keys; // keys[1..n] in Eytzinger order, keys[0] unused
+    size_t n;
+    void* mapping;
+    size_t mappingBytes;
+
+    template <typename It>
+    void fill(It& it, size_t k); // in-order walk of the implicit tree
+    size_t search(const T& x) const; // slot of the first key not less than x, 0 if none
+public:
+    FrozenTree() : keys(nullptr), n(0), mapping(nullptr), mappingBytes(0) {}
+    template <typename It>
+    FrozenTree(It first, It last); // a sorted range
+    FrozenTree(const FrozenTree& tree) = delete;
+    FrozenTree& operator=(const FrozenTree& rhs) = delete;
+    FrozenTree(FrozenTree&& tree) noexcept;
+    FrozenTree& operator=(FrozenTree&& rhs) noexcept;
+    ~FrozenTree();
+
+    static FrozenTree map(const std::string& path); // read-only, lives as long as the returned tree
+    void save(const std::string& path) const;
+
+    bool contains(const T& x) const;
+    const T* lower_bound(const T& x) const; // first key not less than x, nullptr if none
+    size_t size() const { return n; }
+    bool mapped() const { return mapping != nullptr; }
+};
+
+template <typename T>
+template <typename It>
+FrozenTree<T>::FrozenTree(It first, It last) : keys(nullptr), n(0), mapping(nullptr), mappingBytes(0) {
+    std::vector<T> sorted(first, last);
+    for(size_t i=1; i<sorted.size(); i++) {
+        if(sorted[i] < sorted[i - 1]) {
+            throw std::invalid_argument("EXCEPTION: frozen tree keys must be sorted!");
+        }
+    }
+    n = sorted.size();
+    owned.resize(n + 1);
+    auto it = std::make_move_iterator(sorted.begin());
+    fill(it, 1);
+    keys = owned.data();
+}
+
+template <typename T>
+template <typename It>
+void FrozenTree<T>::fill(It& it, size_t k) {
+    while(k <= n) { // the right subtree is a loop, so only the depth - O(log n) - recurses
+        fill(it, 2 * k);
+        owned[k] = *it;
+        ++it;
+        k = 2 * k + 1;
+    }
+}
+
+template <typename T>
+FrozenTree<T>::FrozenTree(FrozenTree&& tree) noexcept
+    : owned(std::move(tree.owned)), keys(tree.keys), n(tree.n), mapping(tree.mapping), mappingBytes(tree.mappingBytes) {
+    tree.keys = nullptr;
+    tree.n = 0;
+    tree.mapping = nullptr;
+    tree.mappingBytes = 0;
+}
+
+template <typename T>
+FrozenTree<T>& FrozenTree<T>::operator=(FrozenTree&& rhs) noexcept {
+    if(this == &rhs) {
+        return *this;
+    }
+    FrozenTree old(std::move(*this)); // releases our mapping on the way out
+    owned = std::move(rhs.owned);
+    keys = rhs.keys;
+    n = rhs.n;
+    mapping = rhs.mapping;
+    mappingBytes = rhs.mappingBytes;
+    rhs.keys = nullptr;
+    rhs.n = 0;
+    rhs.mapping = nullptr;
+    rhs.mappingBytes = 0;
+    return *this;
+}
+
+template <typename T>
+FrozenTree<T>::~FrozenTree() {
+    if(mapping) {
+        munmap(mapping, mappingBytes);
+    }
+}
+
+template <typename T>
+size_t FrozenTree<T>::search(const T& x) const {
+    constexpr size_t stride = prefetchStride();
+    size_t k = 1;
+    while(k <= n) {
+        // integer arithmetic - the prefetched address may lie past the array, which is harmless
+        __builtin_prefetch(reinterpret_cast<const void*>(reinterpret_cast<uintptr_t>(keys) + k * stride * sizeof(T)));
+        k = 2 * k + (keys[k] < x);
+    }
+    // k went left at the answer and right ever after: drop those right turns and that left one
+    k >>= __builtin_ffsll(static_cast<long long>(~k));
+    return k;
+}
+
+template <typename T>
+bool FrozenTree<T>::contains(const T& x) const {
+    size_t k = search(x);
+    return k != 0 && !(x < keys[k]);
+}
+
+template <typename T>
+const T* FrozenTree<T>::lower_bound(const T& x) const {
+    size_t k = search(x);
+    return k == 0 ? nullptr : keys + k;
+}
+
+template <typename T>
+void FrozenTree<T>::save(const std::string& path) const {
+    static_assert(std::is_trivially_copyable_v<T>, "the file form needs trivially copyable keys");
+    FileHeader header{};
+    header.magic = fileMagic;
+    header.keySize = static_cast<uint32_t>(sizeof(T));
+    header.count = n;
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0) {
+        throw std::runtime_error("EXCEPTION: cannot open frozen tree file " + path);
+    }
+    auto writeAll = [fd](const void* data, size_t bytes) {
+        const char* p = static_cast<const char*>(data);
+        while(bytes > 0) {
+            ssize_t w = write(fd, p, bytes);
+            if(w <= 0) {
+                return false;
+            }
+            p += w;
+            bytes -= static_cast<size_t>(w);
+        }
+        return true;
+    };
+    std::vector<char> unused(sizeof(T), 0); // slot 0 keeps the slot numbers of memory and file equal
+    bool ok = writeAll(&header, sizeof(header)) && writeAll(unused.data(), sizeof(T))
+        && writeAll(keys + 1, n * sizeof(T));
+    if(close(fd) != 0 || !ok) {
+        throw std::runtime_error("EXCEPTION: frozen tree write failed!");
+    }
+}
+
+template <typename T>
+FrozenTree<T> FrozenTree<T>::map(const std::string& path) {
+    static_assert(std::is_trivially_copyable_v<T>, "the file form needs trivially copyable keys");
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        throw std::runtime_error("EXCEPTION: cannot open frozen tree file " + path);
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(FileHeader) + sizeof(T))) {
+        close(fd);
+        throw std::runtime_error("EXCEPTION: not a frozen tree file!");
+    }
+    size_t bytes = static_cast<size_t>(st.st_size);
+    void* addr = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // the mapping keeps the file alive
+    if(addr == MAP_FAILED) {
+        throw std::runtime_error("EXCEPTION: mmap of frozen tree file failed!");
+    }
+    FileHeader header;
+    std::memcpy(&header, addr, sizeof(header));
+    // bound count by what the file can hold first, so a bad header cannot wrap the size check
+    if(header.magic != fileMagic || header.keySize != sizeof(T)
+        || header.count > (bytes - sizeof(FileHeader)) / sizeof(T) - 1
+        || bytes != sizeof(FileHeader) + (header.count + 1) * sizeof(T)) {
+        munmap(addr, bytes);
+        throw std::runtime_error("EXCEPTION: frozen tree file has a different key size or is damaged!");
+    }
+    FrozenTree tree;
+    tree.mapping = addr;
+    tree.mappingBytes = bytes;
+    tree.keys = reinterpret_cast<const T*>(static_cast<const char*>(addr) + sizeof(FileHeader));
+    tree.n = static_cast<size_t>(header.count);
+    return tree;
+}
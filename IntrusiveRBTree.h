@@ -0,0 +1,523 @@
+#pragma once
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+/*
+Intrusive Red-Black Tree (in the style of the Linux kernel rbtree)
+The tree never allocates: objects embed an rb_hook and the tree links the
+hooks directly, so insert and erase only rewrite pointers in objects the
+caller already owns.
+
+    struct Session {
+        uint64_t id;
+        rb_hook byId;
+        bool operator<(const Session& rhs) const { return id < rhs.id; }
+    };
+    IntrusiveRBTree<Session, &Session::byId> sessions;
+    sessions.insert(s); ... sessions.erase(s);
+
+The hook packs the parent pointer and the color into one word - hooks are
+pointer aligned, so the low bit is free - leaving three words per object.
+Empty links are nullptr rather than a sentinel, so the fixups below carry
+x's parent separately where CLRS reads it from the sentinel.
+
+The tree does not own the objects: an object must outlive its membership,
+and must be erased before its key changes or it is destroyed. An object can
+sit in several trees at once through several hooks.
+*/
+
+class rb_hook {
+    template <typename T, rb_hook T::*Hook>
+    friend class IntrusiveRBTree;
+    static constexpr uintptr_t blackBit = 1;
+    static constexpr uintptr_t detached = 2; // not in any tree - never a valid parent word
+
+    uintptr_t parentColor; // parent pointer | color bit
+    rb_hook* left;
+    rb_hook* right;
+
+    rb_hook* parent() const { return reinterpret_cast<rb_hook*>(parentColor & ~blackBit); }
+    bool red() const { return (parentColor & blackBit) == 0; }
+    void setParent(rb_hook* p) { parentColor = reinterpret_cast<uintptr_t>(p) | (parentColor & blackBit); }
+    void setRed() { parentColor &= ~blackBit; }
+    void setBlack() { parentColor |= blackBit; }
+    void copyColor(const rb_hook* h) { parentColor = (parentColor & ~blackBit) | (h->parentColor & blackBit); }
+public:
+    rb_hook() : parentColor(detached), left(nullptr), right(nullptr) {}
+    rb_hook(const rb_hook&) : rb_hook() {} // a copied object starts outside every tree
+    rb_hook& operator=(const rb_hook&) { return *this; } // membership is not assignable
+
+    bool linked() const { return parentColor != detached; }
+};
+
+template <typename T, rb_hook T::*Hook>
+class IntrusiveRBTree {
+    rb_hook* root;
+    size_t count;
+    std::ptrdiff_t hookOffset; // of the hook inside T - taken from the objects inserted, so no T is ever made up
+
+    static rb_hook* hookOf(T& obj) { return &(obj.*Hook); }
+    static std::ptrdiff_t offsetIn(T& obj) {
+        return reinterpret_cast<unsigned char*>(hookOf(obj)) - reinterpret_cast<unsigned char*>(std::addressof(obj));
+    }
+    T* owner(rb_hook* h) const; // container_of
+    static bool isRed(const rb_hook* h) { return h != nullptr && h->red(); } // empty links are black
+
+    void leftRotate(rb_hook* x);
+    void rightRotate(rb_hook* x);
+    void insertFixup(rb_hook* z);
+    void removeFixup(rb_hook* x, rb_hook* xParent);
+    void transplant(rb_hook* u, rb_hook* v);
+    void link(rb_hook* z, rb_hook* parent, bool asLeft);
+
+    static rb_hook* leftmost(rb_hook* h);
+    static rb_hook* rightmost(rb_hook* h);
+    static rb_hook* successor(rb_hook* h);
+    static rb_hook* predecessor(rb_hook* h);
+public:
+    class iterator;
+
+    IntrusiveRBTree() : root(nullptr), count(0), hookOffset(0) {}
+    IntrusiveRBTree(const IntrusiveRBTree& tree) = delete; // hooks can only be in one tree
+    IntrusiveRBTree& operator=(const IntrusiveRBTree& rhs) = delete;
+    ~IntrusiveRBTree() { clear(); }
+
+    void insert(T& obj); // equal keys are kept, after the existing ones
+    std::pair<T*, bool> insert_unique(T& obj); // the object already holding the key, if there is one
+    void erase(T& obj); // O(log n), no search - obj must be in this tree
+    void clear(); // detaches every object, O(n)
+
+    template <typename K>
+    T* find(const K& key) const;
+    template <typename K>
+    iterator lower_bound(const K& key) const;
+    template <typename K>
+    iterator upper_bound(const K& key) const;
+
+    iterator begin() const { return iterator(root ? leftmost(root) : nullptr, this); }
+    iterator end() const { return iterator(nullptr, this); }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+};
+
+template <typename T, rb_hook T::*Hook>
+class IntrusiveRBTree<T, Hook>::iterator {
+    friend class IntrusiveRBTree;
+    rb_hook* node;
+    const IntrusiveRBTree* tree;
+    iterator(rb_hook* node, const IntrusiveRBTree* tree) : node(node), tree(tree) {}
+public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+
+    iterator() : node(nullptr), tree(nullptr) {}
+
+    reference operator*() const { return *tree->owner(node); }
+    pointer operator->() const { return tree->owner(node); }
+
+    iterator& operator++() {
+        node = successor(node);
+        return *this;
+    }
+    iterator operator++(int) {
+        iterator old = *this;
+        ++*this;
+        return old;
+    }
+    iterator& operator--() {
+        node = node ? predecessor(node) : rightmost(tree->root);
+        return *this;
+    }
+    iterator operator--(int) {
+        iterator old = *this;
+        --*this;
+        return old;
+    }
+
+    bool operator==(const iterator& rhs) const { return node == rhs.node; }
+    bool operator!=(const iterator& rhs) const { return node != rhs.node; }
+};
+
+template <typename T, rb_hook T::*Hook>
+T* IntrusiveRBTree<T, Hook>::owner(rb_hook* h) const {
+    return reinterpret_cast<T*>(reinterpret_cast<unsigned char*>(h) - hookOffset);
+}
+
+template <typename T, rb_hook T::*Hook>
+void IntrusiveRBTree<T, Hook>::leftRotate(rb_hook* x) { // throw X to the left - replace with its right child
+    rb_hook* y = x->right;
+    x->right = y->left;
+    if(y->left != nullptr) {
+        y->left->setParent(x);
+    }
+    rb_hook* p = x->parent();
+    y->setParent(p);
+    if(p == nullptr) {
+        root = y;
+    } else if(x == p->left) {
+        p->left = y;
+    } else {
+        p->right = y;
+    }
+    y->left = x;
+    x->setParent(y);
+}
+
+template <typename T, rb_hook T::*Hook>
+void IntrusiveRBTree<T, Hook>::rightRotate(rb_hook* x) { // throw X to the right - replace with its left child
+    rb_hook* y = x->left;
+    x->left = y->right;
+    if(y->right != nullptr) {
+        y->right->setParent(x);
+    }
+    rb_hook* p = x->parent();
+    y->setParent(p);
+    if(p == nullptr) {
+        root = y;
+    } else if(x == p->left) {
+        p->left = y;
+    } else {
+        p->right = y;
+    }
+    y->right = x;
+    x->setParent(y);
+}
+
+// Hangs a fresh red leaf z under parent (or at the root) and restores the colors
+template <typename T, rb_hook T::*Hook>
+void IntrusiveRBTree<T, Hook>::link(rb_hook* z, rb_hook* parent, bool asLeft) {
+    if(z->linked()) {
+        throw std::invalid_argument("EXCEPTION: object is already linked into a tree!");
+    }
+    z->parentColor = reinterpret_cast<uintptr_t>(parent); // red
+    z->left = nullptr;
+    z->right = nullptr;
+    if(parent == nullptr) {
+        root = z;
+    } else if(asLeft) {
+        parent->left = z;
+    } else {
+        parent->right = z;
+    }
+    count++;
+    insertFixup(z);
+}
+
+template <typename T, rb_hook T::*Hook>
+void IntrusiveRBTree<T, Hook>::insert(T& obj) {
+    hookOffset = offsetIn(obj);
+    rb_hook* y = nullptr;
+    rb_hook* x = root;
+    bool asLeft = false;
+    while(x != nullptr) { // equal keys go right, as in RBTree
+        y = x;
+        asLeft = obj < *owner(x);
+        x = asLeft ? x->left : x->right;
+    }
+    link(hookOf(obj), y, asLeft);
+}
+
+template <typename T, rb_hook T::*Hook>
+std::pair<T*, bool> IntrusiveRBTree<T, Hook>::insert_unique(T& obj) {
+    hookOffset = offsetIn(obj);
+    rb_hook* y = nullptr;
+    rb_hook* x = root;
+    bool asLeft = false;
+    while(x != nullptr) {
+        y = x;
+        T* curr = owner(x);
+        if(obj < *curr) {
+            asLeft = true;
+            x = x->left;
+        } else if(*curr < obj) {
+            asLeft = false;
+            x = x->right;
+        } else {
+            return {curr, false};
+        }
+    }
+    link(hookOf(obj), y, asLeft);
+    return {&obj, true};
+}
+
+// CLRS RB-INSERT-FIXUP - a missing uncle counts as black
+template <typename T, rb_hook T::*Hook>
+void IntrusiveRBTree<T, Hook>::insertFixup(rb_hook* z) {
+    rb_hook* p;
+    while((p = z->parent()) != nullptr && p->red()) { // a red parent is never the root, so g exists
+        rb_hook* g = p->parent();
+        if(p == g->left) {
+            rb_hook* y = g->right; // uncle
+            if(isRed(y)) { // case 1 - recolor and move up
+                p->setBlack();
+                y->setBlack();
+                g->setRed();
+                z = g;
+            } else {
+                if(z == p->right) { // case 2 - rotate into case 3
+                    z = p;
+                    leftRotate(z);
+                    p = z->parent();
+                }
+                p->setBlack(); // case 3
+                g->setRed();
+                rightRotate(g);
+            }
+        } else { // symmetric
+            rb_hook* y = g->left;
+            if(isRed(y)) {
+                p->setBlack();
+                y->setBlack();
+                g->setRed();
+                z = g;
+            } else {
+                if(z == p->left) {
+                    z = p;
+                    rightRotate(z);
+                    p = z->parent();
+                }
+                p->setBlack();
+                g->setRed();
+                leftRotate(g);
+            }
+        }
+    }
+    root->setBlack();
+}
+
+template <typename T, rb_hook T::*Hook>
+void IntrusiveRBTree<T, Hook>::transplant(rb_hook* u, rb_hook* v) {
+    rb_hook* p = u->parent();
+    if(p == nullptr) {
+        root = v;
+    } else if(u == p->left) {
+        p->left = v;
+    } else {
+        p->right = v;
+    }
+    if(v != nullptr) {
+        v->setParent(p);
+    }
+}
+
+// CLRS RB-DELETE, with x's parent tracked explicitly since x may be an empty link
+template <typename T, rb_hook T::*Hook>
+void IntrusiveRBTree<T, Hook>::erase(T& obj) {
+    rb_hook* z = hookOf(obj);
+    rb_hook* x;
+    rb_hook* xParent;
+    bool removedBlack = !z->red();
+    if(z->left == nullptr) {
+        x = z->right;
+        xParent = z->parent();
+        transplant(z, z->right);
+    } else if(z->right == nullptr) {
+        x = z->left;
+        xParent = z->parent();
+        transplant(z, z->left);
+    } else {
+        rb_hook* y = leftmost(z->right); // successor - takes z's place and color
+        removedBlack = !y->red();
+        x = y->right;
+        if(y->parent() == z) {
+            xParent = y;
+        } else {
+            xParent = y->parent();
+            transplant(y, y->right);
+            y->right = z->right;
+            y->right->setParent(y);
+        }
+        transplant(z, y);
+        y->left = z->left;
+        y->left->setParent(y);
+        y->copyColor(z);
+    }
+    if(removedBlack) {
+        removeFixup(x, xParent);
+    }
+    count--;
+    z->parentColor = rb_hook::detached;
+    z->left = nullptr;
+    z->right = nullptr;
+}
+
+// CLRS RB-DELETE-FIXUP - x carries an extra black; a missing nephew counts as black
+template <typename T, rb_hook T::*Hook>
+void IntrusiveRBTree<T, Hook>::removeFixup(rb_hook* x, rb_hook* xParent) {
+    while(x != root && !isRed(x)) {
+        if(x == xParent->left) {
+            rb_hook* w = xParent->right; // sibling - never empty, xParent's right has black height >= 1
+            if(w->red()) { // case 1
+                w->setBlack();
+                xParent->setRed();
+                leftRotate(xParent);
+                w = xParent->right;
+            }
+            if(!isRed(w->left) && !isRed(w->right)) { // case 2
+                w->setRed();
+                x = xParent;
+                xParent = x->parent();
+            } else {
+                if(!isRed(w->right)) { // case 3
+                    w->left->setBlack();
+                    w->setRed();
+                    rightRotate(w);
+                    w = xParent->right;
+                }
+                w->copyColor(xParent); // case 4
+                xParent->setBlack();
+                w->right->setBlack();
+                leftRotate(xParent);
+                x = root;
+            }
+        } else { // symmetric
+            rb_hook* w = xParent->left;
+            if(w->red()) {
+                w->setBlack();
+                xParent->setRed();
+                rightRotate(xParent);
+                w = xParent->left;
+            }
+            if(!isRed(w->right) && !isRed(w->left)) {
+                w->setRed();
+                x = xParent;
+                xParent = x->parent();
+            } else {
+                if(!isRed(w->left)) {
+                    w->right->setBlack();
+                    w->setRed();
+                    leftRotate(w);
+                    w = xParent->left;
+                }
+                w->copyColor(xParent);
+                xParent->setBlack();
+                w->left->setBlack();
+                rightRotate(xParent);
+                x = root;
+            }
+        }
+    }
+    if(x != nullptr) {
+        x->setBlack();
+    }
+}
+
+template <typename T, rb_hook T::*Hook>
+void IntrusiveRBTree<T, Hook>::clear() {
+    // post-order without a stack: descend, detach a leaf, climb to its parent
+    rb_hook* h = root;
+    while(h != nullptr) {
+        if(h->left != nullptr) {
+            h = h->left;
+        } else if(h->right != nullptr) {
+            h = h->right;
+        } else {
+            rb_hook* p = h->parent();
+            if(p != nullptr) {
+                (p->left == h ? p->left : p->right) = nullptr;
+            }
+            h->parentColor = rb_hook::detached;
+            h = p;
+        }
+    }
+    root = nullptr;
+    count = 0;
+}
+
+template <typename T, rb_hook T::*Hook>
+template <typename K>
+T* IntrusiveRBTree<T, Hook>::find(const K& key) const {
+    rb_hook* x = root;
+    while(x != nullptr) {
+        T* curr = owner(x);
+        if(key < *curr) {
+            x = x->left;
+        } else if(*curr < key) {
+            x = x->right;
+        } else {
+            return curr;
+        }
+    }
+    return nullptr;
+}
+
+template <typename T, rb_hook T::*Hook>
+template <typename K>
+typename IntrusiveRBTree<T, Hook>::iterator IntrusiveRBTree<T, Hook>::lower_bound(const K& key) const {
+    rb_hook* bound = nullptr;
+    rb_hook* x = root;
+    while(x != nullptr) {
+        if(*owner(x) < key) {
+            x = x->right;
+        } else {
+            bound = x;
+            x = x->left;
+        }
+    }
+    return iterator(bound, this);
+}
+
+template <typename T, rb_hook T::*Hook>
+template <typename K>
+typename IntrusiveRBTree<T, Hook>::iterator IntrusiveRBTree<T, Hook>::upper_bound(const K& key) const {
+    rb_hook* bound = nullptr;
+    rb_hook* x = root;
+    while(x != nullptr) {
+        if(key < *owner(x)) {
+            bound = x;
+            x = x->left;
+        } else {
+            x = x->right;
+        }
+    }
+    return iterator(bound, this);
+}
+
+template <typename T, rb_hook T::*Hook>
+rb_hook* IntrusiveRBTree<T, Hook>::leftmost(rb_hook* h) {
+    while(h->left != nullptr) {
+        h = h->left;
+    }
+    return h;
+}
+
+template <typename T, rb_hook T::*Hook>
+rb_hook* IntrusiveRBTree<T, Hook>::rightmost(rb_hook* h) {
+    while(h != nullptr && h->right != nullptr) {
+        h = h->right;
+    }
+    return h;
+}
+
+template <typename T, rb_hook T::*Hook>
+rb_hook* IntrusiveRBTree<T, Hook>::successor(rb_hook* h) {
+    if(h->right != nullptr) {
+        return leftmost(h->right);
+    }
+    rb_hook* p = h->parent();
+    while(p != nullptr && h == p->right) {
+        h = p;
+        p = p->parent();
+    }
+    return p;
+}
+
+template <typename T, rb_hook T::*Hook>
+rb_hook* IntrusiveRBTree<T, Hook>::predecessor(rb_hook* h) {
+    if(h->left != nullptr) {
+        return rightmost(h->left);
+    }
+    rb_hook* p = h->parent();
+    while(p != nullptr && h == p->left) {
+        h = p;
+        p = p->parent();
+    }
+    return p;
+}
@@ -0,0 +1,184 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <new>
+#include <utility>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+
+/*
+Node allocator policies for the tree containers.
+A container takes the policy as a template template parameter and
+instantiates it with its own node type, e.g. AVLTree<int, HeapAllocator>.
+
+Policy interface:
+    Node* create(args...)  - construct a node
+    void destroy(Node*)    - destroy and free one node
+    void release()         - free everything at once, without running destructors
+    void adopt(other)      - take over another allocator's nodes, so trees can be
+                             combined by relinking nodes instead of copying them
+    void share(other)      - also keep other's nodes alive, so a tree can be cut in
+                             two and each part handed some of other's nodes
+    bulkRelease            - whether release() actually frees the nodes
+
+SlabAllocator (the default) carves nodes out of 64 KiB chunks and recycles
+destroyed nodes through an intrusive free list. Trees whose nodes are
+trivially destructible tear down with one release() - O(chunks) - instead
+of visiting every node. Chunks are reference counted, so after share() a
+chunk lives until the last allocator holding it lets go; each allocator
+only ever reuses the slots it destroyed itself.
+*/
+
+template <typename Node>
+class SlabAllocator {
+    union Slot {
+        Slot* next; // while on the free list
+        alignas(Node) unsigned char storage[sizeof(Node)];
+    };
+    static constexpr size_t chunkBytes = 64 * 1024;
+    static constexpr size_t slotsPerChunk() { return std::max<size_t>(1, chunkBytes / sizeof(Slot)); } // lazy - Node may still be incomplete
+
+    struct FreeChunk {
+        void operator()(Slot* chunk) const { ::operator delete(chunk, std::align_val_t(alignof(Slot))); }
+    };
+    using Chunk = std::shared_ptr<Slot>;
+
+    std::vector<Chunk> chunks;
+    Slot* freeList;
+    size_t used; // slots handed out from chunks.back()
+
+    // Adds more to chunks once each, keeping the chunk being carved last
+    void addChunks(const std::vector<Chunk>& more) {
+        Chunk carving;
+        if(!chunks.empty()) {
+            carving = std::move(chunks.back());
+            chunks.pop_back();
+        }
+        chunks.insert(chunks.end(), more.begin(), more.end());
+        auto byAddress = [](const Chunk& a, const Chunk& b) { return a.get() < b.get(); };
+        std::sort(chunks.begin(), chunks.end(), byAddress);
+        chunks.erase(std::unique(chunks.begin(), chunks.end(), [](const Chunk& a, const Chunk& b) { return a.get() == b.get(); }), chunks.end());
+        if(carving) {
+            chunks.erase(std::remove(chunks.begin(), chunks.end(), carving), chunks.end());
+            chunks.push_back(std::move(carving));
+        }
+    }
+public:
+    static constexpr bool bulkRelease = true;
+
+    SlabAllocator() : freeList(nullptr), used(slotsPerChunk()) {}
+    ~SlabAllocator() { release(); }
+    SlabAllocator(const SlabAllocator& alloc) = delete;
+    SlabAllocator(SlabAllocator&& alloc) noexcept
+        : chunks(std::move(alloc.chunks)), freeList(std::exchange(alloc.freeList, nullptr)), used(std::exchange(alloc.used, slotsPerChunk())) {
+        alloc.chunks.clear();
+    }
+    SlabAllocator& operator=(const SlabAllocator& rhs) = delete;
+    SlabAllocator& operator=(SlabAllocator&& rhs) noexcept {
+        if(this != &rhs) {
+            release();
+            chunks = std::move(rhs.chunks);
+            rhs.chunks.clear();
+            freeList = std::exchange(rhs.freeList, nullptr);
+            used = std::exchange(rhs.used, slotsPerChunk());
+        }
+        return *this;
+    }
+
+    template <typename... Args>
+    Node* create(Args&&... args) {
+        Slot* slot;
+        if(freeList) {
+            slot = freeList;
+            freeList = slot->next;
+        } else {
+            if(used == slotsPerChunk()) {
+                chunks.emplace_back(static_cast<Slot*>(::operator new(slotsPerChunk() * sizeof(Slot), std::align_val_t(alignof(Slot)))), FreeChunk());
+                used = 0;
+            }
+            slot = chunks.back().get() + used++;
+        }
+        try {
+            return ::new (static_cast<void*>(slot->storage)) Node(std::forward<Args>(args)...);
+        } catch(...) {
+            slot->next = freeList;
+            freeList = slot;
+            throw;
+        }
+    }
+
+    void destroy(Node* node) {
+        node->~Node();
+        Slot* slot = reinterpret_cast<Slot*>(node);
+        slot->next = freeList;
+        freeList = slot;
+    }
+
+    void adopt(SlabAllocator& other) {
+        // the unused tail of other's last chunk is given up until release()
+        addChunks(other.chunks);
+        other.chunks.clear();
+        while(other.freeList) {
+            Slot* slot = other.freeList;
+            other.freeList = slot->next;
+            slot->next = freeList;
+            freeList = slot;
+        }
+        other.used = slotsPerChunk();
+    }
+
+    // other keeps its chunks, free list and carving position - nodes handed over
+    // from other are simply never destroyed by other again
+    void share(const SlabAllocator& other) {
+        addChunks(other.chunks);
+    }
+
+    void release() { // frees the chunks no other allocator shares
+        chunks.clear();
+        freeList = nullptr;
+        used = slotsPerChunk();
+    }
+};
+
+// Plain new/delete, one allocation per node
+template <typename Node>
+class HeapAllocator {
+public:
+    static constexpr bool bulkRelease = false;
+
+    template <typename... Args>
+    Node* create(Args&&... args) {
+        return new Node(std::forward<Args>(args)...);
+    }
+    void destroy(Node* node) {
+        delete node;
+    }
+    void adopt(HeapAllocator&) {}
+    void share(const HeapAllocator&) {}
+    void release() {}
+};
+
+// Frees a binary tree without recursion or an explicit stack: right-rotate
+// until the current node has no left child, then free it and move right.
+// When the allocator can drop its chunks wholesale and the nodes need no
+// destructor, the walk is skipped entirely.
+template <typename Node, typename Alloc, typename IsNull>
+void destroyBinaryTree(Node* node, Alloc& alloc, IsNull isNull) {
+    if constexpr (Alloc::bulkRelease && std::is_trivially_destructible_v<Node>) {
+        alloc.release();
+        return;
+    }
+    while(!isNull(node)) {
+        if(!isNull(node->left)) {
+            Node* l = node->left;
+            node->left = l->right;
+            l->right = node;
+            node = l;
+        } else {
+            Node* next = node->right;
+            alloc.destroy(node);
+            node = next;
+        }
+    }
+}
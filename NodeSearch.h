@@ -0,0 +1,183 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/*
+Intra-node key search kernels for the B-Tree family.
+nodeLowerBound -> index of the first key not less than k
+nodeUpperBound -> index of the first key greater than k
+
+Keys in a node are sorted, so both bounds are just "how many keys compare
+below k". That count is computed:
+    - with SIMD compares over the whole node for int32/int64/float/double
+      once the node fills one vector (SSE2 always on x86-64, AVX2 when
+      compiled with -mavx2; int64 needs AVX2)
+    - with a branchless binary search for wide nodes of other arithmetic keys
+    - scalar, with an early exit, otherwise (small nodes, non-arithmetic keys)
+Build with -O2 -march=native to pick up AVX2. bench_NodeSearch.cpp measures
+the crossover points the thresholds below were taken from.
+*/
+
+namespace nodesearch {
+
+// node sizes (# keys) at which each kernel starts winning - see bench_NodeSearch.cpp
+// SIMD already beats the mispredicting scalar loop at 3 keys; the branchless
+// binary search ties with the scalar loop at 63 keys and is ~25% faster at 127
+constexpr size_t simdThreshold = 3;
+constexpr size_t branchlessThreshold = 64;
+
+#if defined(__AVX2__)
+constexpr bool haveAVX2 = true;
+#else
+constexpr bool haveAVX2 = false;
+#endif
+
+template <typename T>
+constexpr bool simdKey = std::is_same_v<T, int32_t> || std::is_same_v<T, int64_t> ||
+                         std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+// Scalar path, kept for every key type
+template <bool Upper, typename T>
+inline size_t scalarSearch(const T* keys, size_t n, const T& k) {
+    size_t i = 0;
+    if constexpr (Upper) {
+        while(i < n && !(k < keys[i])) i++;
+    } else {
+        while(i < n && keys[i] < k) i++;
+    }
+    return i;
+}
+
+// Branchless binary search - the loop trip count only depends on n
+template <bool Upper, typename T>
+inline size_t branchlessSearch(const T* keys, size_t n, const T& k) {
+    const T* base = keys;
+    size_t len = n;
+    while(len > 1) {
+        size_t half = len / 2;
+        bool goRight = Upper ? !(k < base[half - 1]) : (base[half - 1] < k);
+        base += goRight ? half : 0; // compiles to cmov
+        len -= half;
+    }
+    if(n == 0) return 0;
+    bool last = Upper ? !(k < *base) : (*base < k);
+    return (base - keys) + last;
+}
+
+#if defined(__SSE2__)
+// Counts keys below k (Upper: keys <= k) with full-width vector compares.
+// Compare masks are all-ones (-1) per matching lane, so subtracting them
+// accumulates the count in-register; lanes are only summed once at the end.
+template <bool Upper, typename T>
+inline size_t simdSearch(const T* keys, size_t n, const T& k) {
+    size_t count = 0;
+    size_t i = 0;
+    if constexpr (std::is_same_v<T, int32_t> || std::is_same_v<T, float>) {
+#if defined(__AVX2__)
+        __m256i acc8 = _mm256_setzero_si256();
+        for(; i + 8 <= n; i += 8) {
+            __m256i m;
+            if constexpr (std::is_same_v<T, int32_t>) {
+                const __m256i kv = _mm256_set1_epi32(Upper ? k + 1 : k); // ints: key <= k <=> key < k+1
+                m = _mm256_cmpgt_epi32(kv, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)));
+            } else {
+                const __m256 kv = _mm256_set1_ps(k);
+                __m256 v = _mm256_loadu_ps(keys + i);
+                m = _mm256_castps_si256(Upper ? _mm256_cmp_ps(v, kv, _CMP_LE_OQ) : _mm256_cmp_ps(v, kv, _CMP_LT_OQ));
+            }
+            acc8 = _mm256_sub_epi32(acc8, m);
+        }
+        __m128i acc = _mm_add_epi32(_mm256_castsi256_si128(acc8), _mm256_extracti128_si256(acc8, 1));
+#else
+        __m128i acc = _mm_setzero_si128();
+#endif
+        for(; i + 4 <= n; i += 4) {
+            __m128i m;
+            if constexpr (std::is_same_v<T, int32_t>) {
+                const __m128i kv = _mm_set1_epi32(Upper ? k + 1 : k);
+                m = _mm_cmpgt_epi32(kv, _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i)));
+            } else {
+                const __m128 kv = _mm_set1_ps(k);
+                __m128 v = _mm_loadu_ps(keys + i);
+                m = _mm_castps_si128(Upper ? _mm_cmple_ps(v, kv) : _mm_cmplt_ps(v, kv));
+            }
+            acc = _mm_sub_epi32(acc, m);
+        }
+        acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+        acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+        count = static_cast<uint32_t>(_mm_cvtsi128_si32(acc));
+    } else if constexpr (std::is_same_v<T, double>) {
+        __m128i acc = _mm_setzero_si128();
+#if defined(__AVX2__)
+        __m256i acc4 = _mm256_setzero_si256();
+        const __m256d kv = _mm256_set1_pd(k);
+        for(; i + 4 <= n; i += 4) {
+            __m256d v = _mm256_loadu_pd(keys + i);
+            __m256d m = Upper ? _mm256_cmp_pd(v, kv, _CMP_LE_OQ) : _mm256_cmp_pd(v, kv, _CMP_LT_OQ);
+            acc4 = _mm256_sub_epi64(acc4, _mm256_castpd_si256(m));
+        }
+        acc = _mm_add_epi64(_mm256_castsi256_si128(acc4), _mm256_extracti128_si256(acc4, 1));
+#endif
+        const __m128d kq = _mm_set1_pd(k);
+        for(; i + 2 <= n; i += 2) {
+            __m128d v = _mm_loadu_pd(keys + i);
+            __m128d m = Upper ? _mm_cmple_pd(v, kq) : _mm_cmplt_pd(v, kq);
+            acc = _mm_sub_epi64(acc, _mm_castpd_si128(m));
+        }
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi64(acc, acc));
+        count = static_cast<size_t>(_mm_cvtsi128_si64(acc));
+    } else if constexpr (std::is_same_v<T, int64_t>) {
+#if defined(__AVX2__)
+        __m256i acc4 = _mm256_setzero_si256();
+        const __m256i kv = _mm256_set1_epi64x(k);
+        for(; i + 4 <= n; i += 4) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+            // Upper counts keys > k, subtracted from the block below
+            acc4 = _mm256_sub_epi64(acc4, Upper ? _mm256_cmpgt_epi64(v, kv) : _mm256_cmpgt_epi64(kv, v));
+        }
+        __m128i acc = _mm_add_epi64(_mm256_castsi256_si128(acc4), _mm256_extracti128_si256(acc4, 1));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi64(acc, acc));
+        count = static_cast<size_t>(_mm_cvtsi128_si64(acc));
+        if constexpr (Upper) count = i - count;
+#endif
+    }
+    // tail (and int64 without AVX2)
+    for(; i < n; i++) {
+        count += Upper ? !(k < keys[i]) : (keys[i] < k);
+    }
+    return count;
+}
+#endif
+
+template <bool Upper, typename T>
+inline size_t search(const T* keys, size_t n, const T& k) {
+    if constexpr (std::is_arithmetic_v<T>) {
+        if constexpr (Upper && std::is_same_v<T, int32_t>) {
+            // k + 1 trick in the int32 kernel cannot represent INT32_MAX
+            if(k == INT32_MAX) return n;
+        }
+#if defined(__SSE2__)
+        if constexpr (simdKey<T> && (!std::is_same_v<T, int64_t> || haveAVX2)) {
+            if(n >= simdThreshold) return simdSearch<Upper>(keys, n, k);
+        }
+#endif
+        if(n >= branchlessThreshold) return branchlessSearch<Upper>(keys, n, k);
+    }
+    return scalarSearch<Upper>(keys, n, k);
+}
+
+} // namespace nodesearch
+
+template <typename T>
+inline size_t nodeLowerBound(const T* keys, size_t n, const T& k) {
+    return nodesearch::search<false>(keys, n, k);
+}
+
+template <typename T>
+inline size_t nodeUpperBound(const T* keys, size_t n, const T& k) {
+    return nodesearch::search<true>(keys, n, k);
+}
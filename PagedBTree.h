@@ -0,0 +1,615 @@
+#pragma once
+#include <iostream>
+#include <queue>
+#include <vector>
+#include <unordered_map>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "NodeSearch.h"
+
+/*
+Disk-backed B-Tree (POSIX)
+Every node is one fixed-size page of a file and child links are page IDs.
+Pages are reached through a CLOCK buffer pool with pin/unpin, or - for a
+tree opened read-only - straight out of a read-only mmap of the file.
+Page 0 holds the metadata (root, page count, free list), so reopening the
+file gives back the same tree. There is no write-ahead log: flush() (also
+run by the destructor) is the durability point.
+*/
+
+using PageId = uint32_t;
+constexpr PageId invalidPage = UINT32_MAX;
+
+template <size_t PageSize>
+class BufferPool {
+    struct Frame {
+        PageId pid = invalidPage;
+        unsigned pins = 0;
+        bool dirty = false;
+        bool referenced = false; // CLOCK second-chance bit
+        char* data = nullptr;
+    };
+    int fd;
+    char* slab; // page-aligned memory for every frame
+    const char* mapped; // read-only mapping, nullptr when using frames
+    size_t mappedPages;
+    std::vector<Frame> frames;
+    std::unordered_map<PageId, size_t> pageTable;
+    size_t hand;
+public:
+    BufferPool(int fd, size_t numFrames, bool mmapReadOnly);
+    ~BufferPool();
+    BufferPool(const BufferPool& pool) = delete;
+    BufferPool& operator=(const BufferPool& pool) = delete;
+
+    char* pin(PageId pid); // fetches the page if needed - stays resident until unpinned
+    void unpin(PageId pid, bool dirty);
+    void flush(); // writes back every dirty frame
+    bool readOnly() const { return mapped != nullptr; }
+private:
+    size_t victim();
+    void readPage(PageId pid, char* data);
+    void writePage(PageId pid, const char* data);
+};
+
+template <size_t PageSize>
+BufferPool<PageSize>::BufferPool(int fd, size_t numFrames, bool mmapReadOnly)
+    : fd(fd), slab(nullptr), mapped(nullptr), mappedPages(0), hand(0) {
+    if(mmapReadOnly) {
+        struct stat st;
+        if(fstat(fd, &st) != 0 || st.st_size == 0) {
+            throw std::runtime_error("EXCEPTION: cannot map an empty page file!");
+        }
+        void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if(addr == MAP_FAILED) {
+            throw std::runtime_error("EXCEPTION: mmap of page file failed!");
+        }
+        mapped = static_cast<const char*>(addr);
+        mappedPages = st.st_size / PageSize;
+        return;
+    }
+    slab = static_cast<char*>(::operator new(numFrames * PageSize, std::align_val_t(PageSize)));
+    frames.resize(numFrames);
+    for(size_t i=0; i<numFrames; i++) {
+        frames[i].data = slab + i * PageSize;
+    }
+}
+
+template <size_t PageSize>
+BufferPool<PageSize>::~BufferPool() {
+    if(mapped) {
+        munmap(const_cast<char*>(mapped), mappedPages * PageSize);
+    } else {
+        ::operator delete(slab, std::align_val_t(PageSize));
+    }
+}
+
+template <size_t PageSize>
+char* BufferPool<PageSize>::pin(PageId pid) {
+    if(mapped) {
+        if(pid >= mappedPages) {
+            throw std::runtime_error("EXCEPTION: page outside of mapped file!");
+        }
+        return const_cast<char*>(mapped + static_cast<size_t>(pid) * PageSize); // PROT_READ - never written
+    }
+    auto it = pageTable.find(pid);
+    if(it != pageTable.end()) {
+        Frame& f = frames[it->second];
+        f.pins++;
+        f.referenced = true;
+        return f.data;
+    }
+    size_t v = victim();
+    Frame& f = frames[v];
+    if(f.pid != invalidPage) {
+        if(f.dirty) {
+            writePage(f.pid, f.data);
+        }
+        pageTable.erase(f.pid);
+    }
+    readPage(pid, f.data);
+    f.pid = pid;
+    f.pins = 1;
+    f.dirty = false;
+    f.referenced = true;
+    pageTable[pid] = v;
+    return f.data;
+}
+
+template <size_t PageSize>
+void BufferPool<PageSize>::unpin(PageId pid, bool dirty) {
+    if(mapped) {
+        return;
+    }
+    Frame& f = frames[pageTable.at(pid)];
+    f.pins--;
+    f.dirty = f.dirty || dirty;
+}
+
+template <size_t PageSize>
+void BufferPool<PageSize>::flush() {
+    for(Frame& f : frames) {
+        if(f.pid != invalidPage && f.dirty) {
+            writePage(f.pid, f.data);
+            f.dirty = false;
+        }
+    }
+}
+
+// CLOCK: sweep the frames, giving recently referenced ones a second chance
+template <size_t PageSize>
+size_t BufferPool<PageSize>::victim() {
+    for(size_t step=0; step < 2 * frames.size(); step++) {
+        size_t idx = hand;
+        hand = (hand + 1) % frames.size();
+        Frame& f = frames[idx];
+        if(f.pins > 0) {
+            continue;
+        }
+        if(f.referenced) {
+            f.referenced = false;
+            continue;
+        }
+        return idx;
+    }
+    throw std::runtime_error("EXCEPTION: every buffer frame is pinned!");
+}
+
+template <size_t PageSize>
+void BufferPool<PageSize>::readPage(PageId pid, char* data) {
+    ssize_t got = pread(fd, data, PageSize, static_cast<off_t>(pid) * PageSize);
+    if(got < 0) {
+        throw std::runtime_error("EXCEPTION: page read failed!");
+    }
+    std::memset(data + got, 0, PageSize - got); // pages past EOF read as zero
+}
+
+template <size_t PageSize>
+void BufferPool<PageSize>::writePage(PageId pid, const char* data) {
+    if(pwrite(fd, data, PageSize, static_cast<off_t>(pid) * PageSize) != static_cast<ssize_t>(PageSize)) {
+        throw std::runtime_error("EXCEPTION: page write failed!");
+    }
+}
+
+template <typename T, size_t PageSize = 4096>
+class PagedBTree {
+    static_assert(std::is_trivially_copyable_v<T>, "paged keys are stored as raw bytes");
+    static constexpr size_t headerSize = 2 * sizeof(uint32_t);
+    static constexpr size_t fit = (PageSize - headerSize - sizeof(PageId)) / (sizeof(T) + sizeof(PageId));
+    static constexpr size_t t = (fit + 1) / 2; // largest degree whose 2t-1 keys fit in a page
+    static constexpr size_t maxKeys = 2 * t - 1;
+    static_assert(t >= 2, "page too small for this key type");
+
+    // in-page layouts
+    struct Node {
+        uint32_t n;
+        uint32_t leaf;
+        T keys[maxKeys];
+        PageId children[maxKeys + 1];
+    };
+    static_assert(sizeof(Node) <= PageSize, "node does not fit in a page");
+    struct FreePage {
+        PageId next;
+    };
+    struct Meta {
+        uint64_t magic;
+        uint32_t pageSize;
+        uint32_t keySize;
+        PageId root;
+        PageId numPages;
+        PageId freeHead;
+    };
+    static constexpr uint64_t fileMagic = 0x45455254422d4250; // "PB-BTREE"
+
+    // RAII pin on one page
+    class PageGuard {
+        BufferPool<PageSize>* pool;
+        PageId pid;
+        Node* node;
+        bool dirty;
+    public:
+        PageGuard(BufferPool<PageSize>* pool, PageId pid) : pool(pool), pid(pid), node(reinterpret_cast<Node*>(pool->pin(pid))), dirty(false) {}
+        ~PageGuard() { release(); }
+        PageGuard(const PageGuard& g) = delete;
+        PageGuard(PageGuard&& g) noexcept : pool(std::exchange(g.pool, nullptr)), pid(g.pid), node(g.node), dirty(g.dirty) {}
+        PageGuard& operator=(PageGuard&& g) noexcept {
+            if(this != &g) {
+                release();
+                pool = std::exchange(g.pool, nullptr);
+                pid = g.pid;
+                node = g.node;
+                dirty = g.dirty;
+            }
+            return *this;
+        }
+        Node* operator->() const { return node; }
+        char* raw() const { return reinterpret_cast<char*>(node); }
+        PageId id() const { return pid; }
+        void markDirty() { dirty = true; }
+        void release() {
+            if(pool) {
+                std::exchange(pool, nullptr)->unpin(pid, dirty);
+            }
+        }
+    };
+
+    int fd;
+    Meta meta;
+    BufferPool<PageSize> pool;
+public:
+    // Opens (or creates) the page file at path. readOnly maps the file and serves lookups only.
+    PagedBTree(const std::string& path, size_t poolFrames = 64, bool readOnly = false);
+    ~PagedBTree();
+    PagedBTree(const PagedBTree& tree) = delete;
+    PagedBTree& operator=(const PagedBTree& rhs) = delete;
+
+    static constexpr size_t degree() { return t; }
+    size_t pageCount() const { return meta.numPages; }
+
+    void insert(const T& k);
+    void remove(const T& k);
+    // Returns page + index within page that k was found at
+    std::pair<PageId, int> search(const T& k);
+    bool contains(const T& k) { return search(k).first != invalidPage; }
+    void flush();
+    void printBTree();
+private:
+    static int openFile(const std::string& path, bool readOnly);
+    void writable() const;
+    void writeMeta();
+    PageGuard newPage();
+    void freePage(PageGuard& g);
+    PageGuard splitChild(PageGuard& x, size_t i, PageGuard& y);
+    T maxKey(const PageGuard& g);
+    T minKey(const PageGuard& g);
+    void mergeNodes(PageGuard& x, size_t i, PageGuard& lhs, PageGuard& rhs);
+    void borrowFromLeft(PageGuard& x, size_t i, PageGuard& child, PageGuard& left);
+    void borrowFromRight(PageGuard& x, size_t i, PageGuard& child, PageGuard& right);
+};
+
+template <typename T, size_t PageSize>
+PagedBTree<T, PageSize>::PagedBTree(const std::string& path, size_t poolFrames, bool readOnly)
+    : fd(openFile(path, readOnly)), meta{}, pool(fd, std::max<size_t>(poolFrames, 8), readOnly) {
+    struct stat st;
+    fstat(fd, &st);
+    if(st.st_size == 0) { // fresh file: meta page + empty root leaf
+        meta = {fileMagic, static_cast<uint32_t>(PageSize), static_cast<uint32_t>(sizeof(T)), 1, 1, invalidPage};
+        newPage(); // root leaf
+        writeMeta();
+        return;
+    }
+    if(pread(fd, &meta, sizeof(Meta), 0) != static_cast<ssize_t>(sizeof(Meta)) || meta.magic != fileMagic) {
+        close(fd);
+        throw std::runtime_error("EXCEPTION: not a B-Tree page file!");
+    }
+    if(meta.pageSize != PageSize || meta.keySize != sizeof(T)) {
+        close(fd);
+        throw std::runtime_error("EXCEPTION: page file has a different page or key size!");
+    }
+}
+
+template <typename T, size_t PageSize>
+PagedBTree<T, PageSize>::~PagedBTree() {
+    if(!pool.readOnly()) {
+        try {
+            flush();
+        } catch(const std::exception& e) {
+            std::cerr << e.what() << "\n";
+        }
+    }
+    close(fd);
+}
+
+template <typename T, size_t PageSize>
+int PagedBTree<T, PageSize>::openFile(const std::string& path, bool readOnly) {
+    int fd = readOnly ? open(path.c_str(), O_RDONLY) : open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if(fd < 0) {
+        throw std::runtime_error("EXCEPTION: cannot open page file " + path);
+    }
+    struct stat st;
+    if(readOnly && (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(2 * PageSize))) {
+        close(fd);
+        throw std::runtime_error("EXCEPTION: page file " + path + " is empty!");
+    }
+    return fd;
+}
+
+template <typename T, size_t PageSize>
+void PagedBTree<T, PageSize>::writable() const {
+    if(pool.readOnly()) {
+        throw std::runtime_error("EXCEPTION: tree was opened read-only!");
+    }
+}
+
+template <typename T, size_t PageSize>
+void PagedBTree<T, PageSize>::writeMeta() {
+    char page[PageSize] = {};
+    std::memcpy(page, &meta, sizeof(Meta));
+    if(pwrite(fd, page, PageSize, 0) != static_cast<ssize_t>(PageSize)) {
+        throw std::runtime_error("EXCEPTION: meta page write failed!");
+    }
+}
+
+template <typename T, size_t PageSize>
+void PagedBTree<T, PageSize>::flush() {
+    writable();
+    pool.flush();
+    writeMeta();
+    fsync(fd);
+}
+
+// Reuses a page from the free list, else grows the file by one page
+template <typename T, size_t PageSize>
+typename PagedBTree<T, PageSize>::PageGuard PagedBTree<T, PageSize>::newPage() {
+    PageId pid = meta.freeHead;
+    if(pid != invalidPage) {
+        PageGuard g(&pool, pid);
+        meta.freeHead = reinterpret_cast<FreePage*>(g.raw())->next;
+        g.release();
+    } else {
+        pid = meta.numPages++;
+    }
+    PageGuard g(&pool, pid);
+    g->n = 0;
+    g->leaf = 1;
+    g.markDirty();
+    return g;
+}
+
+template <typename T, size_t PageSize>
+void PagedBTree<T, PageSize>::freePage(PageGuard& g) {
+    reinterpret_cast<FreePage*>(g.raw())->next = meta.freeHead;
+    meta.freeHead = g.id();
+    g.markDirty();
+    g.release();
+}
+
+template <typename T, size_t PageSize>
+std::pair<PageId, int> PagedBTree<T, PageSize>::search(const T& k) {
+    PageGuard x(&pool, meta.root);
+    while(true) {
+        size_t i = nodeLowerBound(x->keys, x->n, k);
+        if(i < x->n && !(k < x->keys[i])) {
+            return {x.id(), static_cast<int>(i)};
+        }
+        if(x->leaf) {
+            return {invalidPage, -1};
+        }
+        x = PageGuard(&pool, x->children[i]); // reads the deeper page + continue
+    }
+}
+
+template <typename T, size_t PageSize>
+void PagedBTree<T, PageSize>::insert(const T& k) {
+    writable();
+    PageGuard x(&pool, meta.root);
+    if(x->n == maxKeys) { // preemptively split!
+        PageGuard s = newPage();
+        s->leaf = 0;
+        s->children[0] = x.id();
+        meta.root = s.id();
+        PageGuard z = splitChild(s, 0, x);
+        x = std::move(s);
+    }
+    while(!x->leaf) {
+        size_t i = nodeUpperBound(x->keys, x->n, k);
+        PageGuard child(&pool, x->children[i]);
+        if(child->n == maxKeys) {
+            PageGuard z = splitChild(x, i, child);
+            if(x->keys[i] < k) {
+                child = std::move(z);
+            }
+        }
+        x = std::move(child);
+    }
+    size_t i = nodeUpperBound(x->keys, x->n, k);
+    std::move_backward(x->keys + i, x->keys + x->n, x->keys + x->n + 1);
+    x->keys[i] = k;
+    x->n += 1;
+    x.markDirty();
+}
+
+// Splits the full child y = x->children[i]; returns the new right sibling
+template <typename T, size_t PageSize>
+typename PagedBTree<T, PageSize>::PageGuard PagedBTree<T, PageSize>::splitChild(PageGuard& x, size_t i, PageGuard& y) {
+    PageGuard z = newPage();
+    z->leaf = y->leaf;
+    z->n = t - 1;
+    std::copy(y->keys + t, y->keys + maxKeys, z->keys);
+    if(!y->leaf) {
+        std::copy(y->children + t, y->children + maxKeys + 1, z->children);
+    }
+    y->n = t - 1;
+
+    std::move_backward(x->keys + i, x->keys + x->n, x->keys + x->n + 1);
+    std::copy_backward(x->children + i + 1, x->children + x->n + 1, x->children + x->n + 2);
+    x->keys[i] = y->keys[t - 1];
+    x->children[i + 1] = z.id();
+    x->n += 1;
+    x.markDirty();
+    y.markDirty();
+    return z;
+}
+
+// CLRS deletion, iterative - at most four pages are pinned at a time
+template <typename T, size_t PageSize>
+void PagedBTree<T, PageSize>::remove(const T& k) {
+    writable();
+    T key = k; // becomes the predecessor/successor once k is replaced in an internal page
+    PageGuard x(&pool, meta.root);
+    while(true) {
+        size_t i = nodeLowerBound(x->keys, x->n, key);
+        bool found = i < x->n && !(key < x->keys[i]);
+        if(x->leaf) {
+            // Case 1: delete straight from the leaf
+            if(found) {
+                std::copy(x->keys + i + 1, x->keys + x->n, x->keys + i);
+                x->n -= 1;
+                x.markDirty();
+            }
+            break;
+        }
+        if(found) {
+            PageGuard predec(&pool, x->children[i]);
+            if(predec->n >= t) { // 2a: replace with predecessor
+                key = maxKey(predec);
+                x->keys[i] = key;
+                x.markDirty();
+                x = std::move(predec);
+                continue;
+            }
+            PageGuard succ(&pool, x->children[i + 1]);
+            if(succ->n >= t) { // 2b: replace with successor
+                key = minKey(succ);
+                x->keys[i] = key;
+                x.markDirty();
+                x = std::move(succ);
+                continue;
+            }
+            mergeNodes(x, i, predec, succ); // 2c
+            x = std::move(predec);
+            continue;
+        }
+        // Case 3: make sure the child on k's path can lose a key
+        PageGuard child(&pool, x->children[i]);
+        if(child->n == t - 1) {
+            if(i > 0) {
+                PageGuard left(&pool, x->children[i - 1]);
+                if(left->n >= t) {
+                    borrowFromLeft(x, i, child, left);
+                    x = std::move(child);
+                    continue;
+                }
+                if(i == x->n) {
+                    mergeNodes(x, i - 1, left, child);
+                    x = std::move(left);
+                    continue;
+                }
+            }
+            PageGuard right(&pool, x->children[i + 1]);
+            if(right->n >= t) {
+                borrowFromRight(x, i, child, right);
+            } else {
+                mergeNodes(x, i, child, right);
+            }
+        }
+        x = std::move(child);
+    }
+    x.release();
+    PageGuard r(&pool, meta.root);
+    if(r->n == 0 && !r->leaf) { // root was merged away
+        meta.root = r->children[0];
+        freePage(r);
+    }
+}
+
+template <typename T, size_t PageSize>
+T PagedBTree<T, PageSize>::maxKey(const PageGuard& g) {
+    if(g->leaf) {
+        return g->keys[g->n - 1];
+    }
+    PageGuard y(&pool, g->children[g->n]);
+    while(!y->leaf) {
+        y = PageGuard(&pool, y->children[y->n]);
+    }
+    return y->keys[y->n - 1];
+}
+
+template <typename T, size_t PageSize>
+T PagedBTree<T, PageSize>::minKey(const PageGuard& g) {
+    if(g->leaf) {
+        return g->keys[0];
+    }
+    PageGuard y(&pool, g->children[0]);
+    while(!y->leaf) {
+        y = PageGuard(&pool, y->children[0]);
+    }
+    return y->keys[0];
+}
+
+// Merges x->keys[i] and rhs into lhs (both hold t-1 keys) and frees rhs's page
+template <typename T, size_t PageSize>
+void PagedBTree<T, PageSize>::mergeNodes(PageGuard& x, size_t i, PageGuard& lhs, PageGuard& rhs) {
+    lhs->keys[lhs->n] = x->keys[i];
+    std::copy(rhs->keys, rhs->keys + rhs->n, lhs->keys + lhs->n + 1);
+    if(!lhs->leaf) {
+        std::copy(rhs->children, rhs->children + rhs->n + 1, lhs->children + lhs->n + 1);
+    }
+    lhs->n += rhs->n + 1;
+    std::copy(x->keys + i + 1, x->keys + x->n, x->keys + i);
+    std::copy(x->children + i + 2, x->children + x->n + 1, x->children + i + 1);
+    x->n -= 1;
+    x.markDirty();
+    lhs.markDirty();
+    freePage(rhs);
+}
+
+template <typename T, size_t PageSize>
+void PagedBTree<T, PageSize>::borrowFromLeft(PageGuard& x, size_t i, PageGuard& child, PageGuard& left) {
+    std::copy_backward(child->keys, child->keys + child->n, child->keys + child->n + 1);
+    child->keys[0] = x->keys[i - 1];
+    x->keys[i - 1] = left->keys[left->n - 1];
+    if(!child->leaf) {
+        std::copy_backward(child->children, child->children + child->n + 1, child->children + child->n + 2);
+        child->children[0] = left->children[left->n];
+    }
+    child->n += 1;
+    left->n -= 1;
+    x.markDirty();
+    child.markDirty();
+    left.markDirty();
+}
+
+template <typename T, size_t PageSize>
+void PagedBTree<T, PageSize>::borrowFromRight(PageGuard& x, size_t i, PageGuard& child, PageGuard& right) {
+    child->keys[child->n] = x->keys[i];
+    x->keys[i] = right->keys[0];
+    std::copy(right->keys + 1, right->keys + right->n, right->keys);
+    if(!child->leaf) {
+        child->children[child->n + 1] = right->children[0];
+        std::copy(right->children + 1, right->children + right->n + 1, right->children);
+    }
+    child->n += 1;
+    right->n -= 1;
+    x.markDirty();
+    child.markDirty();
+    right.markDirty();
+}
+
+template <typename T, size_t PageSize>
+void PagedBTree<T, PageSize>::printBTree() {
+    std::queue<std::pair<PageId, int>> q;
+    int lvl = 0;
+    q.push({meta.root, 0});
+    while(!q.empty()) {
+        std::pair<PageId, int> curr = q.front();
+        q.pop();
+        if(curr.second > lvl) {
+            std::cout << "\n";
+            lvl = curr.second;
+        }
+        PageGuard x(&pool, curr.first);
+        std::cout << "[" << curr.first << "] ";
+        for(size_t i=0; i<x->n; i++) {
+            std::cout << x->keys[i] << " ";
+        }
+        std::cout << "\t";
+        if(!x->leaf) {
+            for(size_t i=0; i<=x->n; i++) {
+                q.push({x->children[i], curr.second + 1});
+            }
+        }
+    }
+    std::cout << "\n";
+}
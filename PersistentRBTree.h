@@ -0,0 +1,529 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+/*
+Persistent Red-Black Tree (path copying) for many readers and one writer
+A PersistentRBTree is an immutable version of an ordered set. insert and
+remove leave it untouched and return a new version that shares every
+subtree off the changed path - O(log n) new nodes per update. Versions are
+cheap values: copying one bumps a count, and any thread may hold, search or
+drop a version while a writer builds the next one.
+
+Nodes are reference counted (one count per parent, across all versions,
+plus one per version whose root it is) and freed when the last version
+that reaches them goes away. While building a version, a node whose count
+is 1 and whose parent is already private to the version is updated in place
+instead of copied - so an update never copies a node twice, and a version
+nobody else shares is modified without copying at all.
+
+There are no parent links - a node has many parents across versions - so
+the CLRS fixups of RBTree run over an explicit stack of the path instead.
+Nodes come from new/delete rather than a per-tree allocator: they are
+shared between versions and freed by whichever thread drops the last one.
+
+VersionedRBTree publishes the current version to readers:
+    snapshot() - the current version; readers search it without locks
+    update(f)  - the writer replaces the current version with f(current)
+snapshot() only pins an epoch slot for the two instructions it takes to
+take a reference to the current root, so writers never wait for readers and
+readers never wait for writers. A replaced root is released once no pinned
+slot can still be reading it.
+*/
+
+template <typename T>
+class VersionedRBTree;
+
+template <typename T>
+class PersistentRBTree {
+    friend class VersionedRBTree<T>;
+    static constexpr size_t maxHeight = 130; // red-black height <= 2 log2(n + 1), and n < 2^64
+
+    struct Node {
+        T key;
+        Node* left;
+        Node* right;
+        bool red;
+        std::atomic<uint32_t> refs;
+        Node(const T& key, Node* left, Node* right, bool red) : key(key), left(left), right(right), red(red), refs(1) {}
+    };
+
+    Node* root;
+    size_t count;
+
+    PersistentRBTree(Node* root, size_t count) : root(root), count(count) {} // takes over a reference to root
+
+    static bool isRed(const Node* x) { return x != nullptr && x->red; } // empty links are black
+    static void retain(Node* x);
+    static void release(Node* x);
+    static Node* own(Node*& link);
+
+    void rotateLeft(Node* x, Node* parent);
+    void rotateRight(Node* x, Node* parent);
+    void insertFixup(Node* z, Node** path, size_t depth);
+    void removeFixup(Node* x, Node** path, size_t depth);
+    void insertInPlace(const T& val);
+    void removeInPlace(const T& val);
+public:
+    PersistentRBTree() : root(nullptr), count(0) {}
+    PersistentRBTree(const PersistentRBTree& tree) : root(tree.root), count(tree.count) { retain(root); }
+    PersistentRBTree(PersistentRBTree&& tree) noexcept : root(std::exchange(tree.root, nullptr)), count(std::exchange(tree.count, 0)) {}
+    PersistentRBTree& operator=(PersistentRBTree rhs) noexcept { // copy-and-swap
+        std::swap(root, rhs.root);
+        std::swap(count, rhs.count);
+        return *this;
+    }
+    ~PersistentRBTree() { release(root); }
+
+    PersistentRBTree insert(const T& val) const&; // an equal key is replaced by val
+    PersistentRBTree remove(const T& val) const&; // the same version if val is absent
+    PersistentRBTree insert(const T& val) &&; // v = std::move(v).insert(x) and chained calls reuse nodes only v held
+    PersistentRBTree remove(const T& val) &&;
+
+    template <typename K>
+    const T* find(const K& key) const;
+    template <typename K>
+    bool contains(const K& key) const { return find(key) != nullptr; }
+    const T* min() const;
+    const T* max() const;
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    template <typename F>
+    void forEach(F visit) const; // in key order
+};
+
+template <typename T>
+void PersistentRBTree<T>::retain(Node* x) {
+    if(x != nullptr) {
+        x->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// Drops one reference - the last one frees x and drops x's references to its children
+template <typename T>
+void PersistentRBTree<T>::release(Node* x) {
+    while(x != nullptr && x->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        release(x->left); // depth is bounded by the height
+        Node* next = x->right;
+        delete x;
+        x = next;
+    }
+}
+
+// Makes the node at link private to the version being built, copying it if anything else shares it.
+// The link itself must already be private.
+template <typename T>
+typename PersistentRBTree<T>::Node* PersistentRBTree<T>::own(Node*& link) {
+    Node* x = link;
+    if(x->refs.load(std::memory_order_acquire) == 1) {
+        return x;
+    }
+    Node* copy = new Node(x->key, x->left, x->right, x->red);
+    retain(copy->left);
+    retain(copy->right);
+    link = copy;
+    release(x); // never the last reference - another version still holds x
+    return copy;
+}
+
+// The rotations only move links, so no count changes; x and its rotating child must be private
+template <typename T>
+void PersistentRBTree<T>::rotateLeft(Node* x, Node* parent) {
+    Node* y = x->right;
+    x->right = y->left;
+    if(parent == nullptr) {
+        root = y;
+    } else if(parent->left == x) {
+        parent->left = y;
+    } else {
+        parent->right = y;
+    }
+    y->left = x;
+}
+
+template <typename T>
+void PersistentRBTree<T>::rotateRight(Node* x, Node* parent) {
+    Node* y = x->left;
+    x->left = y->right;
+    if(parent == nullptr) {
+        root = y;
+    } else if(parent->left == x) {
+        parent->left = y;
+    } else {
+        parent->right = y;
+    }
+    y->right = x;
+}
+
+template <typename T>
+void PersistentRBTree<T>::insertInPlace(const T& val) {
+    Node* path[maxHeight]; // private ancestors of the new node, root first
+    size_t depth = 0;
+    Node** link = &root;
+    while(*link != nullptr) {
+        Node* x = own(*link);
+        if(val < x->key) {
+            link = &x->left;
+        } else if(x->key < val) {
+            link = &x->right;
+        } else {
+            x->key = val;
+            return;
+        }
+        path[depth++] = x;
+    }
+    Node* z = new Node(val, nullptr, nullptr, true);
+    *link = z;
+    count++;
+    insertFixup(z, path, depth);
+}
+
+// CLRS RB-INSERT-FIXUP on the path stack - path[depth-1] is z's parent
+template <typename T>
+void PersistentRBTree<T>::insertFixup(Node* z, Node** path, size_t depth) {
+    while(depth > 0 && path[depth - 1]->red) { // a red parent is never the root, so depth >= 2
+        Node* p = path[depth - 1];
+        Node* g = path[depth - 2];
+        Node* gg = depth > 2 ? path[depth - 3] : nullptr;
+        if(p == g->left) {
+            if(isRed(g->right)) { // case 1 - recolor and move up
+                own(g->right)->red = false;
+                p->red = false;
+                g->red = true;
+                z = g;
+                depth -= 2;
+            } else {
+                if(z == p->right) { // case 2 - rotate into case 3
+                    rotateLeft(p, g);
+                    std::swap(z, p);
+                }
+                p->red = false; // case 3
+                g->red = true;
+                rotateRight(g, gg);
+                break;
+            }
+        } else { // symmetric
+            if(isRed(g->left)) {
+                own(g->left)->red = false;
+                p->red = false;
+                g->red = true;
+                z = g;
+                depth -= 2;
+            } else {
+                if(z == p->left) {
+                    rotateRight(p, g);
+                    std::swap(z, p);
+                }
+                p->red = false;
+                g->red = true;
+                rotateLeft(g, gg);
+                break;
+            }
+        }
+    }
+    root->red = false; // the root is always on the path, so private
+}
+
+template <typename T>
+void PersistentRBTree<T>::removeInPlace(const T& val) {
+    Node* path[maxHeight]; // private ancestors of the unlinked node, root first
+    size_t depth = 0;
+    Node** link = &root;
+    Node* z = own(*link); // the caller checked that val is present
+    while(val < z->key || z->key < val) {
+        path[depth++] = z;
+        link = val < z->key ? &z->left : &z->right;
+        z = own(*link);
+    }
+    if(z->left != nullptr && z->right != nullptr) {
+        // two children - z takes its successor's key, and the successor is unlinked instead
+        path[depth++] = z;
+        link = &z->right;
+        Node* y = own(*link);
+        while(y->left != nullptr) {
+            path[depth++] = y;
+            link = &y->left;
+            y = own(*link);
+        }
+        z->key = y->key;
+        z = y;
+    }
+    // z has at most one child, which takes its place - the child's count is unchanged, it still has one parent
+    Node* x = z->left != nullptr ? z->left : z->right;
+    *link = x;
+    bool removedBlack = !z->red;
+    delete z; // private, so this version held its only reference
+    count--;
+    if(removedBlack) {
+        if(isRed(x)) {
+            own(*link)->red = false; // the red child absorbs the missing black
+        } else {
+            removeFixup(x, path, depth);
+        }
+    }
+}
+
+// CLRS RB-DELETE-FIXUP on the path stack - path[depth-1] is x's parent, and x (possibly empty) is black
+template <typename T>
+void PersistentRBTree<T>::removeFixup(Node* x, Node** path, size_t depth) {
+    while(depth > 0 && !isRed(x)) {
+        Node* xp = path[depth - 1];
+        Node* gp = depth > 1 ? path[depth - 2] : nullptr;
+        if(x == xp->left) {
+            Node* w = own(xp->right); // the sibling - never empty, and recolored in every case
+            if(w->red) { // case 1 - w rises above xp
+                w->red = false;
+                xp->red = true;
+                rotateLeft(xp, gp);
+                path[depth - 1] = w;
+                path[depth++] = xp;
+                w = own(xp->right);
+            }
+            if(!isRed(w->left) && !isRed(w->right)) { // case 2
+                w->red = true;
+                x = xp;
+                depth--;
+            } else {
+                if(!isRed(w->right)) { // case 3
+                    own(w->left)->red = false;
+                    w->red = true;
+                    rotateRight(w, xp);
+                    w = xp->right;
+                }
+                w->red = xp->red; // case 4
+                xp->red = false;
+                own(w->right)->red = false;
+                rotateLeft(xp, depth > 1 ? path[depth - 2] : nullptr); // case 1 may have changed xp's parent
+                x = root;
+                break;
+            }
+        } else { // symmetric
+            Node* w = own(xp->left);
+            if(w->red) {
+                w->red = false;
+                xp->red = true;
+                rotateRight(xp, gp);
+                path[depth - 1] = w;
+                path[depth++] = xp;
+                w = own(xp->left);
+            }
+            if(!isRed(w->right) && !isRed(w->left)) {
+                w->red = true;
+                x = xp;
+                depth--;
+            } else {
+                if(!isRed(w->left)) {
+                    own(w->right)->red = false;
+                    w->red = true;
+                    rotateLeft(w, xp);
+                    w = xp->left;
+                }
+                w->red = xp->red;
+                xp->red = false;
+                own(w->left)->red = false;
+                rotateRight(xp, depth > 1 ? path[depth - 2] : nullptr);
+                x = root;
+                break;
+            }
+        }
+    }
+    if(x != nullptr) {
+        x->red = false; // the root or a private ancestor
+    }
+}
+
+template <typename T>
+PersistentRBTree<T> PersistentRBTree<T>::insert(const T& val) const& {
+    return PersistentRBTree(*this).insert(val); // the copy shares every node - the first own() copies the root
+}
+
+template <typename T>
+PersistentRBTree<T> PersistentRBTree<T>::remove(const T& val) const& {
+    return PersistentRBTree(*this).remove(val);
+}
+
+template <typename T>
+PersistentRBTree<T> PersistentRBTree<T>::insert(const T& val) && {
+    insertInPlace(val);
+    return std::move(*this);
+}
+
+template <typename T>
+PersistentRBTree<T> PersistentRBTree<T>::remove(const T& val) && {
+    if(contains(val)) { // otherwise the descent would copy a path for nothing
+        removeInPlace(val);
+    }
+    return std::move(*this);
+}
+
+template <typename T>
+template <typename K>
+const T* PersistentRBTree<T>::find(const K& key) const {
+    const Node* x = root;
+    while(x != nullptr) {
+        if(key < x->key) {
+            x = x->left;
+        } else if(x->key < key) {
+            x = x->right;
+        } else {
+            return &x->key;
+        }
+    }
+    return nullptr;
+}
+
+template <typename T>
+const T* PersistentRBTree<T>::min() const {
+    if(root == nullptr) {
+        return nullptr;
+    }
+    const Node* x = root;
+    while(x->left != nullptr) {
+        x = x->left;
+    }
+    return &x->key;
+}
+
+template <typename T>
+const T* PersistentRBTree<T>::max() const {
+    if(root == nullptr) {
+        return nullptr;
+    }
+    const Node* x = root;
+    while(x->right != nullptr) {
+        x = x->right;
+    }
+    return &x->key;
+}
+
+template <typename T>
+template <typename F>
+void PersistentRBTree<T>::forEach(F visit) const {
+    const Node* stack[maxHeight];
+    size_t depth = 0;
+    const Node* x = root;
+    while(x != nullptr || depth > 0) {
+        while(x != nullptr) {
+            stack[depth++] = x;
+            x = x->left;
+        }
+        x = stack[--depth];
+        visit(x->key);
+        x = x->right;
+    }
+}
+
+template <typename T>
+class VersionedRBTree {
+    using Version = PersistentRBTree<T>;
+    using Node = typename Version::Node;
+    static constexpr size_t slots = 64; // concurrent snapshot() calls beyond this spin for a free slot
+
+    struct Head { // what readers load - root and size change together
+        Node* root;
+        size_t count;
+    };
+
+    std::atomic<Head*> current;
+    std::atomic<uint64_t> epoch;
+    mutable std::atomic<uint64_t> pins[slots]; // 0 - idle, otherwise the epoch the reader started in
+    std::mutex writer;
+    std::vector<std::pair<Head*, uint64_t>> retired; // replaced heads and the epoch they were replaced in
+
+    void publishLocked(const Version& next);
+    void reclaim();
+public:
+    VersionedRBTree() : current(new Head{nullptr, 0}), epoch(1) {
+        for(std::atomic<uint64_t>& pin : pins) {
+            pin.store(0, std::memory_order_relaxed);
+        }
+    }
+    ~VersionedRBTree();
+    VersionedRBTree(const VersionedRBTree& tree) = delete;
+    VersionedRBTree& operator=(const VersionedRBTree& rhs) = delete;
+
+    Version snapshot() const;
+    void publish(const Version& next);
+    template <typename F>
+    void update(F f); // publishes f(current version) - writers are serialized
+};
+
+template <typename T>
+VersionedRBTree<T>::~VersionedRBTree() {
+    for(auto& [head, e] : retired) {
+        Version::release(head->root);
+        delete head;
+    }
+    Head* head = current.load(std::memory_order_relaxed);
+    Version::release(head->root);
+    delete head;
+}
+
+template <typename T>
+typename VersionedRBTree<T>::Version VersionedRBTree<T>::snapshot() const {
+    size_t slot = std::hash<std::thread::id>()(std::this_thread::get_id()) % slots;
+    uint64_t e = epoch.load();
+    uint64_t idle = 0;
+    while(!pins[slot].compare_exchange_weak(idle, e)) { // seq_cst - the pin is visible before current is read
+        idle = 0;
+        slot = (slot + 1) % slots;
+    }
+    Head* head = current.load();
+    Version::retain(head->root);
+    Version v(head->root, head->count);
+    pins[slot].store(0, std::memory_order_release);
+    return v;
+}
+
+template <typename T>
+void VersionedRBTree<T>::publish(const Version& next) {
+    std::lock_guard<std::mutex> lock(writer);
+    publishLocked(next);
+}
+
+template <typename T>
+template <typename F>
+void VersionedRBTree<T>::update(F f) {
+    std::lock_guard<std::mutex> lock(writer);
+    Head* head = current.load(std::memory_order_relaxed); // only writers replace it, and we hold the lock
+    Version::retain(head->root);
+    publishLocked(f(Version(head->root, head->count)));
+}
+
+template <typename T>
+void VersionedRBTree<T>::publishLocked(const Version& next) {
+    Version::retain(next.root);
+    Head* old = current.exchange(new Head{next.root, next.count});
+    retired.emplace_back(old, epoch.fetch_add(1));
+    reclaim();
+}
+
+// A head replaced in epoch E may still be read by a reader that pinned E or earlier;
+// readers that pin later load current after the exchange and see its successor
+template <typename T>
+void VersionedRBTree<T>::reclaim() {
+    uint64_t oldest = UINT64_MAX;
+    for(const std::atomic<uint64_t>& pin : pins) {
+        uint64_t e = pin.load();
+        if(e != 0 && e < oldest) {
+            oldest = e;
+        }
+    }
+    size_t kept = 0;
+    for(auto& [head, e] : retired) {
+        if(e < oldest) {
+            Version::release(head->root);
+            delete head;
+        } else {
+            retired[kept++] = {head, e};
+        }
+    }
+    retired.resize(kept);
+}
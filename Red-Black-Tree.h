@@ -3,33 +3,101 @@
 #include <queue>
 #include <utility>
 #include <cmath>
+#include <iterator>
+#include <cstddef>
+#include <type_traits>
+#include <cstdint>
+#include <new>
+#include "NodeAllocator.h"
+#include "FrozenTree.h"
 
 typedef enum { RED, BLACK } Color;
 
+// Closed interval [low, high] - as a key it orders by low, then high
+template <typename E>
+struct Interval {
+    E low;
+    E high;
+    bool operator<(const Interval& rhs) const { return low < rhs.low || (!(rhs.low < low) && high < rhs.high); }
+    bool operator==(const Interval& rhs) const { return !(*this < rhs) && !(rhs < *this); }
+    bool overlaps(const Interval& rhs) const { return !(high < rhs.low) && !(rhs.high < low); }
+};
+
+// Extra per-node state - none for plain keys (an empty base adds no bytes),
+// the largest endpoint in the subtree for Interval keys (the interval tree of CLRS 14.3)
+template <typename T>
+struct RBAugment {
+    static constexpr bool enabled = false;
+    RBAugment() {}
+    explicit RBAugment(const T&) {}
+};
+
+template <typename E>
+struct RBAugment<Interval<E>> {
+    static constexpr bool enabled = true;
+    E maxHigh;
+    RBAugment() : maxHigh() {}
+    explicit RBAugment(const Interval<E>& val) : maxHigh(val.high) {}
+};
+
+// The key lives in a union so the sentinel can leave it unconstructed - T needs
+// no default or zero value. Real nodes destroy it; the sentinel's is never touched
+template <typename T, bool = std::is_trivially_destructible_v<T>>
+struct RBKey {
+    union { T key; };
+    RBKey() {}
+    explicit RBKey(const T& val) : key(val) {}
+};
+
+template <typename T>
+struct RBKey<T, false> {
+    union { T key; };
+    RBKey() {}
+    explicit RBKey(const T& val) : key(val) {}
+    ~RBKey() { key.~T(); }
+};
+
+// The color is the low bit of the parent pointer - nodes are pointer-aligned, so the bit is
+// always free - which saves the padded Color field: 32 bytes instead of 40 for 8-byte keys
 template <typename T>
-class RBTreeNode {
+class RBTreeNode : public RBAugment<T>, public RBKey<T> {
+    uintptr_t parentColor;
 public:
-    RBTreeNode<T>* parent;
     RBTreeNode<T>* left;
     RBTreeNode<T>* right;
-    Color color;
-    T key;
+
+    struct SentinelTag {};
+    explicit RBTreeNode(SentinelTag) 
+        : parentColor(BLACK), left(nullptr), right(nullptr) {}
     RBTreeNode(T val, Color color_=RED) 
-        : key(val), parent(nullptr), left(nullptr), right(nullptr), color(color_) {}
-    
-    ~RBTreeNode() {
-        if(left) { delete left; }
-        if(right) { delete right; }
-    }
+        : RBAugment<T>(val), RBKey<T>(val), parentColor(color_), left(nullptr), right(nullptr) {}
+
+    RBTreeNode<T>* parent() const { return reinterpret_cast<RBTreeNode<T>*>(parentColor & ~uintptr_t(1)); }
+    Color color() const { return static_cast<Color>(parentColor & 1); }
+    void setParent(RBTreeNode<T>* p) { parentColor = reinterpret_cast<uintptr_t>(p) | (parentColor & 1); }
+    void setColor(Color c) { parentColor = (parentColor & ~uintptr_t(1)) | c; }
 };
 
 // Since template - should include error handling if type does not overload <  or > 
-template <typename T>
+// Nodes come from the Alloc policy (see NodeAllocator.h); the sentinel is built in place
+// inside the tree without a key, so trees can be neither copied nor moved
+// Iterators walk in order along the parent links - end() is the sentinel
+// With Interval<E> keys every node also keeps its subtree's max endpoint, which
+// rotations recompute locally and insert/remove refresh along the changed path;
+// overlaps() uses it to skip subtrees that end before the query starts
+// The minimum and maximum nodes are cached, so append_max and insert_hint can link
+// a new node next to its neighbour without descending from the root - with the
+// fixup's amortized O(1) recoloring, sorted or well-hinted streams insert in O(1) amortized
+template <typename T, template <typename> class Alloc = SlabAllocator>
 class RBTree {
 private:
     int size;
+    Alloc<RBTreeNode<T>> alloc;
     RBTreeNode<T>* root;
+    alignas(RBTreeNode<T>) unsigned char sentinelSpace[sizeof(RBTreeNode<T>)];
     RBTreeNode<T>* sentinel;
+    RBTreeNode<T>* minNode; // sentinel while empty
+    RBTreeNode<T>* maxNode;
 
     void leftRotate(RBTreeNode<T>* x);
     void rightRotate(RBTreeNode<T>* x);
@@ -37,174 +105,318 @@ private:
     void removeFixup(RBTreeNode<T>* x);
 
     void transplant(RBTreeNode<T>* u, RBTreeNode<T>* v); // replaces subtree of u with that of v
+    RBTreeNode<T>* attach(RBTreeNode<T>* y, bool asLeft, T val); // links a new red leaf under y (the root if y is the sentinel)
+
+    void augment(RBTreeNode<T>* x); // recomputes x's max endpoint from its children
+    void augmentUpward(RBTreeNode<T>* x); // ... and that of every ancestor
+    template <typename E, typename Visitor>
+    void overlapsFrom(const RBTreeNode<T>* x, const E& low, const E& high, Visitor& visit) const;
+
+    const RBTreeNode<T>* successor(const RBTreeNode<T>* x) const;
+    const RBTreeNode<T>* predecessor(const RBTreeNode<T>* x) const;
 
 public: // simple API...
+    class const_iterator;
+    using iterator = const_iterator; // keys are never modified in place - it would break the order
+
     RBTree();
+    RBTree(const RBTree& tree) = delete;
+    RBTree& operator=(const RBTree& rhs) = delete;
     ~RBTree();
 
-    void insert(T val);
+    RBTreeNode<T>* insert(T val); // returns the new node
+    RBTreeNode<T>* insert_hint(RBTreeNode<T>* hint, T val); // hint - the node val belongs just before, nullptr for the end
+    RBTreeNode<T>* append_max(T val); // O(1) amortized when val is not below the maximum
     void remove(T val);
     RBTreeNode<T>* search(T val) const;
 
-    RBTreeNode<T>* treeMin(RBTreeNode<T>* x);
+    RBTreeNode<T>* treeMin(RBTreeNode<T>* x); // O(1) for the root
     RBTreeNode<T>* treeMax(RBTreeNode<T>* x);
     void print();
+
+    const_iterator begin() const;
+    const_iterator end() const;
+    template <typename K>
+    const_iterator lower_bound(const K& val) const; // first key not less than val
+    template <typename K>
+    const_iterator upper_bound(const K& val) const; // first key greater than val
+    template <typename K>
+    std::pair<const_iterator, const_iterator> equal_range(const K& val) const; // every copy of val
+
+    FrozenTree<T> freeze() const { return FrozenTree<T>(begin(), end()); } // read-only pointer-free copy
+
+    // Interval keys only - calls visit(interval) for each stored interval that overlaps q,
+    // a point or an Interval, in key order and without allocating
+    template <typename Q, typename Visitor>
+    void overlaps(const Q& q, Visitor visit) const;
 };
 
-template <typename T>
-RBTree<T>::RBTree() {
-    sentinel = new RBTreeNode<T>(0, BLACK);
-    sentinel->parent = sentinel; // sentinel's parent is itself - for safety
+template <typename T, template <typename> class Alloc>
+class RBTree<T, Alloc>::const_iterator {
+    friend class RBTree;
+    const RBTreeNode<T>* node;
+    const RBTree* tree;
+    const_iterator(const RBTreeNode<T>* node, const RBTree* tree) : node(node), tree(tree) {}
+public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+    const_iterator() : node(nullptr), tree(nullptr) {}
+
+    reference operator*() const { return node->key; }
+    pointer operator->() const { return &node->key; }
+
+    const_iterator& operator++() {
+        node = tree->successor(node);
+        return *this;
+    }
+    const_iterator operator++(int) {
+        const_iterator old = *this;
+        ++*this;
+        return old;
+    }
+    const_iterator& operator--() {
+        node = tree->predecessor(node); // from end() this is the maximum
+        return *this;
+    }
+    const_iterator operator--(int) {
+        const_iterator old = *this;
+        --*this;
+        return old;
+    }
+
+    bool operator==(const const_iterator& rhs) const { return node == rhs.node; }
+    bool operator!=(const const_iterator& rhs) const { return node != rhs.node; }
+};
+
+template <typename T, template <typename> class Alloc>
+RBTree<T, Alloc>::RBTree() : size(0) {
+    sentinel = new (sentinelSpace) RBTreeNode<T>(typename RBTreeNode<T>::SentinelTag());
+    sentinel->setParent(sentinel); // sentinel's parent is itself - for safety
     root = sentinel;
+    minNode = sentinel;
+    maxNode = sentinel;
 }
 
-template <typename T>
-RBTree<T>::~RBTree() {
-    delete sentinel;
+template <typename T, template <typename> class Alloc>
+RBTree<T, Alloc>::~RBTree() {
+    // iterative - or O(chunks) when nodes are trivially destructible
+    destroyBinaryTree(root, alloc, [this](RBTreeNode<T>* x) { return x == sentinel; });
+    static_cast<RBAugment<T>*>(sentinel)->~RBAugment(); // its key was never constructed
 }
 
-template <typename T>
-RBTreeNode<T>* RBTree<T>::treeMin(RBTreeNode<T>* x) {
-    if(x->left != sentinel) {
-        return treeMin(x->left);
+template <typename T, template <typename> class Alloc>
+RBTreeNode<T>* RBTree<T, Alloc>::treeMin(RBTreeNode<T>* x) {
+    if(x == root) {
+        return minNode;
+    }
+    while(x->left != sentinel) {
+        x = x->left;
     }
     return x;
 }
 
-template <typename T>
-RBTreeNode<T>* RBTree<T>::treeMax(RBTreeNode<T>* x) {
-    if(x->right != sentinel) {
-        return treeMin(x->right);
+template <typename T, template <typename> class Alloc>
+RBTreeNode<T>* RBTree<T, Alloc>::treeMax(RBTreeNode<T>* x) {
+    if(x == root) {
+        return maxNode;
+    }
+    while(x->right != sentinel) {
+        x = x->right;
     }
     return x;
 }
 
-template <typename T>
-void RBTree<T>::leftRotate(RBTreeNode<T>* x) { // throw X to the left - replace with its right child
+template <typename T, template <typename> class Alloc>
+void RBTree<T, Alloc>::leftRotate(RBTreeNode<T>* x) { // throw X to the left - replace with its right child
     RBTreeNode<T>* y = x->right;
     x->right = y->left; // y's left subtree --> x's right subtree
     if(y->left != sentinel) { // if it wasn't empty
-        y->left->parent = x; // then ensure that its parent is X
+        y->left->setParent(x); // then ensure that its parent is X
     }
-    y->parent = x->parent;
-    if(x->parent == sentinel) {
+    y->setParent(x->parent());
+    if(x->parent() == sentinel) {
         root = y; // will already have a parent - the sentinel!
-    } else if(x == x->parent->left) {
-        x->parent->left = y;
+    } else if(x == x->parent()->left) {
+        x->parent()->left = y;
     } else {
-        x->parent->right = y;
+        x->parent()->right = y;
     }
     y->left = x;
-    x->parent = y;
+    x->setParent(y);
+    augment(x); // x is now y's child
+    augment(y);
 }
 
-template <typename T>
-void RBTree<T>::rightRotate(RBTreeNode<T>* x) { // throw X to the right - replace with its left child
+template <typename T, template <typename> class Alloc>
+void RBTree<T, Alloc>::rightRotate(RBTreeNode<T>* x) { // throw X to the right - replace with its left child
     RBTreeNode<T>* y = x->left;
     x->left = y->right; // y's left subtree --> x's right subtree
     if(y->right != sentinel) { // if it wasn't empty
-        y->right->parent = x; // then ensure that its parent is X
+        y->right->setParent(x); // then ensure that its parent is X
     }
-    y->parent = x->parent;
-    if(x->parent == sentinel) {
+    y->setParent(x->parent());
+    if(x->parent() == sentinel) {
         root = y;
-    } else if(x == x->parent->left) {
-        x->parent->left = y;
+    } else if(x == x->parent()->left) {
+        x->parent()->left = y;
     } else {
-        x->parent->right = y;
+        x->parent()->right = y;
     }
     y->right = x;
-    x->parent = y;
+    x->setParent(y);
+    augment(x);
+    augment(y);
 }
 
-template <typename T>
-void RBTree<T>::insert(T val) {
-    this->size++;
-    // Create new node z
-    RBTreeNode<T>* z = new RBTreeNode<T>(val, RED);
-    // Insertion process below
-    RBTreeNode<T>* x = root; // node compared with z
-    RBTreeNode<T>* y = sentinel; // y is parent of z
+template <typename T, template <typename> class Alloc>
+RBTreeNode<T>* RBTree<T, Alloc>::insert(T val) {
+    RBTreeNode<T>* x = root; // node compared with val
+    RBTreeNode<T>* y = sentinel; // y becomes the parent of the new node
     while(x != sentinel) { // descend until reaching sentinel
         y = x;
-        if(z->key < x->key) {
+        if(val < x->key) {
             x = x->left;
         } else {
             x = x->right;
         }
     }
-    z->parent = y; // found the location - insert z with parent y - decide if root, left or right
+    return attach(y, y != sentinel && val < y->key, val);
+}
+
+template <typename T, template <typename> class Alloc>
+RBTreeNode<T>* RBTree<T, Alloc>::attach(RBTreeNode<T>* y, bool asLeft, T val) {
+    this->size++;
+    RBTreeNode<T>* z = alloc.create(val, RED);
+    z->setParent(y); // found the location - insert z with parent y - decide if root, left or right
     if(y==sentinel) {
         root = z; // tree was empty
-    } else if(z->key < y->key) {
+        minNode = z;
+        maxNode = z;
+    } else if(asLeft) {
         y->left = z;
+        if(y == minNode) {
+            minNode = z; // only the leftmost node's left child can be smaller
+        }
     } else {
         y->right = z;
+        if(y == maxNode) {
+            maxNode = z;
+        }
     }
     z->left = sentinel; // "insertion happens at leaf" - UW professor
     z->right = sentinel;
+    augmentUpward(y);
     this->insertFixup(z);
+    return z;
 }
 
-template <typename T>
-void RBTree<T>::insertFixup(RBTreeNode<T>* z) {
-    while(z->parent->color == RED) { // violates RB Tree property (z is RED & parent RED, z should be BLACK)
-        if(z->parent == z->parent->parent->left) { // z's parent is a LEFT child
-            RBTreeNode<T>* y = z->parent->parent->right; // z's right uncle 
-            if(y->color == RED) { // parent & uncle are both red - CASE 1
-                z->parent->color = BLACK; // both of the grandparent's children are blackened
-                y->color = BLACK;
-                z->parent->parent->color = RED; // redden z's grandparent
-                z = z->parent->parent; // transfer the z pointer to the grandparent
+template <typename T, template <typename> class Alloc>
+RBTreeNode<T>* RBTree<T, Alloc>::append_max(T val) {
+    if(maxNode != sentinel && val < maxNode->key) {
+        return insert(val); // not an append
+    }
+    return attach(maxNode, false, val); // the maximum has no right child
+}
+
+// Links val between hint's predecessor and hint when it fits there, found by walking
+// up from hint only as far as the predecessor - otherwise falls back to insert()
+template <typename T, template <typename> class Alloc>
+RBTreeNode<T>* RBTree<T, Alloc>::insert_hint(RBTreeNode<T>* hint, T val) {
+    if(hint == nullptr || hint == sentinel) {
+        return append_max(val);
+    }
+    if(hint->key < val) {
+        return insert(val);
+    }
+    if(hint->left == sentinel) { // the predecessor is an ancestor - or there is none
+        if(hint != minNode && val < predecessor(hint)->key) {
+            return insert(val);
+        }
+        return attach(hint, true, val);
+    }
+    RBTreeNode<T>* prev = hint->left; // the rightmost node of the left subtree, whose right link is free
+    while(prev->right != sentinel) {
+        prev = prev->right;
+    }
+    if(val < prev->key) {
+        return insert(val);
+    }
+    return attach(prev, false, val);
+}
+
+template <typename T, template <typename> class Alloc>
+void RBTree<T, Alloc>::insertFixup(RBTreeNode<T>* z) {
+    while(z->parent()->color() == RED) { // violates RB Tree property (z is RED & parent RED, z should be BLACK)
+        if(z->parent() == z->parent()->parent()->left) { // z's parent is a LEFT child
+            RBTreeNode<T>* y = z->parent()->parent()->right; // z's right uncle 
+            if(y->color() == RED) { // parent & uncle are both red - CASE 1
+                z->parent()->setColor(BLACK); // both of the grandparent's children are blackened
+                y->setColor(BLACK);
+                z->parent()->parent()->setColor(RED); // redden z's grandparent
+                z = z->parent()->parent(); // transfer the z pointer to the grandparent
             } else {
-                if(z == z->parent->right) { // case 2 - z is a RIGHT Child + uncle is BLACK
+                if(z == z->parent()->right) { // case 2 - z is a RIGHT Child + uncle is BLACK
                     // unbalanced tree
-                    z = z->parent;
+                    z = z->parent();
                     leftRotate(z); // then rotate over - transforms to the next case
                 }
-                z->parent->color = BLACK; // case 3 - uncle is black, z is LEFT child
-                z->parent->parent->color = RED; // fixes black height property 
-                rightRotate(z->parent->parent); // rebalances so black is root of subtree
+                z->parent()->setColor(BLACK); // case 3 - uncle is black, z is LEFT child
+                z->parent()->parent()->setColor(RED); // fixes black height property 
+                rightRotate(z->parent()->parent()); // rebalances so black is root of subtree
             }
         } else { // then z's parent is a RIGHT child - SYMMETRIC to above part
-            RBTreeNode<T>* y = z->parent->parent->left;
-            if(y->color == RED) {
-                z->parent->color = BLACK;
-                y->color = BLACK;
-                z->parent->parent->color = RED; 
-                z = z->parent->parent; 
+            RBTreeNode<T>* y = z->parent()->parent()->left;
+            if(y->color() == RED) {
+                z->parent()->setColor(BLACK);
+                y->setColor(BLACK);
+                z->parent()->parent()->setColor(RED); 
+                z = z->parent()->parent(); 
             } else {
-                if(z == z->parent->left) { 
-                    z = z->parent;
+                if(z == z->parent()->left) { 
+                    z = z->parent();
                     rightRotate(z); 
                 }
-                z->parent->color = BLACK;
-                z->parent->parent->color = RED;
-                leftRotate(z->parent->parent);
+                z->parent()->setColor(BLACK);
+                z->parent()->parent()->setColor(RED);
+                leftRotate(z->parent()->parent());
             }
         }
     } // repeats only with case 1...where the property of red children is violated temporarily
-    root->color = BLACK;
+    root->setColor(BLACK);
 }
 
-template <typename T>
-void RBTree<T>::transplant(RBTreeNode<T>* u, RBTreeNode<T>* v) {
-    if(u->parent == sentinel) {
+template <typename T, template <typename> class Alloc>
+void RBTree<T, Alloc>::transplant(RBTreeNode<T>* u, RBTreeNode<T>* v) {
+    if(u->parent() == sentinel) {
         root = v;
-    } else if(u == u->parent->left) {
-        u->parent->left = v;
+    } else if(u == u->parent()->left) {
+        u->parent()->left = v;
     } else {
-        u->parent->right = v;
+        u->parent()->right = v;
     }
-    v->parent = u->parent;
+    v->setParent(u->parent());
 }
 
-template <typename T>
-void RBTree<T>::remove(T val) {
+template <typename T, template <typename> class Alloc>
+void RBTree<T, Alloc>::remove(T val) {
     RBTreeNode<T>* z = search(val);
+    if(!z) {
+        return; // nothing to remove
+    }
+    this->size--;
+    if(z == minNode) {
+        minNode = const_cast<RBTreeNode<T>*>(successor(z)); // nodes keep their identity below, so neighbours stay valid
+    }
+    if(z == maxNode) {
+        maxNode = const_cast<RBTreeNode<T>*>(predecessor(z));
+    }
     RBTreeNode<T>* y = z;
     RBTreeNode<T>* x = nullptr;
-    Color y_Orig = y->color;
+    Color y_Orig = y->color();
     if(z->left == sentinel) {
         x = z->right;
         transplant(z, z->right);
@@ -215,82 +427,107 @@ void RBTree<T>::remove(T val) {
     }
     else {
         y = treeMin(z->right);
-        y_Orig = y->color;
+        y_Orig = y->color();
         x = y->right;
         if(y != z->right) {
             transplant(y, y->right);
             y->right = z->right;
-            y->right->parent = y;
+            y->right->setParent(y);
         } else {
-            x->parent = y;
+            x->setParent(y);
         }
         transplant(z, y);
         y->left = z->left;
-        y->left->parent = y;
-        y->color = z->color;
+        y->left->setParent(y);
+        y->setColor(z->color());
     }
+    augmentUpward(x->parent()); // transplant moves whole subtrees - only the nodes above x lost an endpoint
     if(y_Orig == BLACK) {
         removeFixup(x);
     }
+    alloc.destroy(z);
 }
 
-template <typename T>
-void RBTree<T>::removeFixup(RBTreeNode<T>* x) {
-    while(x != root && x->color == BLACK) {
-        if(x == x->parent->left) {
-            RBTreeNode<T>* w = x->parent->right;
-            if(w->color == RED) {
-                w->color = BLACK;
-                x->parent->color = RED;
-                leftRotate(x->parent);
-                w = x->parent->right;
+template <typename T, template <typename> class Alloc>
+void RBTree<T, Alloc>::removeFixup(RBTreeNode<T>* x) {
+    while(x != root && x->color() == BLACK) {
+        if(x == x->parent()->left) {
+            RBTreeNode<T>* w = x->parent()->right;
+            if(w->color() == RED) {
+                w->setColor(BLACK);
+                x->parent()->setColor(RED);
+                leftRotate(x->parent());
+                w = x->parent()->right;
             }
-            if(w->left->color == BLACK && w->right->color == BLACK) {
-                w->color = RED;
-                x = x->parent;
+            if(w->left->color() == BLACK && w->right->color() == BLACK) {
+                w->setColor(RED);
+                x = x->parent();
             } else {
-                if(w->right->color == BLACK) {
-                    w->left->color = BLACK;
-                    w->color = RED;
+                if(w->right->color() == BLACK) {
+                    w->left->setColor(BLACK);
+                    w->setColor(RED);
                     rightRotate(w);
-                    w = x->parent->right;
+                    w = x->parent()->right;
                 }
-                w->color = x->parent->color;
-                x->parent->color = BLACK;
-                w->right->color = BLACK;
-                leftRotate(x->parent);
+                w->setColor(x->parent()->color());
+                x->parent()->setColor(BLACK);
+                w->right->setColor(BLACK);
+                leftRotate(x->parent());
                 x = root;
             }
         } else {
-            RBTreeNode<T>* w = x->parent->left;
-            if(w->color == RED) {
-                w->color = BLACK;
-                x->parent->color = RED;
-                leftRotate(x->parent);
-                w = x->parent->left;
+            RBTreeNode<T>* w = x->parent()->left;
+            if(w->color() == RED) {
+                w->setColor(BLACK);
+                x->parent()->setColor(RED);
+                rightRotate(x->parent());
+                w = x->parent()->left;
             }
-            if(w->right->color == BLACK && w->left->color == BLACK) {
-                w->color = RED;
-                x = x->parent;
+            if(w->right->color() == BLACK && w->left->color() == BLACK) {
+                w->setColor(RED);
+                x = x->parent();
             } else {
-                if(w->left->color == BLACK) {
-                    w->right->color = BLACK;
-                    w->color = RED;
+                if(w->left->color() == BLACK) {
+                    w->right->setColor(BLACK);
+                    w->setColor(RED);
                     leftRotate(w);
-                    w = x->parent->left;
+                    w = x->parent()->left;
                 }
-                w->color = x->parent->color;
-                x->parent->color = BLACK;
-                w->left->color = BLACK;
-                rightRotate(x->parent);
+                w->setColor(x->parent()->color());
+                x->parent()->setColor(BLACK);
+                w->left->setColor(BLACK);
+                rightRotate(x->parent());
                 x = root;
             }
         }
     }
+    x->setColor(BLACK);
 }
 
-template <typename T>
-RBTreeNode<T>* RBTree<T>::search(T val) const {
+template <typename T, template <typename> class Alloc>
+void RBTree<T, Alloc>::augment(RBTreeNode<T>* x) {
+    if constexpr (RBAugment<T>::enabled) {
+        x->maxHigh = x->key.high;
+        if(x->left != sentinel && x->maxHigh < x->left->maxHigh) {
+            x->maxHigh = x->left->maxHigh;
+        }
+        if(x->right != sentinel && x->maxHigh < x->right->maxHigh) {
+            x->maxHigh = x->right->maxHigh;
+        }
+    }
+}
+
+template <typename T, template <typename> class Alloc>
+void RBTree<T, Alloc>::augmentUpward(RBTreeNode<T>* x) {
+    if constexpr (RBAugment<T>::enabled) {
+        for(; x != sentinel; x = x->parent()) {
+            augment(x);
+        }
+    }
+}
+
+template <typename T, template <typename> class Alloc>
+RBTreeNode<T>* RBTree<T, Alloc>::search(T val) const {
     RBTreeNode<T>* x = root; // node compared with z
     while(x != sentinel) { // descend until reaching sentinel
         if(val == x->key) {
@@ -305,8 +542,8 @@ RBTreeNode<T>* RBTree<T>::search(T val) const {
     return nullptr;
 }
 
-template <typename T>
-void RBTree<T>::print() {
+template <typename T, template <typename> class Alloc>
+void RBTree<T, Alloc>::print() {
     int height = ceil(log(size + 1.0)/log(2.0));  // Calculate tree height
     std::queue<std::pair<RBTreeNode<T>*, int>> treeQ;
     treeQ.push({root, 0});
@@ -331,10 +568,124 @@ void RBTree<T>::print() {
             continue; 
         }
         std::cout << curr.first->key;
-        std::cout << (curr.first->color == RED ? "*" : "^");
+        std::cout << (curr.first->color() == RED ? "*" : "^");
         printSpaces(2*numSpaces + 2);
         treeQ.push({curr.first->left, curr.second + 1});
         treeQ.push({curr.first->right, curr.second + 1});
     }
     std::cout << "\n";
 }
+
+template <typename T, template <typename> class Alloc>
+const RBTreeNode<T>* RBTree<T, Alloc>::successor(const RBTreeNode<T>* x) const {
+    if(x->right != sentinel) {
+        x = x->right;
+        while(x->left != sentinel) {
+            x = x->left;
+        }
+        return x;
+    }
+    const RBTreeNode<T>* y = x->parent(); // climb until x is in a left subtree
+    while(y != sentinel && x == y->right) {
+        x = y;
+        y = y->parent();
+    }
+    return y;
+}
+
+template <typename T, template <typename> class Alloc>
+const RBTreeNode<T>* RBTree<T, Alloc>::predecessor(const RBTreeNode<T>* x) const {
+    if(x == sentinel) { // stepping back from end()
+        return maxNode;
+    }
+    if(x->left != sentinel) {
+        x = x->left;
+        while(x->right != sentinel) {
+            x = x->right;
+        }
+        return x;
+    }
+    const RBTreeNode<T>* y = x->parent();
+    while(y != sentinel && x == y->left) {
+        x = y;
+        y = y->parent();
+    }
+    return y;
+}
+
+template <typename T, template <typename> class Alloc>
+typename RBTree<T, Alloc>::const_iterator RBTree<T, Alloc>::begin() const {
+    return const_iterator(minNode, this);
+}
+
+template <typename T, template <typename> class Alloc>
+typename RBTree<T, Alloc>::const_iterator RBTree<T, Alloc>::end() const {
+    return const_iterator(sentinel, this);
+}
+
+template <typename T, template <typename> class Alloc>
+template <typename K>
+typename RBTree<T, Alloc>::const_iterator RBTree<T, Alloc>::lower_bound(const K& val) const {
+    const RBTreeNode<T>* bound = sentinel;
+    const RBTreeNode<T>* x = root;
+    while(x != sentinel) {
+        if(x->key < val) {
+            x = x->right;
+        } else {
+            bound = x; // candidate - look for an earlier one on the left
+            x = x->left;
+        }
+    }
+    return const_iterator(bound, this);
+}
+
+template <typename T, template <typename> class Alloc>
+template <typename K>
+typename RBTree<T, Alloc>::const_iterator RBTree<T, Alloc>::upper_bound(const K& val) const {
+    const RBTreeNode<T>* bound = sentinel;
+    const RBTreeNode<T>* x = root;
+    while(x != sentinel) {
+        if(val < x->key) {
+            bound = x;
+            x = x->left;
+        } else {
+            x = x->right;
+        }
+    }
+    return const_iterator(bound, this);
+}
+
+template <typename T, template <typename> class Alloc>
+template <typename K>
+std::pair<typename RBTree<T, Alloc>::const_iterator, typename RBTree<T, Alloc>::const_iterator>
+RBTree<T, Alloc>::equal_range(const K& val) const {
+    return {lower_bound(val), upper_bound(val)};
+}
+
+template <typename T, template <typename> class Alloc>
+template <typename Q, typename Visitor>
+void RBTree<T, Alloc>::overlaps(const Q& q, Visitor visit) const {
+    static_assert(RBAugment<T>::enabled, "overlaps() needs Interval keys");
+    if constexpr (std::is_same_v<Q, T>) {
+        overlapsFrom(root, q.low, q.high, visit);
+    } else {
+        overlapsFrom(root, q, q, visit); // a point is the interval [q, q]
+    }
+}
+
+// In-order walk that skips a subtree when its max endpoint is below low, and stops
+// going right once a start passes high - the right side only starts later
+template <typename T, template <typename> class Alloc>
+template <typename E, typename Visitor>
+void RBTree<T, Alloc>::overlapsFrom(const RBTreeNode<T>* x, const E& low, const E& high, Visitor& visit) const {
+    while(x != sentinel && !(x->maxHigh < low)) {
+        overlapsFrom(x->left, low, high, visit);
+        if(high < x->key.low) {
+            return;
+        }
+        if(!(x->key.high < low)) {
+            visit(x->key);
+        }
+        x = x->right; // the right subtree is a tail call
+    }
+}
@@ -0,0 +1,273 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+#include <cstddef>
+#include <cstdint>
+#include "AVLTree.h"
+
+/*
+Sharded ordered set (range-partitioned locks)
+The key space is cut into N ranges by N - 1 boundary keys, and each range
+lives in its own AVLTree behind its own reader-writer lock, so threads
+working on different ranges never touch the same lock or the same nodes.
+Shard i holds the keys in [bounds[i-1], bounds[i]).
+
+Boundaries move online. Every shard counts the operations routed to it,
+and every rebalanceEvery operations on a shard, the thread that crossed
+the mark (if no other thread is already rebalancing) compares neighbouring
+shards: when one did noticeably more work than the other, it hands the
+other the share of its keys at their shared end that evens the two out,
+assuming work is spread evenly over its keys. Repeated passes spread the
+load across all shards. The hand-over is AVLTree::split + join, O(log n), and uses
+select() to find the new boundary, so a hot range narrows quickly while
+the pause stays short.
+
+The boundaries themselves are read under a "big reader" lock: one
+reader-writer lock per slot, each on its own cache line; an operation takes
+its thread's slot shared, and a rebalance takes every slot exclusively. The
+common path therefore touches only its own slot and its shard.
+
+scan(a, b, visit) locks every shard overlapping [a, b] in key order and walks
+their cursors one after another - the shards partition the keys, so merging
+the cursors is concatenation - giving an atomic view of the range.
+*/
+
+template <typename T>
+class ShardedSet {
+    using Tree = AVLTree<T, HeapAllocator>; // keys migrate between shards - per-node frees return their memory, where shared slabs would be pinned by every shard
+    static constexpr size_t layoutSlots = 64;
+    static constexpr double skewed = 1.25; // neighbours whose loads differ by more are evened out
+
+    struct alignas(64) Shard {
+        mutable std::shared_mutex m;
+        Tree tree;
+        std::atomic<uint64_t> ops{0}; // since the last rebalance
+    };
+    struct alignas(64) LayoutSlot {
+        std::shared_mutex m;
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::vector<T> bounds; // shards.size() - 1 increasing keys
+    mutable LayoutSlot layout[layoutSlots];
+    std::mutex rebalancing;
+    uint64_t rebalanceEvery;
+
+    static size_t slot();
+    size_t route(const T& key) const { return std::upper_bound(bounds.begin(), bounds.end(), key) - bounds.begin(); }
+    void countOp(Shard& s);
+    void lockLayout();
+    void unlockLayout();
+    void moveBoundary(size_t i, size_t keys, bool rightward);
+    void rebalanceLocked();
+public:
+    // boundaries - the first key of every shard but the first, in increasing order
+    explicit ShardedSet(std::vector<T> boundaries, uint64_t rebalanceEvery = 1 << 16);
+    ShardedSet(const ShardedSet& set) = delete;
+    ShardedSet& operator=(const ShardedSet& rhs) = delete;
+
+    bool insert(const T& key); // false if the key is already present
+    bool erase(const T& key); // false if the key is absent
+    bool contains(const T& key) const;
+
+    template <typename Visitor>
+    void scan(const T& a, const T& b, Visitor visit) const; // keys in [a, b], in order
+
+    void rebalance(); // one pass over the neighbouring pairs - also triggered automatically
+    size_t size() const; // not atomic across shards
+    size_t shardCount() const { return shards.size(); }
+    std::vector<size_t> shardSizes() const;
+};
+
+template <typename T>
+ShardedSet<T>::ShardedSet(std::vector<T> boundaries, uint64_t rebalanceEvery)
+    : bounds(std::move(boundaries)), rebalanceEvery(std::max<uint64_t>(rebalanceEvery, 1)) {
+    for(size_t i=1; i<bounds.size(); i++) {
+        if(!(bounds[i - 1] < bounds[i])) {
+            throw std::invalid_argument("EXCEPTION: shard boundaries must be strictly increasing!");
+        }
+    }
+    for(size_t i=0; i<=bounds.size(); i++) {
+        shards.push_back(std::make_unique<Shard>());
+    }
+}
+
+template <typename T>
+size_t ShardedSet<T>::slot() {
+    static thread_local size_t mine = std::hash<std::thread::id>()(std::this_thread::get_id()) % layoutSlots;
+    return mine;
+}
+
+template <typename T>
+void ShardedSet<T>::lockLayout() {
+    for(LayoutSlot& s : layout) { // always in the same order - rebalances are serialized anyway
+        s.m.lock();
+    }
+}
+
+template <typename T>
+void ShardedSet<T>::unlockLayout() {
+    for(LayoutSlot& s : layout) {
+        s.m.unlock();
+    }
+}
+
+// Called with no locks held
+template <typename T>
+void ShardedSet<T>::countOp(Shard& s) {
+    if(s.ops.fetch_add(1, std::memory_order_relaxed) % rebalanceEvery == rebalanceEvery - 1) {
+        std::unique_lock<std::mutex> r(rebalancing, std::try_to_lock);
+        if(r) { // otherwise another thread is already at it
+            rebalanceLocked();
+        }
+    }
+}
+
+template <typename T>
+bool ShardedSet<T>::insert(const T& key) {
+    Shard* s;
+    bool inserted;
+    {
+        std::shared_lock<std::shared_mutex> l(layout[slot()].m);
+        s = shards[route(key)].get();
+        std::unique_lock<std::shared_mutex> lock(s->m);
+        inserted = s->tree.push(key);
+    }
+    countOp(*s);
+    return inserted;
+}
+
+template <typename T>
+bool ShardedSet<T>::erase(const T& key) {
+    Shard* s;
+    bool erased;
+    {
+        std::shared_lock<std::shared_mutex> l(layout[slot()].m);
+        s = shards[route(key)].get();
+        std::unique_lock<std::shared_mutex> lock(s->m);
+        erased = s->tree.erase(key);
+    }
+    countOp(*s);
+    return erased;
+}
+
+template <typename T>
+bool ShardedSet<T>::contains(const T& key) const {
+    Shard* s;
+    bool found;
+    {
+        std::shared_lock<std::shared_mutex> l(layout[slot()].m);
+        s = shards[route(key)].get();
+        std::shared_lock<std::shared_mutex> lock(s->m);
+        found = s->tree.contains(key);
+    }
+    const_cast<ShardedSet*>(this)->countOp(*s); // only the load counters and boundaries change
+    return found;
+}
+
+template <typename T>
+template <typename Visitor>
+void ShardedSet<T>::scan(const T& a, const T& b, Visitor visit) const {
+    if(b < a) {
+        return;
+    }
+    std::shared_lock<std::shared_mutex> l(layout[slot()].m);
+    size_t first = route(a), last = route(b);
+    std::vector<std::shared_lock<std::shared_mutex>> locks; // ascending order, and writers hold one shard at most - no deadlock
+    locks.reserve(last - first + 1);
+    for(size_t i=first; i<=last; i++) {
+        locks.emplace_back(shards[i]->m);
+    }
+    for(size_t i=first; i<=last; i++) {
+        const Tree& tree = shards[i]->tree;
+        for(auto it = i == first ? tree.lower_bound(a) : tree.begin(); it != tree.end() && !(b < *it); ++it) {
+            visit(*it);
+        }
+    }
+}
+
+// Moves keys across bounds[i]: the top keys of shard i to shard i+1 when rightward, else the bottom keys of shard i+1 to shard i
+template <typename T>
+void ShardedSet<T>::moveBoundary(size_t i, size_t keys, bool rightward) {
+    Tree& left = shards[i]->tree;
+    Tree& right = shards[i + 1]->tree;
+    if(rightward) {
+        T bound = *left.select(static_cast<size_t>(left.size()) - keys);
+        Tree top = left.split(bound);
+        top.join(std::move(right));
+        right = std::move(top);
+        bounds[i] = std::move(bound);
+    } else {
+        T bound = *right.select(keys);
+        Tree rest = right.split(bound);
+        left.join(std::move(right));
+        right = std::move(rest);
+        bounds[i] = std::move(bound);
+    }
+}
+
+template <typename T>
+void ShardedSet<T>::rebalance() {
+    std::lock_guard<std::mutex> r(rebalancing);
+    rebalanceLocked();
+}
+
+template <typename T>
+void ShardedSet<T>::rebalanceLocked() {
+    lockLayout(); // no operation is in flight from here on
+    std::vector<double> load(shards.size());
+    for(size_t i=0; i<shards.size(); i++) {
+        load[i] = static_cast<double>(shards[i]->ops.exchange(0, std::memory_order_relaxed));
+    }
+    for(size_t i=0; i+1<shards.size(); i++) {
+        size_t sizeL = static_cast<size_t>(shards[i]->tree.size());
+        size_t sizeR = static_cast<size_t>(shards[i + 1]->tree.size());
+        bool rightward = load[i] > skewed * load[i + 1];
+        if(!rightward && !(load[i + 1] > skewed * load[i])) {
+            continue; // close enough
+        }
+        double hot = rightward ? load[i] : load[i + 1];
+        double cold = rightward ? load[i + 1] : load[i];
+        size_t hotSize = rightward ? sizeL : sizeR;
+        // hand over the share of keys that evens the load, if load is spread evenly over them
+        size_t keys = static_cast<size_t>(hotSize * (hot - cold) / (2 * hot));
+        keys = std::min(keys, hotSize - 1); // a shard keeps at least one key, so its boundary stays a key
+        if(hotSize < 2 || keys == 0) {
+            continue;
+        }
+        moveBoundary(i, keys, rightward);
+        double moved = hot * keys / hotSize;
+        load[rightward ? i : i + 1] -= moved;
+        load[rightward ? i + 1 : i] += moved;
+    }
+    unlockLayout();
+}
+
+template <typename T>
+size_t ShardedSet<T>::size() const {
+    std::shared_lock<std::shared_mutex> l(layout[slot()].m);
+    size_t total = 0;
+    for(const auto& s : shards) {
+        std::shared_lock<std::shared_mutex> lock(s->m);
+        total += static_cast<size_t>(s->tree.size());
+    }
+    return total;
+}
+
+template <typename T>
+std::vector<size_t> ShardedSet<T>::shardSizes() const {
+    std::shared_lock<std::shared_mutex> l(layout[slot()].m);
+    std::vector<size_t> sizes;
+    for(const auto& s : shards) {
+        std::shared_lock<std::shared_mutex> lock(s->m);
+        sizes.push_back(static_cast<size_t>(s->tree.size()));
+    }
+    return sizes;
+}
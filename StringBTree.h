@@ -0,0 +1,443 @@
+#pragma once
+#include <iostream>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <cstddef>
+#include <cstdint>
+
+/*
+Prefix-compressed string B+ Tree
+Keys live in the leaves as in BPlusTree, but a page does not hold T objects:
+it stores the longest prefix shared by all of its keys once, and the rest of
+every key (its suffix) back to back in one slab, found through an offsets
+array. Separators copied up from a leaf split are truncated to the shortest
+string that still routes correctly (a < separator <= b for the last key a
+left of it and the first key b right of it), so interior pages stay small
+and fan out wide.
+
+Page capacity is counted in encoded bytes, not keys: a page splits once its
+prefix + slab + offsets + child pointers exceed PageBytes, and is merged
+with or topped up from a sibling when it drops under a quarter of that.
+Hierarchical keys (paths, URLs) share long prefixes, so a page holds many
+more of them than PageBytes / sizeof(std::string).
+
+Separator invariant: subtree(children[i]) < keys[i] <= subtree(children[i+1])
+*/
+
+template <size_t PageBytes = 4096>
+class StringBTree {
+    static_assert(PageBytes >= 256, "pages must hold a handful of keys");
+    static constexpr size_t maxKeyLength = PageBytes / 4; // a split always leaves keys on both sides
+    static constexpr size_t minPageBytes = PageBytes / 4;
+
+    struct Node {
+        bool leaf = true;
+        std::string prefix; // shared by every key in the page
+        std::string slab; // key suffixes after the prefix, back to back
+        std::vector<uint32_t> offsets{0}; // suffix i is slab[offsets[i], offsets[i+1])
+        std::vector<Node*> children; // interior pages only, size()+1 of them
+        Node* next = nullptr; // next leaf
+
+        size_t size() const { return offsets.size() - 1; }
+        std::string_view suffix(size_t i) const {
+            return std::string_view(slab).substr(offsets[i], offsets[i + 1] - offsets[i]);
+        }
+        std::string key(size_t i) const {
+            std::string k = prefix;
+            k += suffix(i);
+            return k;
+        }
+        // encoded page size - what PageBytes bounds
+        size_t bytes() const {
+            return prefix.size() + slab.size() + offsets.size() * sizeof(uint32_t) + children.size() * sizeof(Node*);
+        }
+    };
+
+    Node* root;
+    size_t size_;
+public:
+    StringBTree() : root(new Node()), size_(0) {}
+    ~StringBTree() { destroy(root); }
+    StringBTree(const StringBTree& tree) = delete;
+    StringBTree(StringBTree&& tree) noexcept : root(std::exchange(tree.root, new Node())), size_(std::exchange(tree.size_, 0)) {}
+    StringBTree& operator=(const StringBTree& rhs) = delete;
+    StringBTree& operator=(StringBTree&& rhs) noexcept {
+        if(this != &rhs) {
+            std::swap(root, rhs.root);
+            std::swap(size_, rhs.size_);
+        }
+        return *this;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    bool contains(std::string_view k) const {
+        const Node* x = root;
+        while(!x->leaf) {
+            x = x->children[search<true>(x, k)];
+        }
+        size_t i = search<false>(x, k);
+        return i < x->size() && equals(x, i, k);
+    }
+
+    bool insert(std::string_view k) {
+        if(k.size() > maxKeyLength) {
+            throw std::length_error("EXCEPTION: key too long for a StringBTree page!");
+        }
+        bool added = insert(root, k);
+        if(root->bytes() > PageBytes) {
+            growRoot();
+        }
+        return added;
+    }
+
+    bool remove(std::string_view k) {
+        bool removed = remove(root, k);
+        if(root->bytes() > PageBytes) { // a replaced separator can be longer
+            growRoot();
+        }
+        while(!root->leaf && root->size() == 0) {
+            Node* oldRoot = root;
+            root = root->children[0];
+            oldRoot->children.clear();
+            delete oldRoot;
+        }
+        return removed;
+    }
+
+    // Streams every key in [lo, hi) to f as a std::string_view (valid during the call)
+    template <typename F>
+    void scan(std::string_view lo, std::string_view hi, F&& f) const {
+        const Node* x = root;
+        while(!x->leaf) {
+            x = x->children[search<true>(x, lo)];
+        }
+        std::string buf;
+        for(size_t i = search<false>(x, lo); x; x = x->next, i = 0) {
+            for(; i < x->size(); i++) {
+                buf.assign(x->prefix);
+                buf += x->suffix(i);
+                if(!(std::string_view(buf) < hi)) {
+                    return;
+                }
+                f(std::string_view(buf));
+            }
+        }
+    }
+
+    size_t height() const {
+        size_t h = 1;
+        for(const Node* x = root; !x->leaf; x = x->children[0]) {
+            h++;
+        }
+        return h;
+    }
+
+    // Heap bytes held by the tree: page headers plus their buffers' capacity
+    size_t memoryUsage() const {
+        size_t total = 0;
+        std::vector<const Node*> stack{root};
+        while(!stack.empty()) {
+            const Node* x = stack.back();
+            stack.pop_back();
+            total += sizeof(Node) + heapBytes(x->prefix) + heapBytes(x->slab);
+            total += x->offsets.capacity() * sizeof(uint32_t) + x->children.capacity() * sizeof(Node*);
+            stack.insert(stack.end(), x->children.begin(), x->children.end());
+        }
+        return total;
+    }
+
+    // BFS, one page per tab - a page's prefix is shown in brackets before its suffixes
+    void printStringBTree() const {
+        std::queue<std::pair<const Node*, int>> q;
+        int lvl = 0;
+        q.push({root, 0});
+        while(!q.empty()) {
+            std::pair<const Node*, int> curr = q.front();
+            q.pop();
+            if(curr.second > lvl) {
+                std::cout << "\n";
+                lvl = curr.second;
+            }
+            if(!curr.first->prefix.empty()) {
+                std::cout << "[" << curr.first->prefix << "] ";
+            }
+            for(size_t i=0; i<curr.first->size(); i++) {
+                std::cout << curr.first->suffix(i) << " ";
+            }
+            std::cout << "\t";
+            for(const Node* child : curr.first->children) {
+                q.push({child, curr.second + 1});
+            }
+        }
+        std::cout << "\n";
+    }
+private:
+    static size_t heapBytes(const std::string& s) {
+        return s.capacity() > std::string().capacity() ? s.capacity() + 1 : 0; // small strings live inside the page header
+    }
+
+    static size_t commonPrefix(std::string_view a, std::string_view b) {
+        size_t n = std::min(a.size(), b.size());
+        size_t i = 0;
+        while(i < n && a[i] == b[i]) i++;
+        return i;
+    }
+
+    // # keys of x below k (Upper: not above k). A key that leaves the page's
+    // prefix sorts before or after every key in the page, so only keys that
+    // share it are binary searched, on their suffixes alone.
+    template <bool Upper>
+    static size_t search(const Node* x, std::string_view k) {
+        std::string_view p = x->prefix;
+        size_t common = commonPrefix(p, k);
+        if(common < p.size()) {
+            // compared as unsigned char, like std::string
+            bool below = common == k.size() || static_cast<unsigned char>(k[common]) < static_cast<unsigned char>(p[common]);
+            return below ? 0 : x->size();
+        }
+        std::string_view rest = k.substr(p.size());
+        size_t lo = 0, hi = x->size();
+        while(lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            int cmp = x->suffix(mid).compare(rest);
+            if(Upper ? cmp <= 0 : cmp < 0) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    static bool equals(const Node* x, size_t i, std::string_view k) {
+        std::string_view p = x->prefix;
+        return k.size() >= p.size() && k.substr(0, p.size()) == p && k.substr(p.size()) == x->suffix(i);
+    }
+
+    // Shortens the page prefix to its first len chars, moving the rest into every suffix
+    static void shrinkPrefix(Node* x, size_t len) {
+        std::string_view moved = std::string_view(x->prefix).substr(len);
+        std::string slab;
+        std::vector<uint32_t> offsets{0};
+        slab.reserve(x->slab.size() + x->size() * moved.size());
+        offsets.reserve(x->offsets.size());
+        for(size_t i=0; i<x->size(); i++) {
+            slab += moved;
+            slab += x->suffix(i);
+            offsets.push_back(static_cast<uint32_t>(slab.size()));
+        }
+        x->slab = std::move(slab);
+        x->offsets = std::move(offsets);
+        x->prefix.resize(len);
+    }
+
+    // Makes k the i-th key of x
+    static void insertKey(Node* x, size_t i, std::string_view k) {
+        size_t common = commonPrefix(x->prefix, k);
+        if(common < x->prefix.size()) {
+            shrinkPrefix(x, common);
+        }
+        std::string_view rest = k.substr(x->prefix.size());
+        uint32_t at = x->offsets[i];
+        x->slab.insert(at, rest);
+        x->offsets.insert(x->offsets.begin() + i + 1, at + static_cast<uint32_t>(rest.size()));
+        for(size_t j = i + 2; j < x->offsets.size(); j++) {
+            x->offsets[j] += static_cast<uint32_t>(rest.size());
+        }
+    }
+
+    static void eraseKey(Node* x, size_t i) {
+        uint32_t len = x->offsets[i + 1] - x->offsets[i];
+        x->slab.erase(x->offsets[i], len);
+        x->offsets.erase(x->offsets.begin() + i + 1);
+        for(size_t j = i + 1; j < x->offsets.size(); j++) {
+            x->offsets[j] -= len;
+        }
+    }
+
+    static void decode(const Node* x, std::vector<std::string>& keys) {
+        for(size_t i=0; i<x->size(); i++) {
+            keys.push_back(x->key(i));
+        }
+    }
+
+    // Rewrites x to hold keys[first, last) under their longest common prefix
+    static void encode(Node* x, const std::vector<std::string>& keys, size_t first, size_t last) {
+        x->prefix.clear();
+        x->slab.clear();
+        x->offsets.assign(1, 0);
+        if(first == last) {
+            return;
+        }
+        x->prefix = keys[first].substr(0, commonPrefix(keys[first], keys[last - 1])); // sorted - the ends bound the rest
+        for(size_t i = first; i < last; i++) {
+            x->slab.append(keys[i], x->prefix.size());
+            x->offsets.push_back(static_cast<uint32_t>(x->slab.size()));
+        }
+    }
+
+    static size_t encodedBytes(const std::vector<std::string>& keys, size_t children) {
+        size_t total = (keys.size() + 1) * sizeof(uint32_t) + children * sizeof(Node*);
+        size_t p = keys.empty() ? 0 : commonPrefix(keys.front(), keys.back());
+        for(const std::string& k : keys) {
+            total += k.size() - p;
+        }
+        return total + p;
+    }
+
+    // Index splitting keys into two halves of roughly equal bytes, leaving
+    // at least one key (interior: one key on each side of the median) per side
+    static size_t splitPoint(const std::vector<std::string>& keys, bool leaf) {
+        size_t total = 0;
+        for(const std::string& k : keys) {
+            total += k.size() + sizeof(uint32_t);
+        }
+        size_t m = 0, acc = 0;
+        while(m < keys.size() && acc + keys[m].size() / 2 < total / 2) {
+            acc += keys[m++].size() + sizeof(uint32_t);
+        }
+        return std::clamp<size_t>(m, 1, keys.size() - (leaf ? 1 : 2));
+    }
+
+    // Shortest separator s with a < s <= b
+    static std::string_view shortestSeparator(std::string_view a, std::string_view b) {
+        return b.substr(0, commonPrefix(a, b) + 1);
+    }
+
+    bool insert(Node* x, std::string_view k) {
+        if(x->leaf) {
+            size_t i = search<false>(x, k);
+            if(i < x->size() && equals(x, i, k)) {
+                return false; // already present
+            }
+            insertKey(x, i, k);
+            size_++;
+            return true;
+        }
+        size_t i = search<true>(x, k);
+        bool added = insert(x->children[i], k);
+        if(x->children[i]->bytes() > PageBytes) {
+            splitChild(x, i);
+        }
+        return added;
+    }
+
+    bool remove(Node* x, std::string_view k) {
+        if(x->leaf) {
+            size_t i = search<false>(x, k);
+            if(i == x->size() || !equals(x, i, k)) {
+                return false;
+            }
+            eraseKey(x, i);
+            size_--;
+            return true;
+        }
+        size_t i = search<true>(x, k);
+        bool removed = remove(x->children[i], k);
+        if(removed) {
+            fixChild(x, i);
+        }
+        return removed;
+    }
+
+    void growRoot() {
+        Node* s = new Node();
+        s->leaf = false;
+        s->children.push_back(root);
+        root = s;
+        splitChild(s, 0);
+    }
+
+    // Splits the overflowing x->children[i] by bytes; the new right half
+    // becomes children[i+1] behind the separator
+    void splitChild(Node* x, size_t i) {
+        Node* y = x->children[i];
+        Node* z = new Node();
+        z->leaf = y->leaf;
+        std::vector<std::string> keys;
+        decode(y, keys);
+        size_t m = splitPoint(keys, y->leaf);
+        std::string separator;
+        if(y->leaf) {
+            separator = shortestSeparator(keys[m - 1], keys[m]);
+            encode(z, keys, m, keys.size());
+            z->next = y->next;
+            y->next = z;
+        } else {
+            separator = keys[m]; // the median moves up
+            encode(z, keys, m + 1, keys.size());
+            z->children.assign(y->children.begin() + m + 1, y->children.end());
+            y->children.resize(m + 1);
+        }
+        encode(y, keys, 0, m);
+        insertKey(x, i, separator);
+        x->children.insert(x->children.begin() + i + 1, z);
+    }
+
+    // After a removal under x->children[i]: split it if a new separator made
+    // it overflow, or merge it with / top it up from a sibling if it is short
+    void fixChild(Node* x, size_t i) {
+        Node* c = x->children[i];
+        if(c->bytes() > PageBytes) {
+            splitChild(x, i);
+        } else if(c->bytes() < minPageBytes && x->size() > 0) {
+            rebalance(x, i > 0 ? i - 1 : i);
+        }
+    }
+
+    // Merges children[i+1] into children[i] when the two fit in one page,
+    // otherwise splits their keys evenly between them again
+    void rebalance(Node* x, size_t i) {
+        Node* lhs = x->children[i];
+        Node* rhs = x->children[i + 1];
+        std::vector<std::string> keys;
+        decode(lhs, keys);
+        if(!lhs->leaf) {
+            keys.push_back(x->key(i)); // interior merges pull the separator down
+        }
+        decode(rhs, keys);
+        std::vector<Node*> children(lhs->children);
+        children.insert(children.end(), rhs->children.begin(), rhs->children.end());
+
+        eraseKey(x, i);
+        if(encodedBytes(keys, children.size()) <= PageBytes) {
+            encode(lhs, keys, 0, keys.size());
+            lhs->children = std::move(children);
+            lhs->next = rhs->next;
+            x->children.erase(x->children.begin() + i + 1);
+            rhs->children.clear();
+            delete rhs;
+            return;
+        }
+        size_t m = splitPoint(keys, lhs->leaf);
+        std::string separator;
+        if(lhs->leaf) {
+            separator = shortestSeparator(keys[m - 1], keys[m]);
+            encode(rhs, keys, m, keys.size());
+        } else {
+            separator = keys[m];
+            encode(rhs, keys, m + 1, keys.size());
+            lhs->children.assign(children.begin(), children.begin() + m + 1);
+            rhs->children.assign(children.begin() + m + 1, children.end());
+        }
+        encode(lhs, keys, 0, m);
+        insertKey(x, i, separator);
+    }
+
+    static void destroy(Node* x) {
+        std::vector<Node*> dead{x};
+        while(!dead.empty()) {
+            Node* y = dead.back();
+            dead.pop_back();
+            dead.insert(dead.end(), y->children.begin(), y->children.end());
+            delete y;
+        }
+    }
+};
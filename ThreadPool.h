@@ -0,0 +1,155 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <exception>
+#include <algorithm>
+#include <iterator>
+#include <functional>
+#include <cstddef>
+
+/*
+Fork-join thread pool
+invoke(f, g) runs f on the calling thread and offers g to the pool. When f
+is done, g is taken back and run inline if no worker has picked it up yet;
+otherwise the caller runs other queued tasks until g completes. Waiting
+never blocks a thread that could be working, so recursive divide and conquer
+(invoke inside invoke) cannot deadlock, and a pool of N threads keeps all N
+busy - the caller is one of them.
+
+Tasks live on the stack of the invoke() that created them, so queuing one
+allocates nothing beyond the deque's own storage. An exception thrown by g
+is rethrown from invoke() after both halves have finished.
+
+parallelSort(first, last, pool) is a merge sort on invoke(): the halves are
+sorted as forks down to sequentialCutoff elements, then std::sort takes over.
+*/
+
+class ThreadPool {
+    struct Task {
+        void (*run)(Task*);
+        std::atomic<bool> done{false};
+        std::exception_ptr error;
+    };
+    template <typename G>
+    struct Job : Task {
+        G& g;
+        explicit Job(G& g) : g(g) {
+            this->run = [](Task* t) {
+                try {
+                    static_cast<Job*>(t)->g();
+                } catch(...) {
+                    t->error = std::current_exception();
+                }
+                t->done.store(true, std::memory_order_release);
+            };
+        }
+    };
+
+    std::vector<std::thread> workers;
+    std::deque<Task*> tasks;
+    std::mutex m;
+    std::condition_variable cv;
+    bool stopping = false;
+public:
+    explicit ThreadPool(size_t threads = std::thread::hardware_concurrency()) {
+        for(size_t i=1; i<std::max<size_t>(threads, 1); i++) { // the thread calling invoke() is the last one
+            workers.emplace_back([this] { work(); });
+        }
+    }
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            stopping = true;
+        }
+        cv.notify_all();
+        for(std::thread& w : workers) {
+            w.join();
+        }
+    }
+    ThreadPool(const ThreadPool& pool) = delete;
+    ThreadPool& operator=(const ThreadPool& pool) = delete;
+
+    size_t size() const { return workers.size() + 1; }
+
+    template <typename F, typename G>
+    void invoke(F&& f, G&& g) {
+        Job<G> job(g);
+        {
+            std::lock_guard<std::mutex> lock(m);
+            tasks.push_back(&job);
+        }
+        cv.notify_one();
+        try {
+            f();
+        } catch(...) {
+            wait(&job); // job is on this stack frame
+            throw;
+        }
+        wait(&job);
+        if(job.error) {
+            std::rethrow_exception(job.error);
+        }
+    }
+private:
+    // Runs t inline if it is still queued, otherwise helps with other tasks until it finishes
+    void wait(Task* t) {
+        {
+            std::unique_lock<std::mutex> lock(m);
+            auto it = std::find(tasks.rbegin(), tasks.rend(), t);
+            if(it != tasks.rend()) {
+                tasks.erase(std::next(it).base());
+                lock.unlock();
+                t->run(t);
+                return;
+            }
+        }
+        while(!t->done.load(std::memory_order_acquire)) {
+            Task* other = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(m);
+                if(!tasks.empty()) {
+                    other = tasks.back(); // newest - the smallest piece of work
+                    tasks.pop_back();
+                }
+            }
+            if(other) {
+                other->run(other);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void work() {
+        while(true) {
+            Task* t;
+            {
+                std::unique_lock<std::mutex> lock(m);
+                cv.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if(tasks.empty()) {
+                    return; // stopping
+                }
+                t = tasks.front(); // oldest - the largest piece of work
+                tasks.pop_front();
+            }
+            t->run(t);
+        }
+    }
+};
+
+template <typename RandomIt, typename Compare = std::less<>>
+void parallelSort(RandomIt first, RandomIt last, ThreadPool& pool, Compare comp = Compare(), size_t sequentialCutoff = 1 << 14) {
+    auto n = static_cast<size_t>(std::distance(first, last));
+    if(pool.size() == 1 || n <= sequentialCutoff) {
+        std::sort(first, last, comp);
+        return;
+    }
+    RandomIt mid = first + n / 2;
+    pool.invoke([&] { parallelSort(first, mid, pool, comp, sequentialCutoff); },
+                [&] { parallelSort(mid, last, pool, comp, sequentialCutoff); });
+    std::inplace_merge(first, mid, last, comp);
+}
@@ -0,0 +1,64 @@
+// Loading an AVLTree: one push per key vs the O(n) range constructor
+// build: g++ -std=c++17 -O2 -march=native -pthread bench_AVLBuild.cpp -o bench_AVLBuild
+// usage: ./bench_AVLBuild [keys]   (default 2^22)
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <string>
+#include "AVLTree.h"
+
+template <typename F>
+double seconds(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(const char* name, double secs, size_t n, int size) {
+    std::cout << std::setw(36) << name << std::fixed << std::setprecision(3) << std::setw(10) << secs
+              << std::setw(12) << std::setprecision(2) << n / secs / 1e6 << std::setw(10) << size << "\n";
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? std::stoull(argv[1]) : (1 << 22);
+    std::mt19937 gen(42);
+    std::vector<int> sorted(n);
+    for(size_t i=0; i<n; i++) {
+        sorted[i] = static_cast<int>(2 * i);
+    }
+    std::vector<int> shuffled = sorted;
+    std::shuffle(shuffled.begin(), shuffled.end(), gen);
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << n << " int keys, " << threads << " hardware threads\n";
+    std::cout << std::setw(36) << "load" << std::setw(10) << "seconds" << std::setw(12) << "Mkeys/s" << std::setw(10) << "size" << "\n";
+    {
+        AVLTree<int> tree;
+        double secs = seconds([&] { for(int k : sorted) tree.push(int(k)); });
+        report("sorted, push loop", secs, n, tree.size());
+    }
+    {
+        AVLTree<int> tree;
+        double secs = seconds([&] { tree = AVLTree<int>(sorted.begin(), sorted.end()); });
+        report("sorted, range constructor", secs, n, tree.size());
+    }
+    {
+        AVLTree<int> tree;
+        double secs = seconds([&] { for(int k : shuffled) tree.push(int(k)); });
+        report("shuffled, push loop", secs, n, tree.size());
+    }
+    {
+        AVLTree<int> tree;
+        double secs = seconds([&] { tree = AVLTree<int>(shuffled.begin(), shuffled.end(), unsorted); });
+        report("shuffled, unsorted constructor", secs, n, tree.size());
+    }
+    {
+        ThreadPool pool(threads);
+        AVLTree<int> tree;
+        double secs = seconds([&] { tree = AVLTree<int>(shuffled.begin(), shuffled.end(), unsorted, &pool); });
+        report("shuffled, unsorted constructor+pool", secs, n, tree.size());
+    }
+    return 0;
+}
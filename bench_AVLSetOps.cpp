@@ -0,0 +1,57 @@
+// Combining two AVLTrees: one push per key vs join-based set_union, sequential and on a ThreadPool
+// build: g++ -std=c++17 -O2 -march=native -pthread bench_AVLSetOps.cpp -o bench_AVLSetOps
+// usage: ./bench_AVLSetOps [keys per tree]   (default 2^21)
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <string>
+#include "AVLTree.h"
+
+template <typename F>
+double seconds(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+AVLTree<int> build(const std::vector<int>& keys) {
+    AVLTree<int> tree;
+    for(int k : keys) {
+        tree.push(int(k));
+    }
+    return tree;
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? std::stoull(argv[1]) : (1 << 21);
+    std::mt19937 gen(42);
+    std::vector<int> a(n), b(n);
+    for(int& k : a) k = static_cast<int>(gen() % (4 * n)); // about 1/4 overlap between the trees
+    for(int& k : b) k = static_cast<int>(gen() % (4 * n));
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << "two trees of " << n << " random keys, " << threads << " hardware threads, seconds\n";
+    std::cout << std::setw(28) << "operation" << std::setw(12) << "push loop" << std::setw(12) << "sequential"
+              << std::setw(12) << "parallel" << std::setw(10) << "size" << "\n";
+
+    AVLTree<int> loop = build(a);
+    double tLoop = seconds([&] { for(int k : b) loop.push(int(k)); });
+    AVLTree<int> seq;
+    double tSeq = seconds([&, x = build(a), y = build(b)]() mutable { seq = set_union(std::move(x), std::move(y)); });
+    ThreadPool pool(threads);
+    AVLTree<int> par;
+    double tPar = seconds([&, x = build(a), y = build(b)]() mutable { par = set_union(std::move(x), std::move(y), &pool); });
+    std::cout << std::setw(28) << "union" << std::fixed << std::setprecision(3) << std::setw(12) << tLoop
+              << std::setw(12) << tSeq << std::setw(12) << tPar << std::setw(10) << par.size() << "\n";
+
+    AVLTree<int> inter, diff;
+    double tInter = seconds([&, x = build(a), y = build(b)]() mutable { inter = set_intersection(std::move(x), std::move(y), &pool); });
+    std::cout << std::setw(28) << "intersection" << std::setw(12) << "-" << std::setw(12) << "-"
+              << std::setw(12) << tInter << std::setw(10) << inter.size() << "\n";
+    double tDiff = seconds([&, x = build(a), y = build(b)]() mutable { diff = set_difference(std::move(x), std::move(y), &pool); });
+    std::cout << std::setw(28) << "difference" << std::setw(12) << "-" << std::setw(12) << "-"
+              << std::setw(12) << tDiff << std::setw(10) << diff.size() << "\n";
+    return 0;
+}
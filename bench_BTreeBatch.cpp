@@ -0,0 +1,71 @@
+// Sorted micro-batches: insert_batch/remove_batch vs one insert/remove per key
+// build: g++ -std=c++17 -O2 -march=native bench_BTreeBatch.cpp -o bench_BTreeBatch
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include "B-Tree.h"
+
+constexpr size_t preload = 1 << 20;
+constexpr size_t batchSize = 4096;
+constexpr size_t numBatches = 256;
+
+template <typename F>
+double seconds(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// spread: batch keys drawn from the whole key space (one per leaf, mostly)
+// dense: each batch covers a narrow key range (e.g. a time-ordered feed)
+std::vector<std::vector<int>> makeBatches(std::mt19937& gen, bool dense) {
+    std::vector<std::vector<int>> batches(numBatches);
+    for(auto& b : batches) {
+        int base = gen() % (1 << 30);
+        for(size_t i=0; i<batchSize; i++) {
+            b.push_back(dense ? base + static_cast<int>(gen() % (batchSize * 4)) : static_cast<int>(gen() % (1u << 31)));
+        }
+        std::sort(b.begin(), b.end());
+        b.erase(std::unique(b.begin(), b.end()), b.end());
+    }
+    return batches;
+}
+
+template <typename Make>
+void run(const char* name, Make make, const std::vector<int>& initial, const std::vector<std::vector<int>>& batches) {
+    size_t keys = 0;
+    for(const auto& b : batches) keys += b.size();
+    auto perKey = make();
+    auto batched = make();
+    perKey.bulk_load(initial.begin(), initial.end(), 0.7);
+    batched.bulk_load(initial.begin(), initial.end(), 0.7);
+
+    double loopIns = seconds([&] { for(const auto& b : batches) for(int k : b) perKey.insert(k); });
+    double batchIns = seconds([&] { for(const auto& b : batches) batched.insert_batch(b.begin(), b.end()); });
+    double loopRem = seconds([&] { for(const auto& b : batches) for(int k : b) perKey.remove(k); });
+    double batchRem = seconds([&] { for(const auto& b : batches) batched.remove_batch(b.begin(), b.end()); });
+
+    std::cout << std::setw(22) << name << std::fixed << std::setprecision(2)
+              << std::setw(12) << keys / loopIns / 1e6 << std::setw(12) << keys / batchIns / 1e6
+              << std::setw(12) << keys / loopRem / 1e6 << std::setw(12) << keys / batchRem / 1e6 << "\n";
+}
+
+int main() {
+    std::mt19937 gen(42);
+    std::vector<int> initial(preload);
+    for(int& k : initial) k = gen() % (1u << 31);
+    std::sort(initial.begin(), initial.end());
+
+    std::cout << preload << " keys preloaded, " << numBatches << " sorted batches of " << batchSize << ", Mkeys/s\n";
+    std::cout << std::setw(22) << "tree / batches" << std::setw(12) << "insert" << std::setw(12) << "ins_batch"
+              << std::setw(12) << "remove" << std::setw(12) << "rem_batch" << "\n";
+    for(bool dense : {false, true}) {
+        auto batches = makeBatches(gen, dense);
+        run(dense ? "BTree<int,16> dense" : "BTree<int,16> spread", [] { return BTree<int, 16>(); }, initial, batches);
+        run(dense ? "BTree<int>(16) dense" : "BTree<int>(16) spread", [] { return BTree<int>(16); }, initial, batches);
+    }
+    return 0;
+}
@@ -0,0 +1,66 @@
+// Random-insert ingest and point lookups: buffered (B-epsilon) tree vs BTree and BPlusTree
+// build: g++ -std=c++17 -O2 -march=native bench_BufferedBTree.cpp -o bench_BufferedBTree
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include "B-Tree.h"
+#include "BPlusTree.h"
+#include "BufferedBTree.h"
+
+constexpr size_t numKeys = 1 << 23;
+constexpr size_t numLookups = 1 << 21;
+
+template <typename F>
+double seconds(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename Tree, typename Lookup>
+void run(const char* name, Tree& tree, const std::vector<int>& keys, const std::vector<int>& probes, Lookup lookup) {
+    double ins = seconds([&] {
+        for(int k : keys) tree.insert(k);
+    });
+    size_t hits = 0;
+    double look = seconds([&] {
+        for(int k : probes) hits += lookup(tree, k);
+    });
+    std::cout << std::setw(28) << name << std::fixed << std::setprecision(2)
+              << std::setw(14) << keys.size() / ins / 1e6
+              << std::setw(14) << probes.size() / look / 1e6
+              << std::setw(10) << hits << "\n";
+}
+
+int main() {
+    std::mt19937 gen(42);
+    std::vector<int> keys(numKeys), probes(numLookups);
+    for(int& k : keys) k = gen();
+    for(size_t i=0; i<numLookups; i++) probes[i] = (i % 2) ? keys[gen() % numKeys] : static_cast<int>(gen());
+
+    std::cout << numKeys << " random inserts, then " << numLookups << " lookups (half hits)\n";
+    std::cout << std::setw(28) << "tree" << std::setw(14) << "insert Mops/s" << std::setw(14) << "lookup Mops/s" << std::setw(10) << "hits" << "\n";
+    {
+        BTree<int, 16> tree;
+        run("BTree<int, 16>", tree, keys, probes, [](auto& t, int k) { return t.search(k).first != nullptr; });
+    }
+    {
+        BPlusTree<int, 16> tree;
+        run("BPlusTree<int, 16>", tree, keys, probes, [](auto& t, int k) { return t.contains(k); });
+    }
+    {
+        BufferedBTree<int> tree; // Degree 16, 1024-message buffers, 256-key leaves
+        run("BufferedBTree<int>", tree, keys, probes, [](auto& t, int k) { return t.contains(k); });
+    }
+    {
+        BufferedBTree<int, 8, 1024, 256> tree;
+        run("BufferedBTree<8, 1024, 256>", tree, keys, probes, [](auto& t, int k) { return t.contains(k); });
+    }
+    {
+        BufferedBTree<int, 16, 256, 64> tree;
+        run("BufferedBTree<16, 256, 64>", tree, keys, probes, [](auto& t, int k) { return t.contains(k); });
+    }
+    return 0;
+}
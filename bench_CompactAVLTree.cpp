@@ -0,0 +1,73 @@
+// Pointer AVLTree vs index-based CompactAVLTree: memory, insert and lookup on random int keys
+// build: g++ -std=c++17 -O2 -march=native bench_CompactAVLTree.cpp -o bench_CompactAVLTree
+// usage: ./bench_CompactAVLTree [keys]   (default 2^22; 100M keys needs ~2 GiB for the compact tree, ~4 GiB for the pointer one)
+// Memory is the growth of glibc's in-use heap while the tree is built.
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <string>
+#include <malloc.h>
+#include "AVLTree.h"
+#include "CompactAVLTree.h"
+
+template <typename F>
+double seconds(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+volatile size_t sink;
+
+size_t heapInUse() {
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd; // large vector buffers come straight from mmap
+}
+
+template <typename Tree, typename Insert, typename Lookup>
+void run(const char* name, const std::vector<int>& keys, const std::vector<int>& probes, Insert insert, Lookup lookup) {
+    size_t before = heapInUse();
+    Tree* tree = new Tree();
+    double ins = seconds([&] { insert(*tree, keys); });
+    size_t bytes = heapInUse() - before;
+    size_t sum = 0;
+    double look = seconds([&] {
+        for(int k : probes) sum += lookup(*tree, k);
+    });
+    sink = sum;
+    std::cout << std::setw(30) << name << std::fixed << std::setprecision(1)
+              << std::setw(10) << bytes / double(1 << 20) << std::setw(8) << double(bytes) / keys.size()
+              << std::setprecision(2) << std::setw(12) << keys.size() / ins / 1e6
+              << std::setw(12) << probes.size() / look / 1e6 << "\n";
+    delete tree;
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? std::stoull(argv[1]) : (1 << 22);
+    std::mt19937 gen(42);
+    std::vector<int> keys(n);
+    for(size_t i=0; i<n; i++) {
+        keys[i] = static_cast<int>(i);
+    }
+    std::shuffle(keys.begin(), keys.end(), gen); // distinct keys, random order
+    std::vector<int> probes(n);
+    for(int& p : probes) {
+        p = static_cast<int>(gen() % (2 * n)); // about half hit
+    }
+
+    std::cout << n << " random int keys, " << n << " lookups (about half hits)\n";
+    std::cout << std::setw(30) << "tree" << std::setw(10) << "MiB" << std::setw(8) << "B/key"
+              << std::setw(12) << "ins Mops/s" << std::setw(12) << "look Mops/s" << "\n";
+    run<AVLTree<int>>("AVLTree<int> (pointers)", keys, probes,
+        [](auto& t, const std::vector<int>& ks) { for(int k : ks) t.push(int(k)); },
+        [](auto& t, int k) { return t.contains(k); });
+    run<CompactAVLTree<int>>("CompactAVLTree<int>", keys, probes,
+        [](auto& t, const std::vector<int>& ks) { for(int k : ks) t.push(k); },
+        [](auto& t, int k) { return t.contains(k); });
+    run<CompactAVLTree<int>>("CompactAVLTree<int> reserved", keys, probes,
+        [](auto& t, const std::vector<int>& ks) { t.reserve(ks.size()); for(int k : ks) t.push(k); },
+        [](auto& t, int k) { return t.contains(k); });
+    return 0;
+}
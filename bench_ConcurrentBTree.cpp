@@ -0,0 +1,93 @@
+// Multi-threaded throughput: optimistic lock coupling vs one mutex around BTree
+// build: g++ -std=c++17 -O2 -march=native -pthread bench_ConcurrentBTree.cpp -o bench_ConcurrentBTree
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include "B-Tree.h"
+#include "ConcurrentBTree.h"
+
+constexpr int keySpace = 1 << 22;
+constexpr size_t opsPerThread = 1 << 18;
+std::atomic<size_t> sink{0};
+
+// One global lock, i.e. what callers do today - with the same set semantics as
+// ConcurrentBTree (BTree keeps duplicates), so both trees hold the same keys
+class LockedBTree {
+    std::mutex m;
+    BTree<int, 16> tree;
+public:
+    bool contains(int k) { std::lock_guard<std::mutex> g(m); return tree.search(k).first != nullptr; }
+    bool insert(int k) {
+        std::lock_guard<std::mutex> g(m);
+        if(tree.search(k).first != nullptr) {
+            return false;
+        }
+        tree.insert(k);
+        return true;
+    }
+    bool remove(int k) {
+        std::lock_guard<std::mutex> g(m);
+        if(tree.search(k).first == nullptr) {
+            return false;
+        }
+        tree.remove(k);
+        return true;
+    }
+};
+
+template <typename Tree>
+double run(Tree& tree, int threads, int readPercent) {
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for(int w = 0; w < threads; w++) {
+        workers.emplace_back([&, w] {
+            std::mt19937 gen(w * 7919 + readPercent);
+            size_t hits = 0;
+            for(size_t i = 0; i < opsPerThread; i++) {
+                int k = gen() % keySpace;
+                int op = gen() % 100;
+                if(op < readPercent) {
+                    hits += tree.contains(k);
+                } else if(op % 2 == 0) {
+                    hits += tree.insert(k);
+                } else {
+                    hits += tree.remove(k);
+                }
+            }
+            sink.fetch_add(hits, std::memory_order_relaxed);
+        });
+    }
+    for(auto& w : workers) w.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return threads * opsPerThread / secs / 1e6;
+}
+
+template <typename Tree>
+void prefill(Tree& tree) {
+    std::mt19937 gen(1);
+    for(int i = 0; i < keySpace / 2; i++) tree.insert(gen() % keySpace);
+}
+
+int main() {
+    std::cout << "hardware threads: " << std::thread::hardware_concurrency() << "\n";
+    std::cout << "Mops/s, " << keySpace / 2 << " prefilled inserts, " << opsPerThread << " ops per thread\n";
+    std::cout << std::setw(8) << "threads" << std::setw(8) << "read%" << std::setw(12) << "OLC" << std::setw(12) << "mutex" << "\n";
+    for(int readPercent : {100, 95, 50, 0}) {
+        for(int threads : {1, 2, 4, 8, 16, 32}) {
+            ConcurrentBTree<int, 16> olc;
+            LockedBTree locked;
+            prefill(olc);
+            prefill(locked);
+            double a = run(olc, threads, readPercent);
+            double b = run(locked, threads, readPercent);
+            std::cout << std::setw(8) << threads << std::setw(8) << readPercent << std::fixed << std::setprecision(2)
+                      << std::setw(12) << a << std::setw(12) << b << "\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,80 @@
+// Lookups in pointer trees vs their frozen Eytzinger copy (in memory and mmapped), random int keys
+// build: g++ -std=c++17 -O2 -march=native -pthread bench_FrozenTree.cpp -o bench_FrozenTree
+// usage: ./bench_FrozenTree [keys]   (default 2^22)
+// Every structure answers the same lookups, about half of them hits; std::lower_bound on the
+// sorted keys is the pointer-free baseline without the Eytzinger layout.
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <string>
+#include <algorithm>
+#include <cstdio>
+#include "BST.h"
+#include "AVLTree.h"
+#include "Red-Black-Tree.h"
+#include "FrozenTree.h"
+
+template <typename F>
+double seconds(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+volatile size_t sink;
+
+template <typename Lookup>
+void run(const char* name, const std::vector<int>& probes, Lookup lookup) {
+    size_t hits = 0;
+    double t = seconds([&] {
+        for(int k : probes) hits += lookup(k);
+    });
+    sink = hits;
+    std::cout << std::setw(28) << name << std::fixed << std::setprecision(2)
+              << std::setw(12) << probes.size() / t / 1e6 << std::setw(10) << t * 1e9 / probes.size() << "\n";
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? std::stoull(argv[1]) : (1 << 22);
+    std::mt19937 gen(42);
+    std::vector<int> keys(n);
+    for(size_t i=0; i<n; i++) {
+        keys[i] = static_cast<int>(i) * 2;
+    }
+    std::shuffle(keys.begin(), keys.end(), gen); // distinct even keys, random order
+    std::vector<int> probes(n);
+    for(int& p : probes) {
+        p = static_cast<int>(gen() % (2 * n)); // about half hit
+    }
+
+    BST<int> bst;
+    AVLTree<int> avl;
+    RBTree<int> rb;
+    for(int k : keys) {
+        bst.insert(k);
+        avl.push(k);
+        rb.insert(k);
+    }
+    std::vector<int> sorted(keys);
+    std::sort(sorted.begin(), sorted.end());
+
+    FrozenTree<int> frozen;
+    double freezeTime = seconds([&] { frozen = rb.freeze(); });
+    const std::string path = "bench_frozen_tree.bin";
+    frozen.save(path);
+    FrozenTree<int> mapped = FrozenTree<int>::map(path);
+
+    std::cout << n << " random int keys, " << n << " lookups (about half hits); RBTree::freeze took "
+              << std::fixed << std::setprecision(3) << freezeTime << " s\n";
+    std::cout << std::setw(28) << "structure" << std::setw(12) << "Mops/s" << std::setw(10) << "ns/op" << "\n";
+    run("BST::search", probes, [&](int k) { return bst.search(k) != nullptr; });
+    run("AVLTree::contains", probes, [&](int k) { return avl.contains(k); });
+    run("RBTree::search", probes, [&](int k) { return rb.search(k) != nullptr; });
+    run("std::binary_search (sorted)", probes, [&](int k) { return std::binary_search(sorted.begin(), sorted.end(), k); });
+    run("FrozenTree::contains", probes, [&](int k) { return frozen.contains(k); });
+    run("FrozenTree (mmapped)", probes, [&](int k) { return mapped.contains(k); });
+    std::remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,60 @@
+// Overlap queries on RBTree<Interval<int>>: overlaps() against scanning every interval in order
+// build: g++ -std=c++17 -O2 -march=native bench_IntervalTree.cpp -o bench_IntervalTree
+// usage: ./bench_IntervalTree [intervals] [queries]   (default 2^20, 256 - the full scans dominate the run)
+// Intervals start uniformly in [0, 2^30) and are up to 2^12 long; queries are points and 2^16-wide windows.
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <string>
+#include "Red-Black-Tree.h"
+
+template <typename F>
+double seconds(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+volatile size_t sink;
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? std::stoull(argv[1]) : (1 << 20);
+    size_t q = argc > 2 ? std::stoull(argv[2]) : 256;
+    std::mt19937 gen(42);
+    RBTree<Interval<int>> tree;
+    for(size_t i=0; i<n; i++) {
+        int low = static_cast<int>(gen() % (1u << 30));
+        tree.insert({low, low + static_cast<int>(gen() % (1u << 12))});
+    }
+    std::vector<Interval<int>> queries(q);
+    for(Interval<int>& w : queries) {
+        w.low = static_cast<int>(gen() % (1u << 30));
+        w.high = w.low;
+    }
+
+    std::cout << n << " intervals, " << q << " queries of each kind\n";
+    std::cout << std::setw(16) << "query" << std::setw(12) << "hits/query" << std::setw(14) << "scan us/q" << std::setw(16) << "overlaps us/q" << "\n";
+    for(int width : {0, 1 << 16}) {
+        size_t hits = 0, scanned = 0;
+        double scan = seconds([&] {
+            for(const Interval<int>& w : queries) {
+                Interval<int> window{w.low, w.low + width};
+                for(const Interval<int>& r : tree) {
+                    scanned += r.overlaps(window);
+                }
+            }
+        });
+        double indexed = seconds([&] {
+            for(const Interval<int>& w : queries) {
+                tree.overlaps(Interval<int>{w.low, w.low + width}, [&](const Interval<int>&) { hits++; });
+            }
+        });
+        sink = hits + scanned;
+        std::cout << std::setw(16) << (width ? "window 2^16" : "point") << std::fixed << std::setprecision(2)
+                  << std::setw(12) << double(hits) / q << std::setw(14) << scan / q * 1e6
+                  << std::setw(16) << indexed / q * 1e6 << (hits == scanned ? "" : "  MISMATCH") << "\n";
+    }
+    return 0;
+}
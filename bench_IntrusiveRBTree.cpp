@@ -0,0 +1,86 @@
+// RBTree (a node allocated per insert) vs IntrusiveRBTree (hooks embedded in preallocated objects)
+// build: g++ -std=c++17 -O2 -march=native bench_IntrusiveRBTree.cpp -o bench_IntrusiveRBTree
+// usage: ./bench_IntrusiveRBTree [keys]   (default 2^20)
+// Each round inserts every key and then erases every key, both in random order.
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <string>
+#include <algorithm>
+#include "Red-Black-Tree.h"
+#include "IntrusiveRBTree.h"
+
+template <typename F>
+double seconds(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct Item {
+    int key;
+    rb_hook hook;
+    bool operator<(const Item& rhs) const { return key < rhs.key; }
+};
+
+void report(const char* name, size_t n, double ins, double era) {
+    std::cout << std::setw(34) << name << std::fixed << std::setprecision(2)
+              << std::setw(12) << n / ins / 1e6 << std::setw(12) << n / era / 1e6 << "\n";
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? std::stoull(argv[1]) : (1 << 20);
+    const int rounds = 3;
+    std::mt19937 gen(42);
+    std::vector<int> keys(n);
+    for(size_t i=0; i<n; i++) {
+        keys[i] = static_cast<int>(i);
+    }
+    std::shuffle(keys.begin(), keys.end(), gen);
+    std::vector<int> order = keys;
+    std::shuffle(order.begin(), order.end(), gen); // erase order
+
+    std::cout << n << " random int keys, " << rounds << " rounds of insert all / erase all\n";
+    std::cout << std::setw(34) << "tree" << std::setw(12) << "ins Mops/s" << std::setw(12) << "del Mops/s" << "\n";
+
+    double ins = 0, era = 0;
+    {
+        RBTree<int, HeapAllocator> tree;
+        for(int r=0; r<rounds; r++) {
+            ins += seconds([&] { for(int k : keys) tree.insert(k); });
+            era += seconds([&] { for(int k : order) tree.remove(k); });
+        }
+    }
+    report("RBTree<int, HeapAllocator>", n * rounds, ins, era);
+
+    ins = era = 0;
+    {
+        RBTree<int> tree;
+        for(int r=0; r<rounds; r++) {
+            ins += seconds([&] { for(int k : keys) tree.insert(k); });
+            era += seconds([&] { for(int k : order) tree.remove(k); });
+        }
+    }
+    report("RBTree<int> (slab)", n * rounds, ins, era);
+
+    ins = era = 0;
+    {
+        std::vector<Item> items(n);
+        for(size_t i=0; i<n; i++) {
+            items[i].key = keys[i];
+        }
+        std::vector<Item*> byOrder(n);
+        for(size_t i=0; i<n; i++) {
+            byOrder[static_cast<size_t>(keys[i])] = &items[i];
+        }
+        IntrusiveRBTree<Item, &Item::hook> tree;
+        for(int r=0; r<rounds; r++) {
+            ins += seconds([&] { for(Item& it : items) tree.insert(it); });
+            era += seconds([&] { for(int k : order) tree.erase(*byOrder[static_cast<size_t>(k)]); });
+        }
+    }
+    report("IntrusiveRBTree<Item>", n * rounds, ins, era);
+    return 0;
+}
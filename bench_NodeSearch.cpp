@@ -0,0 +1,97 @@
+// Intra-node search kernels across B-Tree degrees 2..128
+// build: g++ -std=c++17 -O2 -march=native bench_NodeSearch.cpp -o bench_NodeSearch
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <utility>
+#include "B-Tree.h"
+
+constexpr size_t degrees[] = {2, 4, 8, 16, 32, 64, 128};
+constexpr size_t numQueries = 1 << 21;
+
+volatile size_t sink;
+
+template <typename F>
+double nsPerQuery(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    size_t result = f();
+    auto end = std::chrono::steady_clock::now();
+    sink = result;
+    return std::chrono::duration<double, std::nano>(end - start).count() / numQueries;
+}
+
+// one node's worth of keys repeated over enough nodes to leave L1
+void benchKernels(size_t t, std::mt19937& gen) {
+    size_t n = 2 * t - 1;
+    size_t numNodes = std::max<size_t>(1, (1 << 20) / (n * sizeof(int)));
+    std::vector<int> keys(numNodes * n);
+    for(size_t node = 0; node < numNodes; node++) {
+        for(size_t j = 0; j < n; j++) keys[node * n + j] = gen() % 100000;
+        std::sort(keys.begin() + node * n, keys.begin() + (node + 1) * n);
+    }
+    std::vector<std::pair<size_t, int>> queries(numQueries);
+    for(auto& q : queries) q = {gen() % numNodes, static_cast<int>(gen() % 100000)};
+
+    auto run = [&](auto kernel) {
+        return nsPerQuery([&] {
+            size_t sum = 0;
+            for(auto& q : queries) sum += kernel(keys.data() + q.first * n, n, q.second);
+            return sum;
+        });
+    };
+    double scalar = run([](const int* k, size_t n, int v) { return nodesearch::scalarSearch<false>(k, n, v); });
+    double branchless = run([](const int* k, size_t n, int v) { return nodesearch::branchlessSearch<false>(k, n, v); });
+#if defined(__SSE2__)
+    double simd = run([](const int* k, size_t n, int v) { return nodesearch::simdSearch<false>(k, n, v); });
+#else
+    double simd = 0;
+#endif
+    double dispatched = run([](const int* k, size_t n, int v) { return nodeLowerBound(k, n, v); });
+    std::cout << std::setw(6) << t << std::setw(6) << n << std::fixed << std::setprecision(2)
+              << std::setw(12) << scalar << std::setw(12) << branchless
+              << std::setw(12) << simd << std::setw(12) << dispatched << "\n";
+}
+
+template <size_t Degree>
+void benchTree(const std::vector<int>& vals, const std::vector<int>& queries) {
+    BTree<int, Degree> tree;
+    for(int v : vals) tree.insert(v);
+    double ns = nsPerQuery([&] {
+        size_t found = 0;
+        for(int q : queries) found += tree.search(q).first != nullptr;
+        return found;
+    });
+    std::cout << std::setw(6) << Degree << std::setw(14) << std::fixed << std::setprecision(2) << ns << "\n";
+}
+
+template <size_t... I>
+void benchTrees(std::index_sequence<I...>, const std::vector<int>& vals, const std::vector<int>& queries) {
+    (benchTree<degrees[I]>(vals, queries), ...);
+}
+
+int main() {
+    std::mt19937 gen(42);
+#if defined(__AVX2__)
+    std::cout << "SIMD: AVX2\n";
+#elif defined(__SSE2__)
+    std::cout << "SIMD: SSE2\n";
+#endif
+    std::cout << "ns per node search (int keys)\n";
+    std::cout << std::setw(6) << "t" << std::setw(6) << "keys" << std::setw(12) << "scalar"
+              << std::setw(12) << "branchless" << std::setw(12) << "simd" << std::setw(12) << "dispatch" << "\n";
+    for(size_t t : degrees) {
+        benchKernels(t, gen);
+    }
+
+    std::vector<int> vals(1 << 20);
+    for(int& v : vals) v = static_cast<int>(gen());
+    std::vector<int> queries(numQueries);
+    for(int& q : queries) q = vals[gen() % vals.size()];
+    std::cout << "\nns per BTree<int, t>::search, " << vals.size() << " keys\n";
+    std::cout << std::setw(6) << "t" << std::setw(14) << "search" << "\n";
+    benchTrees(std::make_index_sequence<std::size(degrees)>{}, vals, queries);
+    return 0;
+}
@@ -0,0 +1,101 @@
+// One writer, N readers: RBTree behind a std::shared_mutex vs VersionedRBTree snapshots
+// build: g++ -std=c++17 -O2 -march=native -pthread bench_PersistentRBTree.cpp -o bench_PersistentRBTree
+// usage: ./bench_PersistentRBTree [keys] [max readers]   (default 2^20, hardware threads)
+// The writer replaces random keys for the whole run; readers look up random keys,
+// taking the lock per lookup or a fresh snapshot every 64 lookups.
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <shared_mutex>
+#include <string>
+#include "Red-Black-Tree.h"
+#include "PersistentRBTree.h"
+
+const double runSeconds = 1.0;
+std::atomic<size_t> sink{0};
+
+template <typename Read, typename Write>
+void run(const char* name, size_t readers, size_t n, Read read, Write write) {
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> lookups{0};
+    size_t updates = 0;
+    std::vector<std::thread> threads;
+    for(size_t t=0; t<readers; t++) {
+        threads.emplace_back([&, t] {
+            std::mt19937 gen(static_cast<unsigned>(t + 1));
+            size_t done = 0, hits = 0;
+            auto start = std::chrono::steady_clock::now();
+            while(!stop.load(std::memory_order_relaxed)) {
+                done += read(gen, n, hits);
+                if(done % 64 == 0 && std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > runSeconds) {
+                    break; // even if the writer is starved
+                }
+            }
+            lookups += done;
+            sink += hits;
+        });
+    }
+    std::mt19937 gen(0);
+    auto start = std::chrono::steady_clock::now();
+    while(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < runSeconds) {
+        write(gen, n);
+        updates++;
+    }
+    stop = true;
+    for(std::thread& t : threads) {
+        t.join();
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << std::setw(26) << name << std::setw(9) << readers << std::fixed << std::setprecision(2)
+              << std::setw(14) << lookups / secs / 1e6 << std::setw(14) << updates / secs / 1e3 << "\n";
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? std::stoull(argv[1]) : (1 << 20);
+    size_t maxReaders = argc > 2 ? std::stoull(argv[2]) : std::max(1u, std::thread::hardware_concurrency());
+
+    RBTree<int, HeapAllocator> locked;
+    std::shared_mutex m;
+    VersionedRBTree<int> versioned;
+    PersistentRBTree<int> initial;
+    for(size_t i=0; i<n; i += 2) { // even keys - about half the lookups hit
+        locked.insert(static_cast<int>(i));
+        initial = std::move(initial).insert(static_cast<int>(i));
+    }
+    versioned.publish(initial);
+    initial = PersistentRBTree<int>();
+
+    std::cout << n / 2 << " keys, " << runSeconds << " s per run\n";
+    std::cout << std::setw(26) << "tree" << std::setw(9) << "readers" << std::setw(14) << "look Mops/s" << std::setw(14) << "upd Kops/s" << "\n";
+    for(size_t r=1; r<=maxReaders; r *= 2) {
+        run("RBTree + shared_mutex", r, n,
+            [&](std::mt19937& gen, size_t n, size_t& hits) {
+                std::shared_lock<std::shared_mutex> lock(m);
+                hits += locked.search(static_cast<int>(gen() % n)) != nullptr;
+                return size_t(1);
+            },
+            [&](std::mt19937& gen, size_t n) {
+                int k = static_cast<int>(gen() % n);
+                std::unique_lock<std::shared_mutex> lock(m);
+                locked.remove(k);
+                locked.insert(k);
+            });
+        run("VersionedRBTree", r, n,
+            [&](std::mt19937& gen, size_t n, size_t& hits) {
+                PersistentRBTree<int> snap = versioned.snapshot();
+                for(int i=0; i<64; i++) {
+                    hits += snap.contains(static_cast<int>(gen() % n));
+                }
+                return size_t(64);
+            },
+            [&](std::mt19937& gen, size_t n) {
+                int k = static_cast<int>(gen() % n);
+                versioned.update([k](const PersistentRBTree<int>& v) { return v.remove(k).insert(k); });
+            });
+    }
+    return 0;
+}
@@ -0,0 +1,54 @@
+// RBTree insert from the root vs append_max / insert_hint on sorted and nearly sorted streams
+// build: g++ -std=c++17 -O2 -march=native bench_RBTreeHint.cpp -o bench_RBTreeHint
+// usage: ./bench_RBTreeHint [keys]   (default 2^22)
+// "nearly sorted" is an increasing timestamp stream where 1 key in 100 arrives up to 1000 steps late.
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <string>
+#include "Red-Black-Tree.h"
+
+template <typename F>
+double seconds(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename Insert>
+void run(const char* stream, const char* method, const std::vector<long>& keys, Insert insert) {
+    RBTree<long> tree;
+    double secs = seconds([&] { insert(tree, keys); });
+    std::cout << std::setw(16) << stream << std::setw(22) << method << std::fixed << std::setprecision(2)
+              << std::setw(12) << keys.size() / secs / 1e6 << "\n";
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? std::stoull(argv[1]) : (1 << 22);
+    std::mt19937 gen(42);
+    std::vector<long> sorted(n), nearly(n), descending(n);
+    for(size_t i=0; i<n; i++) {
+        sorted[i] = static_cast<long>(i);
+        descending[i] = static_cast<long>(n - i);
+        nearly[i] = static_cast<long>(i) - (gen() % 100 == 0 ? static_cast<long>(gen() % 1000) : 0);
+    }
+
+    std::cout << n << " keys\n";
+    std::cout << std::setw(16) << "stream" << std::setw(22) << "method" << std::setw(12) << "ins Mops/s" << "\n";
+    auto fromRoot = [](RBTree<long>& t, const std::vector<long>& ks) { for(long k : ks) t.insert(k); };
+    auto append = [](RBTree<long>& t, const std::vector<long>& ks) { for(long k : ks) t.append_max(k); };
+    auto hintPrev = [](RBTree<long>& t, const std::vector<long>& ks) { // each key goes before the previous one
+        RBTreeNode<long>* hint = nullptr;
+        for(long k : ks) hint = t.insert_hint(hint, k);
+    };
+    run("sorted", "insert", sorted, fromRoot);
+    run("sorted", "append_max", sorted, append);
+    run("sorted", "insert_hint(nullptr)", sorted, [](RBTree<long>& t, const std::vector<long>& ks) { for(long k : ks) t.insert_hint(nullptr, k); });
+    run("nearly sorted", "insert", nearly, fromRoot);
+    run("nearly sorted", "append_max", nearly, append);
+    run("descending", "insert", descending, fromRoot);
+    run("descending", "insert_hint(previous)", descending, hintPrev);
+    return 0;
+}
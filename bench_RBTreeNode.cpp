@@ -0,0 +1,74 @@
+// RBTree node footprint: memory, insert, lookup and remove on random int and 8-byte keys
+// build: g++ -std=c++17 -O2 -march=native bench_RBTreeNode.cpp -o bench_RBTreeNode
+// usage: ./bench_RBTreeNode [keys]   (default 2^22)
+// Memory is the growth of glibc's in-use heap while the tree is built (slab chunks included).
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <string>
+#include <algorithm>
+#include <malloc.h>
+#include "Red-Black-Tree.h"
+
+template <typename F>
+double seconds(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+volatile size_t sink;
+
+size_t heapInUse() {
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+}
+
+template <typename K>
+void run(const char* name, const std::vector<K>& keys, const std::vector<K>& probes) {
+    size_t before = heapInUse();
+    RBTree<K>* tree = new RBTree<K>();
+    double ins = seconds([&] {
+        for(const K& k : keys) tree->insert(k);
+    });
+    size_t bytes = heapInUse() - before;
+    size_t hits = 0;
+    double look = seconds([&] {
+        for(const K& k : probes) hits += tree->search(k) != nullptr;
+    });
+    sink = hits;
+    double rem = seconds([&] {
+        for(size_t i=0; i<keys.size(); i+=2) tree->remove(keys[i]);
+    });
+    std::cout << std::setw(18) << name << std::setw(8) << sizeof(RBTreeNode<K>) << std::fixed << std::setprecision(1)
+              << std::setw(10) << bytes / double(1 << 20) << std::setw(8) << double(bytes) / keys.size()
+              << std::setprecision(2) << std::setw(12) << keys.size() / ins / 1e6
+              << std::setw(12) << probes.size() / look / 1e6
+              << std::setw(12) << (keys.size() / 2) / rem / 1e6 << "\n";
+    delete tree;
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? std::stoull(argv[1]) : (1 << 22);
+    std::mt19937_64 gen(42);
+    std::vector<long long> wide(n);
+    for(size_t i=0; i<n; i++) {
+        wide[i] = static_cast<long long>(i) * 2;
+    }
+    std::shuffle(wide.begin(), wide.end(), gen); // distinct even keys, random order
+    std::vector<long long> wideProbes(n);
+    for(long long& p : wideProbes) {
+        p = static_cast<long long>(gen() % (2 * n)); // about half hit
+    }
+    std::vector<int> narrow(wide.begin(), wide.end());
+    std::vector<int> narrowProbes(wideProbes.begin(), wideProbes.end());
+
+    std::cout << n << " random keys, " << n << " lookups (about half hits), then every other key removed\n";
+    std::cout << std::setw(18) << "tree" << std::setw(8) << "node B" << std::setw(10) << "MiB" << std::setw(8) << "B/key"
+              << std::setw(12) << "ins Mops/s" << std::setw(12) << "look Mops/s" << std::setw(12) << "rm Mops/s" << "\n";
+    run("RBTree<int>", narrow, narrowProbes);
+    run("RBTree<long long>", wide, wideProbes);
+    return 0;
+}
@@ -0,0 +1,128 @@
+// Multi-threaded throughput: one AVLTree behind a shared_mutex vs ShardedSet, static and rebalancing
+// build: g++ -std=c++17 -O2 -march=native -pthread bench_ShardedSet.cpp -o bench_ShardedSet
+// usage: ./bench_ShardedSet [max threads]   (default 64)
+// 90% contains, 5% insert, 5% erase over 2^20 keys, half prefilled. Zipfian keys (theta 0.99) are
+// not scrambled, so the hot keys sit together at the low end - the case range partitioning handles worst.
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <shared_mutex>
+#include <cmath>
+#include <string>
+#include "ShardedSet.h"
+
+constexpr int keySpace = 1 << 20;
+constexpr size_t opsPerThread = 1 << 16;
+constexpr size_t shardCount = 64;
+std::atomic<size_t> sink{0};
+
+// Gray et al., "Quickly generating billion-record synthetic databases" - as used by YCSB
+class Zipfian {
+    double theta, alpha, zetan, eta;
+    uint64_t n;
+public:
+    Zipfian(uint64_t n, double theta) : theta(theta), n(n) {
+        double zeta2 = 1 + std::pow(0.5, theta);
+        zetan = 0;
+        for(uint64_t i=1; i<=n; i++) {
+            zetan += 1 / std::pow(double(i), theta);
+        }
+        alpha = 1 / (1 - theta);
+        eta = (1 - std::pow(2.0 / n, 1 - theta)) / (1 - zeta2 / zetan);
+    }
+    uint64_t operator()(std::mt19937_64& gen) const {
+        double u = std::uniform_real_distribution<double>(0, 1)(gen);
+        double uz = u * zetan;
+        if(uz < 1) return 0;
+        if(uz < 1 + std::pow(0.5, theta)) return 1;
+        return static_cast<uint64_t>(n * std::pow(eta * u - eta + 1, alpha)) % n;
+    }
+};
+
+class LockedAVL {
+    mutable std::shared_mutex m;
+    AVLTree<int, HeapAllocator> tree;
+public:
+    bool contains(int k) const { std::shared_lock<std::shared_mutex> g(m); return tree.contains(k); }
+    bool insert(int k) { std::unique_lock<std::shared_mutex> g(m); return tree.push(k); }
+    bool erase(int k) { std::unique_lock<std::shared_mutex> g(m); return tree.erase(k); }
+};
+
+template <typename Set, typename Keys>
+double run(Set& set, int threads, const Keys& keys) {
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for(int w=0; w<threads; w++) {
+        workers.emplace_back([&, w] {
+            std::mt19937_64 gen(w * 7919 + 1);
+            size_t hits = 0;
+            for(size_t i=0; i<opsPerThread; i++) {
+                int k = static_cast<int>(keys(gen));
+                int op = static_cast<int>(gen() % 100);
+                if(op < 90) {
+                    hits += set.contains(k);
+                } else if(op < 95) {
+                    hits += set.insert(k);
+                } else {
+                    hits += set.erase(k);
+                }
+            }
+            sink.fetch_add(hits, std::memory_order_relaxed);
+        });
+    }
+    for(auto& w : workers) w.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return threads * opsPerThread / secs / 1e6;
+}
+
+template <typename Set>
+void prefill(Set& set) {
+    std::mt19937 gen(1);
+    for(int i=0; i<keySpace / 2; i++) set.insert(static_cast<int>(gen() % keySpace));
+}
+
+std::vector<int> evenBounds() {
+    std::vector<int> bounds;
+    for(size_t i=1; i<shardCount; i++) bounds.push_back(static_cast<int>(i * keySpace / shardCount));
+    return bounds;
+}
+
+int main(int argc, char** argv) {
+    int maxThreads = argc > 1 ? std::stoi(argv[1]) : 64;
+    Zipfian zipf(keySpace, 0.99);
+    auto uniform = [](std::mt19937_64& gen) { return gen() % keySpace; };
+    auto zipfian = [&zipf](std::mt19937_64& gen) { return zipf(gen); };
+
+    std::cout << "hardware threads: " << std::thread::hardware_concurrency() << "\n";
+    std::cout << "Mops/s, " << opsPerThread << " ops per thread, " << shardCount << " shards\n";
+    std::cout << std::setw(10) << "keys" << std::setw(8) << "threads" << std::setw(14) << "one lock"
+              << std::setw(14) << "static" << std::setw(14) << "rebalancing" << "\n";
+    for(int skewed=0; skewed<2; skewed++) {
+        for(int threads=1; threads<=maxThreads; threads *= 2) {
+            LockedAVL locked;
+            ShardedSet<int> fixed(evenBounds(), UINT64_MAX);
+            ShardedSet<int> moving(evenBounds(), 1 << 12);
+            prefill(locked);
+            prefill(fixed);
+            prefill(moving);
+            double a, b, c;
+            if(skewed) {
+                run(moving, threads, zipfian); // let the boundaries settle first
+                a = run(locked, threads, zipfian);
+                b = run(fixed, threads, zipfian);
+                c = run(moving, threads, zipfian);
+            } else {
+                a = run(locked, threads, uniform);
+                b = run(fixed, threads, uniform);
+                c = run(moving, threads, uniform);
+            }
+            std::cout << std::setw(10) << (skewed ? "zipfian" : "uniform") << std::setw(8) << threads << std::fixed << std::setprecision(2)
+                      << std::setw(14) << a << std::setw(14) << b << std::setw(14) << c << "\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+// Path-like string keys: prefix-compressed StringBTree vs BTree/BPlusTree of std::string
+// build: g++ -std=c++17 -O2 -march=native bench_StringBTree.cpp -o bench_StringBTree
+// Memory is the growth of glibc's in-use heap while the tree is built.
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <malloc.h>
+#include "B-Tree.h"
+#include "BPlusTree.h"
+#include "StringBTree.h"
+
+constexpr size_t numKeys = 1 << 20;
+constexpr size_t numLookups = 1 << 20;
+
+template <typename F>
+double seconds(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+size_t heapInUse() {
+    return mallinfo2().uordblks;
+}
+
+// e.g. https://cdn.example.com/assets/team12/project3/build/module41/file_907.js
+std::vector<std::string> makeKeys(std::mt19937& gen) {
+    const char* hosts[] = {"https://cdn.example.com/assets/", "https://api.example.com/v2/users/", "/home/build/workspace/src/"};
+    std::vector<std::string> keys;
+    for(size_t i=0; i<numKeys; i++) {
+        std::string k = hosts[gen() % 3];
+        k += "team" + std::to_string(gen() % 64) + "/project" + std::to_string(gen() % 16) + "/build/module";
+        k += std::to_string(gen() % 100) + "/file_" + std::to_string(gen() % 1000) + ".js";
+        keys.push_back(std::move(k));
+    }
+    return keys;
+}
+
+template <typename Tree, typename Insert, typename Lookup, typename Height>
+void run(const char* name, const std::vector<std::string>& keys, const std::vector<std::string>& probes, Insert insert, Lookup lookup, Height height) {
+    size_t before = heapInUse();
+    Tree* tree = new Tree();
+    double ins = seconds([&] {
+        for(const std::string& k : keys) insert(*tree, k);
+    });
+    size_t bytes = heapInUse() - before;
+    size_t hits = 0;
+    double look = seconds([&] {
+        for(const std::string& k : probes) hits += lookup(*tree, k);
+    });
+    std::cout << std::setw(22) << name << std::fixed << std::setprecision(1)
+              << std::setw(10) << bytes / double(1 << 20) << std::setw(10) << double(bytes) / keys.size()
+              << std::setw(8) << height(*tree) << std::setprecision(2)
+              << std::setw(12) << keys.size() / ins / 1e6 << std::setw(12) << probes.size() / look / 1e6
+              << std::setw(10) << hits << "\n";
+    delete tree;
+}
+
+int main() {
+    std::mt19937 gen(42);
+    std::vector<std::string> keys = makeKeys(gen);
+    std::vector<std::string> probes;
+    for(size_t i=0; i<numLookups; i++) {
+        probes.push_back((i % 2) ? keys[gen() % keys.size()] : keys[gen() % keys.size()] + "x");
+    }
+    size_t raw = 0;
+    for(const std::string& k : keys) raw += k.size();
+
+    std::cout << numKeys << " random path keys (" << raw / keys.size() << " chars on average), " << numLookups << " lookups (half hits)\n";
+    std::cout << std::setw(22) << "tree" << std::setw(10) << "MiB" << std::setw(10) << "B/key" << std::setw(8) << "height"
+              << std::setw(12) << "ins Mops/s" << std::setw(12) << "look Mops/s" << std::setw(10) << "hits" << "\n";
+    run<BTree<std::string, 16>>("BTree<string, 16>", keys, probes,
+        [](auto& t, const std::string& k) { if(!t.search(k).first) t.insert(k); },
+        [](auto& t, const std::string& k) { return t.search(k).first != nullptr; },
+        [](auto& t) { return t.stats().height; });
+    run<BPlusTree<std::string, 16>>("BPlusTree<string, 16>", keys, probes,
+        [](auto& t, const std::string& k) { t.insert(k); },
+        [](auto& t, const std::string& k) { return t.contains(k); },
+        [](auto&) { return std::string("-"); });
+    run<StringBTree<4096>>("StringBTree<4096>", keys, probes,
+        [](auto& t, const std::string& k) { t.insert(k); },
+        [](auto& t, const std::string& k) { return t.contains(k); },
+        [](auto& t) { return t.height(); });
+    run<StringBTree<1024>>("StringBTree<1024>", keys, probes,
+        [](auto& t, const std::string& k) { t.insert(k); },
+        [](auto& t, const std::string& k) { return t.contains(k); },
+        [](auto& t) { return t.height(); });
+    return 0;
+}
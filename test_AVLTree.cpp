@@ -1,6 +1,154 @@
 #include <iostream>
+#include <string_view>
 #include "AVLTree.h"
 
+void testOrderStatistics() {
+    AVLTree<int> tree;
+    for(int val = 100; val > 0; val -= 3) { // 100, 97, ..., 1 - descending pushes rotate at every level
+        tree.push(std::move(val));
+    }
+    std::cout << "size: " << tree.size() << "\n";
+    std::cout << "select(0): " << *tree.select(0) << ", select(10): " << *tree.select(10)
+              << ", select(33): " << *tree.select(33) << "\n";
+    std::cout << "select(34) is " << (tree.select(34) ? "found" : "null") << "\n";
+    std::cout << "rank(1): " << tree.rank(1) << ", rank(50): " << tree.rank(50)
+              << ", rank(52): " << tree.rank(52) << ", rank(1000): " << tree.rank(1000) << "\n";
+    std::cout << "count_range(10, 40): " << tree.count_range(10, 40)
+              << ", count_range(40, 10): " << tree.count_range(40, 10) << "\n";
+
+    bool ok = true;
+    for(size_t k=0; k<static_cast<size_t>(tree.size()); k++) {
+        ok = ok && tree.rank(*tree.select(k)) == k;
+    }
+    AVLTree<int> copy(tree);
+    ok = ok && copy.count_range(0, 100) == 34;
+    std::cout << "rank(select(k)) == k for every k, copy keeps counts: " << (ok ? "ok" : "FAILED") << "\n";
+}
+
+AVLTree<int> multiplesOf(int step, int n) {
+    AVLTree<int> tree;
+    for(int i=0; i<n; i++) {
+        tree.push(i * step);
+    }
+    return tree;
+}
+
+bool holds(const AVLTree<int>& tree, const std::vector<int>& expected) {
+    if(static_cast<size_t>(tree.size()) != expected.size()) {
+        return false;
+    }
+    for(size_t k=0; k<expected.size(); k++) {
+        if(*tree.select(k) != expected[k]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void testSetOperations() {
+    // join and split on small trees of very different heights
+    AVLTree<int> low, high;
+    for(int val : {1, 2, 3, 4, 5, 6, 7, 8, 9, 10}) {
+        low.push(std::move(val));
+    }
+    high.push(100);
+    low.join(std::move(high));
+    std::cout << "joined:";
+    low.print();
+    AVLTree<int> upper = low.split(6);
+    std::cout << "split at 6 - below:";
+    low.print();
+    std::cout << "at or above:";
+    upper.print();
+
+    // 30000 keys each, above the sequential cutoff, so the halves run on the pool
+    const int n = 30000;
+    std::vector<int> unionKeys, interKeys, diffKeys;
+    for(int i=0; i<3*n; i++) {
+        bool two = i % 2 == 0 && i < 2*n, three = i % 3 == 0;
+        if(two || three) unionKeys.push_back(i);
+        if(two && three) interKeys.push_back(i);
+        if(two && !three) diffKeys.push_back(i);
+    }
+    ThreadPool pool(4);
+    AVLTree<int> twos = multiplesOf(2, n), threes = multiplesOf(3, n);
+    AVLTree<int> u = set_union(twos, threes, &pool); // copies - twos and threes are reused below
+    AVLTree<int> i = set_intersection(twos, threes, &pool);
+    AVLTree<int> d = set_difference(std::move(twos), std::move(threes), &pool);
+    std::cout << "union " << u.size() << ", intersection " << i.size() << ", difference " << d.size()
+              << ", operands left empty: " << (twos.empty() && threes.empty()) << "\n";
+    std::cout << "set operations match: " << (holds(u, unionKeys) && holds(i, interKeys) && holds(d, diffKeys) ? "ok" : "FAILED") << "\n";
+}
+
+void testBuild() {
+    std::vector<int> sorted = {1, 2, 2, 3, 5, 8, 13, 21, 34, 34, 55, 89};
+    AVLTree<int> tree(sorted.begin(), sorted.end()); // no std::move needed - the vector is untouched
+    std::cout << "built from sorted (" << tree.size() << " distinct keys):";
+    tree.print();
+
+    std::vector<int> shuffled;
+    for(int i=0; i<100000; i++) {
+        shuffled.push_back((i * 7919) % 50000); // every key twice, scattered
+    }
+    ThreadPool pool(4);
+    AVLTree<int> big(shuffled.begin(), shuffled.end(), unsorted, &pool);
+    bool ok = big.size() == 50000;
+    for(int k=0; k<50000; k += 997) {
+        ok = ok && *big.select(k) == k;
+    }
+    std::cout << "built from unsorted: " << big.size() << " keys " << (ok ? "ok" : "FAILED") << "\n";
+
+    std::vector<int> unordered = {1, 3, 2};
+    try {
+        AVLTree<int> bad(unordered.begin(), unordered.end());
+    } catch(const std::exception& e) {
+        std::cout << e.what() << "\n";
+    }
+}
+
+void testEraseAndEmplace() {
+    std::vector<int> sorted = {0, 1, 5, 6, 12, 23, 25, 32, 90};
+    AVLTree<int> tree(sorted.begin(), sorted.end());
+    const int* kept = tree.find(90);
+    tree.erase(25); // two children
+    tree.erase(0); // leaf
+    tree.erase(1); // left side empties - rotates at the root
+    std::cout << "after erasing 25, 0, 1:";
+    tree.print();
+    std::cout << "erase 25 again? " << tree.erase(25) << ", size " << tree.size()
+              << ", pointer to 90 still valid: " << (tree.find(90) == kept) << "\n";
+
+    AVLTree<std::string> words;
+    auto [key, inserted] = words.emplace(3, 'z'); // std::string(3, 'z') built in its node
+    words.push("apple");
+    words.push(std::string("kiwi"));
+    std::cout << "emplaced " << *key << " " << inserted << ", again " << words.emplace("zzz").second << "\n";
+    std::string_view probe = "kiwi"; // no temporary std::string for lookups
+    std::cout << "contains kiwi " << words.contains(probe) << ", erase kiwi " << words.erase(probe)
+              << ", contains kiwi " << words.contains("kiwi") << ", size " << words.size() << "\n";
+}
+
+void testIterators() {
+    std::vector<int> sorted = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29};
+    AVLTree<int> primes(sorted.begin(), sorted.end());
+    std::cout << "in order:";
+    for(int p : primes) {
+        std::cout << " " << p;
+    }
+    std::cout << "\nbackwards:";
+    for(auto it = primes.end(); it != primes.begin(); ) {
+        std::cout << " " << *--it;
+    }
+    std::cout << "\n[6, 20]:";
+    for(auto it = primes.lower_bound(6); it != primes.upper_bound(20); ++it) {
+        std::cout << " " << *it;
+    }
+    auto [first, last] = primes.equal_range(13);
+    std::cout << "\nequal_range(13) holds " << std::distance(first, last) << ", equal_range(14) holds "
+              << std::distance(primes.equal_range(14).first, primes.equal_range(14).second)
+              << ", lower_bound(30) is end: " << (primes.lower_bound(30) == primes.end()) << "\n";
+}
+
 int main() {
     AVLTree<int> tree;
     std::vector<int> vals = {5, 6, 1, 0, 32, 12, 23, 25, 90};
@@ -9,5 +157,10 @@ int main() {
         std::cout << "post push\n";
         tree.print();
     }
+    testOrderStatistics();
+    testSetOperations();
+    testBuild();
+    testEraseAndEmplace();
+    testIterators();
     return 0;
-}
\ No newline at end of file
+}
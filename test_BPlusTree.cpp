@@ -0,0 +1,37 @@
+#include <iostream>
+#include <vector>
+#include "BPlusTree.h"
+
+int main() {
+    BPlusTree<char, 2> tree;
+    // Source: CLRS 4th Ed. pg. 511 (same sequence as the B-Tree test)
+    std::vector<char> seq = {'F', 'S', 'Q', 'K', 'C', 'L', 'H', 'T', 'V', 'W', 'M', 'R', 'N', 'P', 'A', 'B', 'X', 'Y', 'D', 'Z', 'E'};
+    for(char c : seq) {
+        tree.insert(c);
+    }
+    tree.printBPlusTree();
+
+    std::cout << "in order: ";
+    for(char c : tree) {
+        std::cout << c << " ";
+    }
+    std::cout << "\nreverse: ";
+    for(auto it = tree.end(); it != tree.begin();) {
+        std::cout << *--it << " ";
+    }
+    std::cout << "\nrange [G, R): ";
+    tree.scan('G', 'R', [](char c) { std::cout << c << " "; });
+    std::cout << "\nupper_bound(M) onwards: ";
+    for(auto it = tree.upper_bound('M'); it != tree.end(); ++it) {
+        std::cout << *it << " ";
+    }
+    std::cout << "\n";
+
+    for(char c : {'P', 'Y', 'M', 'W', 'Q', 'Z'}) {
+        tree.remove(c);
+    }
+    std::cout << "after removing P Y M W Q Z\n";
+    tree.printBPlusTree();
+    std::cout << "contains M? " << (tree.contains('M') ? "yes" : "no") << ", size " << tree.size() << "\n";
+    return 0;
+}
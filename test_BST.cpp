@@ -3,5 +3,19 @@
 
 int main() {
     BST<int> tree;
-    
-}   
\ No newline at end of file
+    for(int val : {8, 3, 10, 1, 6, 14, 4, 7, 13}) {
+        tree.insert(val);
+    }
+    std::cout << "min " << tree.minVal() << " max " << tree.maxVal() << "\n";
+    tree.deleteNode(3);
+    tree.deleteNode(42); // absent - ignored
+    std::cout << "3 found after delete: " << (tree.search(3) != nullptr) << "\n";
+    std::cout << "valid: " << tree.validate() << "\n";
+
+    BST<int, HeapAllocator> heapTree; // one allocation per node instead of slabs
+    for(int i=0; i<1000; i++) {
+        heapTree.insert(i); // degenerates into a chain, still freed without recursion
+    }
+    std::cout << "chain max " << heapTree.maxVal() << "\n";
+    return 0;
+}
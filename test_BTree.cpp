@@ -2,8 +2,8 @@
 #include "B-Tree.h"
 #include <stdexcept>
 
-template<typename T>
-void printTreeFormat(BTree<T> tree) {
+template<typename T, size_t Degree>
+void printTreeFormat(BTree<T, Degree>& tree) {
     // print a given tree + add message for extra space!
     tree.printBTree();
     std::cout << "next seq\n";
@@ -99,6 +99,101 @@ BTree<char> testCase3() {
     return tree;
 }
 
+// Same sequence as testCase3 on the fixed-capacity (inline array) nodes
+BTree<char, 2> testCase4() {
+    BTree<char, 2> tree;
+    std::vector<char> seq = {'Q', 'V', 'Z', 'L', 'N', 'S', 'E', 'P', 'O', 'M', 'F'};
+    for(char c : seq) {
+        tree.insert(c);
+    }
+    printTreeFormat(tree);
+    for(char c : {'V', 'N', 'Z', 'O', 'L', 'E'}) {
+        tree.remove(c);
+        printTreeFormat(tree);
+    }
+    return tree;
+}
+
+// Bottom-up build from a sorted stream instead of one insert per key
+void testBulkLoad() {
+    std::vector<char> sorted = {'A', 'B', 'C', 'D', 'E', 'F', 'H', 'K', 'L', 'M', 'N', 'P', 'Q', 'R', 'S', 'T', 'V', 'W', 'X', 'Y', 'Z'};
+    BTree<char> tree(2);
+    tree.bulk_load(sorted.begin(), sorted.end());
+    std::cout << "bulk loaded, full pages\n";
+    tree.printBTree();
+
+    BTree<char, 3> halfFull;
+    halfFull.bulk_load([&](auto&& emit) {
+        for(char c : sorted) emit(c);
+    }, 0.5);
+    std::cout << "bulk loaded from a callback, half-full pages\n";
+    halfFull.printBTree();
+    halfFull.insert('G');
+    halfFull.remove('M');
+    halfFull.printBTree();
+}
+
+// Snapshots share pages with the tree - writes after the snapshot copy their path only
+void testSnapshot() {
+    BTree<char> tree = testCase2();
+    BTree<char> snap = tree.snapshot();
+    tree.remove('M');
+    tree.insert('G');
+    std::cout << "tree after removing M, inserting G\n";
+    tree.printBTree();
+    std::cout << "snapshot taken before\n";
+    snap.printBTree();
+}
+
+// Sorted batches share one descent per leaf and rebalance each page once
+void testBatch() {
+    std::vector<char> sorted = {'A', 'B', 'C', 'D', 'E', 'F', 'H', 'K', 'L', 'M', 'N', 'P', 'Q', 'R', 'S', 'T', 'V', 'W', 'X', 'Y', 'Z'};
+    BTree<char> tree(2);
+    tree.insert_batch(sorted.begin(), sorted.end());
+    std::cout << "batch inserted\n";
+    tree.printBTree();
+    std::vector<char> gone = {'B', 'C', 'D', 'G', 'M', 'N', 'P', 'Q'}; // G is absent
+    tree.remove_batch(gone.begin(), gone.end());
+    std::cout << "batch removed B C D G M N P Q\n";
+    tree.printBTree();
+
+    BTree<char, 2> fixed;
+    fixed.insert_batch(sorted.begin(), sorted.end());
+    fixed.remove_batch(gone.begin(), gone.end());
+    fixed.printBTree();
+    std::vector<char> unsorted = {'Z', 'A'};
+    try {
+        fixed.insert_batch(unsorted.begin(), unsorted.end());
+    } catch(const std::exception& e) {
+        std::cout << e.what() << "\n";
+    }
+}
+
+// Counting stats policy - shape and events after an insert run and a delete storm
+void testStats() {
+    BTree<int, 3, SlabAllocator, CountingStats> tree;
+    for(int i=0; i<1000; i++) {
+        tree.insert(i);
+    }
+    for(int i=0; i<1000; i+=4) {
+        tree.search(i);
+    }
+    std::cout << "stats after 1000 sorted inserts + 250 lookups\n";
+    tree.stats().print();
+    tree.resetStats();
+    for(int i=0; i<1000; i++) {
+        if(i % 10) tree.remove(i);
+    }
+    std::cout << "stats after removing 90% of keys\n";
+    tree.stats().print();
+
+    BTree<int> dynamicTree(3); // NoStats - shape only, counters stay zero
+    for(int i=0; i<100; i++) {
+        dynamicTree.insert(i);
+    }
+    dynamicTree.stats().print();
+}
+
 int main() {
     std::cout << "NOTE: this follows pre-emptive merge + split once at max size\n";
     std::cout << "first tree\n";
@@ -115,5 +210,14 @@ int main() {
     std::cout << "3rd tree\n";
     BTree<char> tree3 = testCase3();
 
+    std::cout << "4th tree (fixed degree, " << sizeof(InlineBTreeNode<char, 2>) << " byte nodes)\n";
+    BTree<char, 2> tree4 = testCase4();
+    std::cout << "searching for Q in 4th tree: " << (tree4.search('Q').first ? "found" : "missing") << "\n";
+
+    testBulkLoad();
+    testSnapshot();
+    testBatch();
+    testStats();
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,47 @@
+#include <iostream>
+#include <set>
+#include <random>
+#include "BufferedBTree.h"
+
+int main() {
+    BufferedBTree<char, 2, 4, 4> tree; // tiny buffers so the CLRS sequence spills to the leaves
+    for(char c : std::string("FSQKCLHTVWMRNPABXYDZE")) {
+        tree.insert(c);
+    }
+    tree.printBTree();
+    std::cout << "contains K: " << tree.contains('K') << " contains G: " << tree.contains('G') << "\n";
+    for(char c : std::string("FMGDB")) {
+        tree.remove(c); // G is absent - the message is dropped at the leaf
+    }
+    std::cout << "contains F after remove: " << tree.contains('F') << "\n";
+    tree.flush();
+    std::cout << "after flush:";
+    tree.printBTree();
+
+    // random workload checked against std::set
+    BufferedBTree<int, 3, 16, 8> big;
+    std::set<int> ref;
+    std::mt19937 gen(7);
+    size_t mismatches = 0;
+    for(int i=0; i<200000; i++) {
+        int k = gen() % 5000;
+        if(gen() % 3) {
+            big.insert(k);
+            ref.insert(k);
+        } else {
+            big.remove(k);
+            ref.erase(k);
+        }
+        if(i % 1000 == 0) {
+            for(int q=0; q<5000; q+=37) {
+                mismatches += big.contains(q) != (ref.count(q) > 0);
+            }
+        }
+    }
+    big.flush();
+    for(int q=0; q<5000; q++) {
+        mismatches += big.contains(q) != (ref.count(q) > 0);
+    }
+    std::cout << "mismatches vs std::set: " << mismatches << "\n";
+    return 0;
+}
@@ -0,0 +1,35 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include "CompactAVLTree.h"
+
+int main() {
+    CompactAVLTree<int> tree;
+    std::vector<int> vals = {5, 6, 1, 0, 32, 12, 23, 25, 90};
+    for(int val : vals) {
+        tree.push(val);
+    }
+    tree.print();
+    std::cout << "size " << tree.size() << ", height " << tree.height() << ", min " << *tree.min() << ", max " << *tree.max() << "\n";
+    std::cout << "push 12 again? " << tree.push(12) << "\n";
+
+    tree.erase(5); // two children - replaced by its successor
+    tree.erase(0);
+    tree.erase(1); // left side empties, forcing a rotation
+    std::cout << "after erasing 5, 0, 1";
+    tree.print();
+    std::cout << "erase 5 again? " << tree.erase(5) << ", contains 6? " << tree.contains(6) << ", contains 5? " << tree.contains(5) << "\n";
+
+    size_t before = tree.memoryUsage();
+    tree.push(2);
+    tree.push(3);
+    std::cout << "freed slots reused: " << (tree.memoryUsage() == before ? "yes" : "no") << "\n";
+
+    CompactAVLTree<std::string> words;
+    for(const char* w : {"pear", "apple", "fig", "kiwi", "banana"}) {
+        words.push(w);
+    }
+    words.erase("fig");
+    words.print();
+    return 0;
+}
@@ -0,0 +1,43 @@
+#include <iostream>
+#include <vector>
+#include <thread>
+#include "ConcurrentBTree.h"
+
+int main() {
+    ConcurrentBTree<int, 3> tree;
+    const int numThreads = 4;
+    const int perThread = 1000;
+    // each writer owns the keys congruent to its id, readers run alongside
+    std::vector<std::thread> threads;
+    for(int w = 0; w < numThreads; w++) {
+        threads.emplace_back([&tree, w] {
+            for(int i = 0; i < perThread; i++) {
+                tree.insert(i * numThreads + w);
+            }
+            for(int i = 0; i < perThread; i += 2) {
+                tree.remove(i * numThreads + w);
+            }
+        });
+    }
+    threads.emplace_back([&tree] {
+        int hits = 0;
+        for(int i = 0; i < numThreads * perThread; i++) {
+            hits += tree.contains(i);
+        }
+        std::cout << "concurrent reader saw " << hits << " keys\n";
+    });
+    for(auto& th : threads) {
+        th.join();
+    }
+
+    int missing = 0, stale = 0;
+    for(int i = 0; i < numThreads * perThread; i++) {
+        bool expected = (i / numThreads) % 2 == 1;
+        if(tree.contains(i) != expected) {
+            expected ? missing++ : stale++;
+        }
+    }
+    std::cout << "missing " << missing << ", not removed " << stale << "\n";
+    std::cout << "insert duplicate 7: " << tree.insert(7) << ", remove absent 0: " << tree.remove(0) << "\n";
+    return 0;
+}
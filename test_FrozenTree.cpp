@@ -0,0 +1,68 @@
+#include <iostream>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "BST.h"
+#include "AVLTree.h"
+#include "Red-Black-Tree.h"
+#include "B-Tree.h"
+#include "FrozenTree.h"
+
+int main() {
+    BST<int> tree;
+    for(int val : {8, 3, 10, 1, 6, 14, 4, 7, 13, 6}) {
+        tree.insert(val);
+    }
+    FrozenTree<int> frozen = tree.freeze();
+    std::cout << "frozen " << frozen.size() << " keys; contains 6? " << frozen.contains(6)
+              << ", contains 5? " << frozen.contains(5) << "\n";
+    for(int q : {0, 5, 6, 9, 14, 15}) {
+        const int* lb = frozen.lower_bound(q);
+        std::cout << "lower_bound(" << q << ") = " << (lb ? std::to_string(*lb) : "none") << "\n";
+    }
+
+    const std::string path = "test_frozen_tree.bin";
+    std::remove(path.c_str());
+    frozen.save(path);
+    {
+        FrozenTree<int> mapped = FrozenTree<int>::map(path); // read-only mmap, nothing copied
+        std::cout << "mapped " << mapped.mapped() << ", " << mapped.size() << " keys; contains 13? " << mapped.contains(13)
+                  << ", lower_bound(11) = " << *mapped.lower_bound(11) << "\n";
+    }
+    try {
+        FrozenTree<long long>::map(path);
+    } catch(const std::runtime_error& e) {
+        std::cout << e.what() << "\n";
+    }
+    std::remove(path.c_str());
+
+    RBTree<std::string> words;
+    for(const char* w : {"pear", "apple", "fig", "kiwi", "banana"}) {
+        words.insert(w);
+    }
+    FrozenTree<std::string> frozenWords = words.freeze();
+    std::cout << "first word from \"c\": " << *frozenWords.lower_bound("c") << "\n";
+
+    AVLTree<int> avl;
+    for(int i=0; i<1000; i++) {
+        avl.push(i * 3);
+    }
+    FrozenTree<int> frozenAvl = avl.freeze();
+    std::cout << "AVL frozen " << frozenAvl.size() << " keys; contains 999? " << frozenAvl.contains(999)
+              << ", contains 1000? " << frozenAvl.contains(1000) << "\n";
+
+    BTree<int, 4> btree;
+    for(int i=0; i<500; i++) {
+        btree.insert(i * 7 % 500); // every key once, out of order
+    }
+    FrozenTree<int> frozenBtree = btree.freeze();
+    std::cout << "BTree frozen " << frozenBtree.size() << " keys; lower_bound(250) = " << *frozenBtree.lower_bound(250) << "\n";
+
+    std::vector<int> unsortedKeys = {3, 1, 2};
+    try {
+        FrozenTree<int> bad(unsortedKeys.begin(), unsortedKeys.end());
+    } catch(const std::invalid_argument& e) {
+        std::cout << e.what() << "\n";
+    }
+    return 0;
+}
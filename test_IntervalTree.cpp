@@ -0,0 +1,37 @@
+#include <iostream>
+#include <string>
+#include "Red-Black-Tree.h"
+
+int main() {
+    RBTree<Interval<int>> reservations; // [start, end] in minutes
+    for(Interval<int> r : {Interval<int>{540, 600}, {555, 570}, {600, 660}, {720, 780}, {480, 1020}, {900, 930}, {610, 615}}) {
+        reservations.insert(r);
+    }
+    auto show = [](const Interval<int>& r) { std::cout << "[" << r.low << ", " << r.high << "] "; };
+
+    std::cout << "all: ";
+    for(const Interval<int>& r : reservations) {
+        show(r);
+    }
+    std::cout << "\nat 600: ";
+    reservations.overlaps(600, show); // endpoints are inclusive
+    std::cout << "\noverlapping [700, 905]: ";
+    reservations.overlaps(Interval<int>{700, 905}, show);
+
+    reservations.remove(Interval<int>{480, 1020}); // the long one covered everything
+    std::cout << "\nafter removing [480, 1020], at 800: ";
+    size_t hits = 0;
+    reservations.overlaps(800, [&](const Interval<int>&) { hits++; });
+    std::cout << hits << " hits, at 612: ";
+    reservations.overlaps(612, show);
+    std::cout << "\n";
+
+    RBTree<Interval<std::string>> ranges; // any ordered endpoint type
+    ranges.insert({"apple", "fig"});
+    ranges.insert({"kiwi", "pear"});
+    ranges.insert({"banana", "lime"});
+    std::cout << "ranges containing \"grape\": ";
+    ranges.overlaps(std::string("grape"), [](const Interval<std::string>& r) { std::cout << r.low << ".." << r.high << " "; });
+    std::cout << "\n";
+    return 0;
+}
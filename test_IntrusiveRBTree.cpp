@@ -0,0 +1,58 @@
+#include <iostream>
+#include <vector>
+#include "IntrusiveRBTree.h"
+
+struct Session {
+    int id;
+    const char* user;
+    rb_hook byId{};
+    bool operator<(const Session& rhs) const { return id < rhs.id; }
+};
+bool operator<(const Session& s, int id) { return s.id < id; } // lets find/lower_bound take a bare id
+bool operator<(int id, const Session& s) { return id < s.id; }
+
+int main() {
+    std::vector<Session> pool = {{5, "eve"}, {6, "bob"}, {1, "ann"}, {0, "joe"}, {32, "kim"},
+                                 {12, "lee"}, {23, "max"}, {25, "ned"}, {90, "oli"}};
+    IntrusiveRBTree<Session, &Session::byId> sessions; // declared after pool - detaches before the objects go
+    for(Session& s : pool) {
+        sessions.insert(s);
+    }
+    for(const Session& s : sessions) {
+        std::cout << s.id << ":" << s.user << " ";
+    }
+    std::cout << "\nsize " << sessions.size() << "\n";
+
+    Session dup{12, "dup"};
+    auto [holder, inserted] = sessions.insert_unique(dup);
+    std::cout << "insert_unique 12: " << inserted << ", held by " << holder->user << ", dup linked? " << dup.byId.linked() << "\n";
+
+    sessions.erase(pool[0]); // 5 - two children
+    sessions.erase(pool[3]); // 0 - a leaf
+    sessions.erase(pool[1]); // 6
+    std::cout << "after erasing 5, 0, 6: ";
+    for(const Session& s : sessions) {
+        std::cout << s.id << " ";
+    }
+    std::cout << "\n5 linked? " << pool[0].byId.linked() << ", find 5: " << (sessions.find(5) ? "yes" : "no")
+              << ", find 23: " << sessions.find(23)->user << "\n";
+
+    std::cout << "ids in [10, 30]: ";
+    for(auto it = sessions.lower_bound(10); it != sessions.end() && !(30 < *it); ++it) {
+        std::cout << it->id << " ";
+    }
+    std::cout << "\nbackwards: ";
+    for(auto it = sessions.end(); it != sessions.begin(); ) {
+        std::cout << (--it)->id << " ";
+    }
+    std::cout << "\n";
+
+    try {
+        sessions.insert(pool[2]); // 1 is still in the tree
+    } catch(const std::invalid_argument& e) {
+        std::cout << e.what() << "\n";
+    }
+    sessions.insert(pool[0]); // erased objects can go back in
+    std::cout << "5 back in? " << (sessions.find(5) == &pool[0] ? "yes" : "no") << "\n";
+    return 0;
+}
@@ -0,0 +1,42 @@
+#include <iostream>
+#include <vector>
+#include <cstdio>
+#include "PagedBTree.h"
+
+int main() {
+    const std::string path = "test_paged_btree.db";
+    std::remove(path.c_str());
+    std::vector<int> seq = {10, 20, 5, 6, 12, 30, 7, 17, 3, 1, 25, 40, 45, 2, 8, 9, 11, 50};
+    {
+        // 64 byte pages -> degree 3, and a tiny pool to force evictions
+        PagedBTree<int, 64> tree(path, 8);
+        for(int v : seq) {
+            tree.insert(v);
+        }
+        tree.printBTree();
+        tree.remove(12);
+        tree.remove(20);
+        std::cout << "after removing 12 and 20\n";
+        tree.printBTree();
+        std::cout << tree.pageCount() << " pages\n";
+    } // flushed on close
+
+    {
+        PagedBTree<int, 64> reopened(path);
+        std::cout << "reopened - contains 30? " << reopened.contains(30) << ", contains 12? " << reopened.contains(12) << "\n";
+        reopened.insert(12);
+    }
+
+    {
+        PagedBTree<int, 64> mapped(path, 0, true); // read-only mmap
+        std::cout << "mapped - contains 12? " << mapped.contains(12) << "\n";
+        mapped.printBTree();
+        try {
+            mapped.insert(100);
+        } catch(const std::exception& e) {
+            std::cout << e.what() << "\n";
+        }
+    }
+    std::remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "PersistentRBTree.h"
+
+template <typename T>
+void show(const char* name, const PersistentRBTree<T>& v) {
+    std::cout << name << " (" << v.size() << "): ";
+    v.forEach([](const T& key) { std::cout << key << " "; });
+    std::cout << "\n";
+}
+
+int main() {
+    PersistentRBTree<int> v0;
+    PersistentRBTree<int> v1 = v0;
+    for(int val : {5, 6, 1, 0, 32, 12, 23, 25, 90}) {
+        v1 = v1.insert(val);
+    }
+    PersistentRBTree<int> v2 = v1.remove(5).remove(0).insert(7);
+    PersistentRBTree<int> v3 = v2.remove(1000); // absent - the same version
+    show("v0", v0);
+    show("v1", v1); // untouched by the updates that built v2
+    show("v2", v2);
+    std::cout << "v1 has 5? " << v1.contains(5) << ", v2 has 5? " << v2.contains(5)
+              << ", v3 min " << *v3.min() << ", max " << *v3.max() << "\n";
+
+    // a routing table: one writer publishes versions, readers search snapshots without locks
+    VersionedRBTree<std::string> routes;
+    routes.update([](const PersistentRBTree<std::string>& v) { return v.insert("10.0.0.0/8").insert("192.168.0.0/16"); });
+    PersistentRBTree<std::string> before = routes.snapshot();
+
+    std::vector<std::thread> readers;
+    std::vector<size_t> seen(4, 0);
+    for(size_t t=0; t<seen.size(); t++) {
+        readers.emplace_back([&, t] {
+            for(int i=0; i<1000; i++) {
+                PersistentRBTree<std::string> snap = routes.snapshot();
+                seen[t] += snap.contains("10.0.0.0/8"); // present in every version
+            }
+        });
+    }
+    for(int i=0; i<100; i++) {
+        routes.update([i](const PersistentRBTree<std::string>& v) { return v.insert("172.16." + std::to_string(i) + ".0/24"); });
+    }
+    routes.update([](const PersistentRBTree<std::string>& v) { return v.remove("192.168.0.0/16"); });
+    for(std::thread& r : readers) {
+        r.join();
+    }
+    std::cout << "every reader found 10.0.0.0/8 each time? " << (seen == std::vector<size_t>(4, 1000) ? "yes" : "no") << "\n";
+    std::cout << "snapshot taken before the updates: " << before.size() << " routes, latest: " << routes.snapshot().size()
+              << ", 192.168.0.0/16 in old/new? " << before.contains("192.168.0.0/16") << "/" << routes.snapshot().contains("192.168.0.0/16") << "\n";
+    return 0;
+}
@@ -11,6 +11,16 @@ int main() {
             std::cin >> val;
             tree.insert(val);
         }
+        else if(input == "a") { // append at the maximum - falls back to insert when val is smaller
+            int val;
+            std::cin >> val;
+            tree.append_max(val);
+        }
+        else if(input == "h") { // insert val just before the node holding hint
+            int hint, val;
+            std::cin >> hint >> val;
+            tree.insert_hint(tree.search(hint), val);
+        }
         else if(input == "p") {
             tree.print();
         }
@@ -19,6 +29,20 @@ int main() {
             std::cin >> val;
             tree.remove(val);
         }
+        else if(input == "s") { // in-order scan
+            for(int key : tree) {
+                std::cout << key << " ";
+            }
+            std::cout << "\n";
+        }
+        else if(input == "r") { // keys in [lo, hi]
+            int lo, hi;
+            std::cin >> lo >> hi;
+            for(auto it = tree.lower_bound(lo); it != tree.end() && !(hi < *it); ++it) {
+                std::cout << *it << " ";
+            }
+            std::cout << "\n";
+        }
         else {
             break;
         }
@@ -0,0 +1,50 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "ShardedSet.h"
+
+int main() {
+    ShardedSet<int> set({100, 200, 300}, 256); // shards [.., 100) [100, 200) [200, 300) [300, ..)
+    for(int i=0; i<400; i += 3) {
+        set.insert(i);
+    }
+    std::cout << "size " << set.size() << ", insert 3 again? " << set.insert(3) << ", contains 99? " << set.contains(99)
+              << ", erase 99? " << set.erase(99) << ", contains 99? " << set.contains(99) << "\n";
+
+    std::cout << "scan [190, 215] across a boundary: ";
+    set.scan(190, 215, [](int key) { std::cout << key << " "; });
+    std::cout << "\nshard sizes:";
+    for(size_t s : set.shardSizes()) {
+        std::cout << " " << s;
+    }
+
+    // four threads hammer keys below 50 - the first shard gets nearly all the work and should narrow
+    std::vector<std::thread> threads;
+    for(int t=0; t<4; t++) {
+        threads.emplace_back([&set, t] {
+            for(int i=0; i<20000; i++) {
+                int key = (i * 7 + t) % 50;
+                if(i % 2 == 0) {
+                    set.contains(key);
+                } else if(i % 4 == 1) {
+                    set.erase(key);
+                } else {
+                    set.insert(key);
+                }
+            }
+        });
+    }
+    for(std::thread& t : threads) {
+        t.join();
+    }
+    std::cout << "\nafter a hot spot below 50, shard sizes:";
+    for(size_t s : set.shardSizes()) {
+        std::cout << " " << s;
+    }
+    size_t count = 0;
+    int last = -1;
+    bool ordered = true;
+    set.scan(-1000, 1000, [&](int key) { ordered &= last < key; last = key; count++; });
+    std::cout << "\nfull scan: " << count << " keys, in order? " << ordered << ", size() " << set.size() << "\n";
+    return 0;
+}
@@ -0,0 +1,38 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "StringBTree.h"
+
+int main() {
+    StringBTree<256> tree; // small pages so a few paths already split
+    std::vector<std::string> paths = {
+        "/usr/bin/env", "/usr/bin/gcc", "/usr/bin/g++", "/usr/lib/libc.so", "/usr/lib/libm.so",
+        "/usr/local/bin/cmake", "/usr/local/lib/libfmt.a", "/home/alice/notes.txt", "/home/alice/src/main.cpp",
+        "/home/bob/.bashrc", "/etc/hosts", "/etc/passwd", "/var/log/syslog", "/var/log/kern.log",
+        "/usr/share/man/man1/ls.1", "/usr/share/man/man1/cp.1", "/usr/include/stdio.h", "/usr/include/stdlib.h"
+    };
+    for(const std::string& p : paths) {
+        tree.insert(p);
+    }
+    std::cout << "duplicate insert: " << tree.insert("/etc/hosts") << "\n";
+    tree.printStringBTree();
+    std::cout << "size " << tree.size() << ", height " << tree.height() << "\n";
+
+    std::cout << "under /usr/bin/: ";
+    tree.scan("/usr/bin/", "/usr/bin0", [](std::string_view k) { std::cout << k << " "; });
+    std::cout << "\n";
+
+    for(const char* p : {"/usr/bin/gcc", "/usr/lib/libc.so", "/home/bob/.bashrc", "/nope"}) {
+        std::cout << "remove " << p << ": " << tree.remove(p) << "\n";
+    }
+    std::cout << "contains /usr/bin/g++: " << tree.contains("/usr/bin/g++")
+              << ", contains /usr/bin/gcc: " << tree.contains("/usr/bin/gcc") << "\n";
+    tree.printStringBTree();
+
+    try {
+        tree.insert(std::string(100, 'x'));
+    } catch(const std::exception& e) {
+        std::cout << e.what() << "\n";
+    }
+    return 0;
+}